@@ -0,0 +1,46 @@
+/* arena.c - alocador sequencial sobre um bloco único */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+#define ALINHAMENTO 16
+
+void inicializarArena(Arena *arena, void *buffer, size_t tam) {
+    arena->memoria = (char*)buffer;
+    arena->capacidade = buffer ? tam : 0;
+    arena->usado = 0;
+    arena->esgotada = 0;
+    arena->propria = 0;
+}
+
+int criarArena(Arena *arena, size_t tam) {
+    void *bloco = malloc(tam);
+    inicializarArena(arena, bloco, tam);
+    if (!bloco) return -1;
+    arena->propria = 1;
+    return 0;
+}
+
+void liberarArena(Arena *arena) {
+    if (!arena) return;
+    if (arena->propria) free(arena->memoria);
+    inicializarArena(arena, NULL, 0);
+}
+
+void reiniciarArena(Arena *arena) {
+    arena->usado = 0;
+    arena->esgotada = 0;
+}
+
+void *alocarArena(Arena *arena, size_t tam) {
+    uintptr_t base = (uintptr_t)arena->memoria;
+    size_t ini = (size_t)(((base + arena->usado + ALINHAMENTO - 1) & ~(uintptr_t)(ALINHAMENTO - 1)) - base);
+    if (ini > arena->capacidade || tam > arena->capacidade - ini) {
+        arena->esgotada = 1;
+        return NULL;
+    }
+    arena->usado = ini + tam;
+    return arena->memoria + ini;
+}
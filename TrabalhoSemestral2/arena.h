@@ -0,0 +1,24 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <stddef.h>
+
+/*
+ * Arena de memória: alocações sequenciais num bloco único, liberadas todas
+ * de uma vez por reiniciarArena. O bloco pode ser do chamador
+ * (inicializarArena) ou alocado uma única vez por criarArena.
+ */
+typedef struct {
+    char *memoria;
+    size_t capacidade;
+    size_t usado;
+    int esgotada; // 1 se alguma alocação falhou por falta de espaço
+    int propria;  // memoria foi alocada por criarArena
+} Arena;
+
+void inicializarArena(Arena *arena, void *buffer, size_t tam);
+int criarArena(Arena *arena, size_t tam); // 0 ou -1 se malloc falhar
+void liberarArena(Arena *arena);          // só libera o bloco se veio de criarArena
+void reiniciarArena(Arena *arena);        // descarta tudo que foi alocado
+
+void *alocarArena(Arena *arena, size_t tam); // alinhado a 16 bytes; NULL se não couber
+#endif
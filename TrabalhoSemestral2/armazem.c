@@ -0,0 +1,477 @@
+/* armazem.c - armazém de fórmulas com nós compartilhados (hash-consing) */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "expressao.h"
+#include "tokens.h"
+#include "programa.h"
+#include "funcoes.h"
+#include "armazem.h"
+
+#define NENHUM 0xFFFFFFFFu    // sem segundo filho
+#define PRONTO 0x80000000u    // na pilha do percurso: os filhos já foram avaliados
+#define MAX_NOS 0x7FFFFFFFu
+#define PILHA_LOCAL 256
+
+struct ArmazemExpressoes {
+    /* nós em vetores paralelos; o índice é a identidade do nó */
+    unsigned char *op;      // OP_CONST, OP_VAR, OP_SOMA..OP_POT ou OP_FUNC
+    unsigned char *funcao;  // id da função (OP_FUNC)
+    unsigned *a;            // 1º filho; bits do float (OP_CONST); índice do nome (OP_VAR)
+    unsigned *b;            // 2º filho ou NENHUM
+    size_t nNos, capNos;
+    unsigned *baldes;       // tabela dos nós: índice + 1, 0 = vazio
+    size_t mascara;
+    size_t nosLogicos;
+
+    unsigned *raizes;       // uma por fórmula
+    int nFormulas, capFormulas;
+
+    /* nomes de variáveis: texto contíguo, cada um terminado em '\0' */
+    char *texto;
+    size_t tamTexto, capTexto;
+    unsigned *inicioNome;   // deslocamento de cada nome em texto
+    int nNomes, capNomes;
+    int *baldesNomes;       // -1 = vazio
+    size_t mascaraNomes;
+
+    /* reaproveitados de uma fórmula para a outra */
+    ListaTokens toks, pos;
+    unsigned *pilha;
+    size_t capPilha;
+};
+
+static int codigoDoOperador(char op) {
+    switch (op) {
+        case '+': return OP_SOMA;
+        case '-': return OP_SUB;
+        case '*': return OP_MUL;
+        case '/': return OP_DIV;
+        case '%': return OP_MOD;
+        case '^': return OP_POT;
+    }
+    return -1;
+}
+
+static size_t hashNo(unsigned op, unsigned funcao, unsigned a, unsigned b) {
+    unsigned long long h = (((unsigned long long)a << 32) | b) * 0x9E3779B97F4A7C15ull;
+    h ^= (unsigned long long)((op << 8) | funcao) * 0xC2B2AE3D27D4EB4Full;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 32;
+    return (size_t)h;
+}
+
+static size_t hashNome(const char *s, int n) {
+    size_t h = 2166136261u;
+    int i;
+    for (i = 0; i < n; ++i) h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+
+/* cresce 1,5x por vez: com milhões de nós, a sobra de capacidade pesa mais que as cópias */
+static int crescer(void **v, size_t *cap, size_t tamItem, size_t minimo) {
+    size_t novo = *cap ? *cap : 64;
+    void *p;
+    if (minimo <= *cap) return 0;
+    while (novo < minimo) novo += novo / 2;
+    p = realloc(*v, novo * tamItem);
+    if (!p) return -1;
+    *v = p;
+    *cap = novo;
+    return 0;
+}
+
+ArmazemExpressoes *criarArmazem(void) {
+    ArmazemExpressoes *arm = (ArmazemExpressoes*)calloc(1, sizeof(ArmazemExpressoes));
+    if (!arm) return NULL;
+    arm->baldes = (unsigned*)calloc(1024, sizeof(unsigned));
+    arm->baldesNomes = (int*)malloc(sizeof(int) * 64);
+    if (!arm->baldes || !arm->baldesNomes) { destruirArmazem(arm); return NULL; }
+    arm->mascara = 1023;
+    memset(arm->baldesNomes, 0xff, sizeof(int) * 64);
+    arm->mascaraNomes = 63;
+    inicializarListaTokens(&arm->toks);
+    inicializarListaTokens(&arm->pos);
+    return arm;
+}
+
+void destruirArmazem(ArmazemExpressoes *arm) {
+    if (!arm) return;
+    free(arm->op);
+    free(arm->funcao);
+    free(arm->a);
+    free(arm->b);
+    free(arm->baldes);
+    free(arm->raizes);
+    free(arm->texto);
+    free(arm->inicioNome);
+    free(arm->baldesNomes);
+    liberarListaTokens(&arm->toks);
+    liberarListaTokens(&arm->pos);
+    free(arm->pilha);
+    free(arm);
+}
+
+/* ---- nós ---- */
+
+/* dobra a tabela quando passa de 3/4 ocupada */
+static int crescerTabela(ArmazemExpressoes *arm) {
+    size_t cap = (arm->mascara + 1) * 2, i;
+    unsigned *novos = (unsigned*)calloc(cap, sizeof(unsigned));
+    if (!novos) return -1;
+    for (i = 0; i < arm->nNos; ++i) {
+        size_t j = hashNo(arm->op[i], arm->funcao[i], arm->a[i], arm->b[i]) & (cap - 1);
+        while (novos[j]) j = (j + 1) & (cap - 1);
+        novos[j] = (unsigned)i + 1;
+    }
+    free(arm->baldes);
+    arm->baldes = novos;
+    arm->mascara = cap - 1;
+    return 0;
+}
+
+/* índice do nó (op, funcao, a, b), criando-o se ainda não existe; NENHUM se faltar memória */
+static unsigned no(ArmazemExpressoes *arm, unsigned op, unsigned funcao, unsigned a, unsigned b) {
+    size_t h = hashNo(op, funcao, a, b), i = h & arm->mascara;
+    unsigned id;
+    while (arm->baldes[i]) {
+        id = arm->baldes[i] - 1;
+        if (arm->a[id] == a && arm->b[id] == b && arm->op[id] == op && arm->funcao[id] == funcao) return id;
+        i = (i + 1) & arm->mascara;
+    }
+    if (arm->nNos == MAX_NOS) return NENHUM;
+    if (arm->nNos == arm->capNos) {
+        size_t cap = arm->capNos;
+        /* os quatro vetores crescem juntos; capNos só muda quando todos conseguiram */
+        if (crescer((void**)&arm->op, &cap, 1, arm->nNos + 1) != 0) return NENHUM;
+        cap = arm->capNos;
+        if (crescer((void**)&arm->funcao, &cap, 1, arm->nNos + 1) != 0) return NENHUM;
+        cap = arm->capNos;
+        if (crescer((void**)&arm->a, &cap, sizeof(unsigned), arm->nNos + 1) != 0) return NENHUM;
+        cap = arm->capNos;
+        if (crescer((void**)&arm->b, &cap, sizeof(unsigned), arm->nNos + 1) != 0) return NENHUM;
+        arm->capNos = cap;
+    }
+    if ((arm->nNos + 1) * 4 > (arm->mascara + 1) * 3) {
+        if (crescerTabela(arm) != 0) return NENHUM;
+        i = h & arm->mascara;
+        while (arm->baldes[i]) i = (i + 1) & arm->mascara;
+    }
+    id = (unsigned)arm->nNos++;
+    arm->op[id] = (unsigned char)op;
+    arm->funcao[id] = (unsigned char)funcao;
+    arm->a[id] = a;
+    arm->b[id] = b;
+    arm->baldes[i] = id + 1;
+    return id;
+}
+
+/* ---- nomes ---- */
+
+static int buscarNome(const ArmazemExpressoes *arm, const char *nome, int n) {
+    size_t i = hashNome(nome, n) & arm->mascaraNomes;
+    while (arm->baldesNomes[i] >= 0) {
+        const char *v = arm->texto + arm->inicioNome[arm->baldesNomes[i]];
+        if (strncmp(v, nome, (size_t)n) == 0 && v[n] == '\0') return arm->baldesNomes[i];
+        i = (i + 1) & arm->mascaraNomes;
+    }
+    return -1;
+}
+
+static void inserirNome(ArmazemExpressoes *arm, int idx) {
+    const char *v = arm->texto + arm->inicioNome[idx];
+    size_t i = hashNome(v, (int)strlen(v)) & arm->mascaraNomes;
+    while (arm->baldesNomes[i] >= 0) i = (i + 1) & arm->mascaraNomes;
+    arm->baldesNomes[i] = idx;
+}
+
+/* índice do nome, acrescentando-o se for novo; -1 se faltar memória */
+static int internarNome(ArmazemExpressoes *arm, const char *nome, int n) {
+    size_t cap;
+    int idx = buscarNome(arm, nome, n), i;
+    if (idx >= 0) return idx;
+    if (arm->tamTexto + (size_t)n + 1 > 0xFFFFFFFFu) return -1;
+    if ((size_t)(arm->nNomes + 1) * 2 > arm->mascaraNomes + 1) {
+        size_t novaCap = (arm->mascaraNomes + 1) * 2;
+        int *novos = (int*)malloc(sizeof(int) * novaCap);
+        if (!novos) return -1;
+        memset(novos, 0xff, sizeof(int) * novaCap);
+        free(arm->baldesNomes);
+        arm->baldesNomes = novos;
+        arm->mascaraNomes = novaCap - 1;
+        for (i = 0; i < arm->nNomes; ++i) inserirNome(arm, i);
+    }
+    if (crescer((void**)&arm->texto, &arm->capTexto, 1, arm->tamTexto + (size_t)n + 1) != 0) return -1;
+    cap = (size_t)arm->capNomes;
+    if (crescer((void**)&arm->inicioNome, &cap, sizeof(unsigned), (size_t)arm->nNomes + 1) != 0) return -1;
+    arm->capNomes = (int)cap;
+    memcpy(arm->texto + arm->tamTexto, nome, (size_t)n);
+    arm->texto[arm->tamTexto + (size_t)n] = '\0';
+    arm->inicioNome[arm->nNomes] = (unsigned)arm->tamTexto;
+    arm->tamTexto += (size_t)n + 1;
+    inserirNome(arm, arm->nNomes);
+    return arm->nNomes++;
+}
+
+/* ---- fórmulas ---- */
+
+/* mesma validação de pilha da compilação (gerarCodigo), antes de criar qualquer nó */
+static int posfixaValida(const Token *seq, int n) {
+    int i, altura = 0;
+    for (i = 0; i < n; ++i) {
+        switch (seq[i].tipo) {
+            case TOK_NUMERO:
+            case TOK_NOME:
+                altura++;
+                break;
+            case TOK_FUNCAO: {
+                int aridade = aridadeFuncao(seq[i].funcao);
+                if (aridade < 1 || altura < aridade) return 0;
+                altura -= aridade - 1;
+            } break;
+            case TOK_OPERADOR:
+                if (altura < 2 || codigoDoOperador(seq[i].op) < 0) return 0;
+                altura--;
+                break;
+            default:
+                return 0;
+        }
+    }
+    return altura == 1;
+}
+
+/* fórmula que é só uma constante: um nó, como compilarExpressao a deixaria */
+static int adicionarConstante(ArmazemExpressoes *arm, float valor, int nTokens) {
+    size_t cap = (size_t)arm->capFormulas;
+    unsigned bits, id;
+    if (crescer((void**)&arm->raizes, &cap, sizeof(unsigned), (size_t)arm->nFormulas + 1) != 0) return -1;
+    arm->capFormulas = (int)cap;
+    memcpy(&bits, &valor, sizeof(bits));
+    if ((id = no(arm, OP_CONST, 0, bits, NENHUM)) == NENHUM) return -1;
+    arm->nosLogicos += (size_t)nTokens;
+    arm->raizes[arm->nFormulas] = id;
+    return arm->nFormulas++;
+}
+
+int adicionarFormulaArmazem(ArmazemExpressoes *arm, const char *expr) {
+    const ListaTokens *seq = &arm->toks;
+    ValorNumerico inteiro;
+    size_t cap;
+    int i, topo = 0;
+    if (!expr) return -1;
+    arm->toks.quantidade = 0;
+    arm->pos.quantidade = 0;
+    if (tokenizarExpressao(expr, strlen(expr), &arm->toks) != 0) return -1;
+    if (!ehPosfixaTokens(arm->toks.itens, arm->toks.quantidade)) {
+        if (infixaParaPosfixaTokens(arm->toks.itens, arm->toks.quantidade, &arm->pos) != 0) return -1;
+        seq = &arm->pos;
+    }
+    if (!posfixaValida(seq->itens, seq->quantidade)) return -1;
+    /* só literais inteiros: valor exato em int64, como processarExpressao e compilarExpressao */
+    if (literaisInteiros(expr, seq->itens, seq->quantidade) && calcularExpressaoTipada(expr, TIPO_INTEIRO, &inteiro) == 0)
+        return adicionarConstante(arm, (float)inteiro.v.i, seq->quantidade);
+    if (crescer((void**)&arm->pilha, &arm->capPilha, sizeof(unsigned), (size_t)seq->quantidade) != 0) return -1;
+    cap = (size_t)arm->capFormulas;
+    if (crescer((void**)&arm->raizes, &cap, sizeof(unsigned), (size_t)arm->nFormulas + 1) != 0) return -1;
+    arm->capFormulas = (int)cap;
+
+    /* em falta de memória no meio, os nós já criados ficam, sem fórmula que os use */
+    for (i = 0; i < seq->quantidade; ++i) {
+        const Token *t = &seq->itens[i];
+        unsigned id;
+        if (t->tipo == TOK_NUMERO) {
+            float v = (float)t->valor;
+            unsigned bits;
+            memcpy(&bits, &v, sizeof(bits));
+            id = no(arm, OP_CONST, 0, bits, NENHUM);
+        } else if (t->tipo == TOK_NOME) {
+            int v = internarNome(arm, expr + t->inicio, t->tam);
+            id = (v < 0) ? NENHUM : no(arm, OP_VAR, 0, (unsigned)v, NENHUM);
+        } else if (t->tipo == TOK_FUNCAO && aridadeFuncao(t->funcao) == 1) {
+            id = no(arm, OP_FUNC, (unsigned)t->funcao, arm->pilha[topo - 1], NENHUM);
+            topo--;
+        } else {
+            unsigned op = (t->tipo == TOK_FUNCAO) ? OP_FUNC : (unsigned)codigoDoOperador(t->op);
+            unsigned f = (t->tipo == TOK_FUNCAO) ? (unsigned)t->funcao : 0;
+            id = no(arm, op, f, arm->pilha[topo - 2], arm->pilha[topo - 1]);
+            topo -= 2;
+        }
+        if (id == NENHUM) return -1;
+        arm->pilha[topo++] = id;
+    }
+    arm->nosLogicos += (size_t)seq->quantidade;
+    arm->raizes[arm->nFormulas] = arm->pilha[0];
+    return arm->nFormulas++;
+}
+
+int quantidadeFormulasArmazem(const ArmazemExpressoes *arm) {
+    return arm->nFormulas;
+}
+
+int quantidadeVariaveisArmazem(const ArmazemExpressoes *arm) {
+    return arm->nNomes;
+}
+
+const char *nomeVariavelArmazem(const ArmazemExpressoes *arm, int v) {
+    if (v < 0 || v >= arm->nNomes) return NULL;
+    return arm->texto + arm->inicioNome[v];
+}
+
+int indiceVariavelArmazem(const ArmazemExpressoes *arm, const char *nome) {
+    if (!nome) return -1;
+    return buscarNome(arm, nome, (int)strlen(nome));
+}
+
+/* ---- percurso ---- */
+
+/* dobra uma pilha que começou no vetor local */
+static int dobrarPilha(void **itens, size_t *cap, void *local, size_t tamItem) {
+    size_t novaCap = *cap * 2;
+    void *novo = (*itens == local) ? malloc(novaCap * tamItem) : realloc(*itens, novaCap * tamItem);
+    if (!novo) return -1;
+    if (*itens == local) memcpy(novo, local, *cap * tamItem);
+    *itens = novo;
+    *cap = novaCap;
+    return 0;
+}
+
+/* aplica o nó id aos valores do topo, como avaliarPrograma */
+static float aplicarNo(const ArmazemExpressoes *arm, unsigned id, const float *vals, size_t *nv) {
+    float a, b;
+    if (arm->op[id] == OP_FUNC && arm->b[id] == NENHUM)
+        return descritorFuncao(arm->funcao[id])->unaria(vals[--*nv]);
+    b = vals[--*nv];
+    a = vals[--*nv];
+    switch (arm->op[id]) {
+        case OP_SOMA: return a + b;
+        case OP_SUB: return a - b;
+        case OP_MUL: return a * b;
+        case OP_DIV: return (b != 0.0f) ? a / b : 0.0f;
+        case OP_FUNC: return descritorFuncao(arm->funcao[id])->binaria(a, b);
+        default: return aplicarOperadorBinario(operadorDoCodigo(arm->op[id]), a, b);
+    }
+}
+
+float avaliarFormulaArmazem(const ArmazemExpressoes *arm, int f, const float *valores) {
+    unsigned nosLocal[PILHA_LOCAL];
+    float valsLocal[PILHA_LOCAL];
+    unsigned *nos = nosLocal;
+    float *vals = valsLocal;
+    size_t capNos = PILHA_LOCAL, capVals = PILHA_LOCAL, topo = 0, nv = 0;
+    float r = 0.0f;
+    if (f < 0 || f >= arm->nFormulas) return 0.0f;
+
+    /* pós-ordem com pilha explícita: fórmulas longas não estouram a pilha do C */
+    nos[topo++] = arm->raizes[f];
+    while (topo > 0) {
+        unsigned x = nos[--topo], id = x & ~PRONTO;
+        unsigned op = arm->op[id];
+        if (x & PRONTO || op == OP_CONST || op == OP_VAR) {
+            float v;
+            if (x & PRONTO) v = aplicarNo(arm, id, vals, &nv);
+            else if (op == OP_CONST) memcpy(&v, &arm->a[id], sizeof(v));
+            else v = valores[arm->a[id]];
+            if (nv == capVals && dobrarPilha((void**)&vals, &capVals, valsLocal, sizeof(float)) != 0) goto fim;
+            vals[nv++] = v;
+        } else {
+            if (topo + 3 > capNos && dobrarPilha((void**)&nos, &capNos, nosLocal, sizeof(unsigned)) != 0) goto fim;
+            nos[topo++] = id | PRONTO;
+            if (arm->b[id] != NENHUM) nos[topo++] = arm->b[id];
+            nos[topo++] = arm->a[id];
+        }
+    }
+    r = vals[0];
+
+fim:
+    if (nos != nosLocal) free(nos);
+    if (vals != valsLocal) free(vals);
+    return r;
+}
+
+typedef struct {
+    char *dados;
+    size_t tam, cap;
+} Texto;
+
+static int escrever(Texto *t, const char *s, size_t n) {
+    if (crescer((void**)&t->dados, &t->cap, 1, t->tam + n + 2) != 0) return -1;
+    if (t->tam > 0) t->dados[t->tam++] = ' ';
+    memcpy(t->dados + t->tam, s, n);
+    t->tam += n;
+    t->dados[t->tam] = '\0';
+    return 0;
+}
+
+/* texto que lerNumero converte de volta para os mesmos bits de float */
+static int escreverConstante(Texto *t, unsigned bits) {
+    char num[32];
+    float v;
+    int n;
+    memcpy(&v, &bits, sizeof(v));
+    if (isinf(v)) n = snprintf(num, sizeof(num), "%s1e39", v < 0 ? "-" : "");
+    else n = snprintf(num, sizeof(num), "%.9g", (double)v);
+    return escrever(t, num, (size_t)n);
+}
+
+char *textoFormulaArmazem(const ArmazemExpressoes *arm, int f) {
+    unsigned nosLocal[PILHA_LOCAL];
+    unsigned *nos = nosLocal;
+    size_t capNos = PILHA_LOCAL, topo = 0;
+    Texto t = { NULL, 0, 0 };
+    int ok = 0;
+    if (f < 0 || f >= arm->nFormulas) return NULL;
+
+    nos[topo++] = arm->raizes[f];
+    while (topo > 0) {
+        unsigned x = nos[--topo], id = x & ~PRONTO;
+        unsigned op = arm->op[id];
+        int r;
+        if (x & PRONTO) {
+            if (op == OP_FUNC) {
+                const DescritorFuncao *d = descritorFuncao(arm->funcao[id]);
+                r = escrever(&t, d->nome, (size_t)d->tamNome);
+            } else {
+                char s = operadorDoCodigo(op);
+                r = escrever(&t, &s, 1);
+            }
+        } else if (op == OP_CONST) {
+            r = escreverConstante(&t, arm->a[id]);
+        } else if (op == OP_VAR) {
+            const char *nome = arm->texto + arm->inicioNome[arm->a[id]];
+            r = escrever(&t, nome, strlen(nome));
+        } else {
+            if (topo + 3 > capNos && dobrarPilha((void**)&nos, &capNos, nosLocal, sizeof(unsigned)) != 0) goto fim;
+            nos[topo++] = id | PRONTO;
+            if (arm->b[id] != NENHUM) nos[topo++] = arm->b[id];
+            nos[topo++] = arm->a[id];
+            r = 0;
+        }
+        if (r != 0) goto fim;
+    }
+    ok = 1;
+
+fim:
+    if (nos != nosLocal) free(nos);
+    if (!ok) { free(t.dados); return NULL; }
+    return t.dados;
+}
+
+void estatisticasArmazem(const ArmazemExpressoes *arm, EstatisticasArmazem *est) {
+    est->formulas = arm->nFormulas;
+    est->variaveis = arm->nNomes;
+    est->nos = arm->nNos;
+    est->nosLogicos = arm->nosLogicos;
+    est->bytes = sizeof(*arm)
+               + arm->capNos * (2 + 2 * sizeof(unsigned))
+               + (arm->mascara + 1) * sizeof(unsigned)
+               + (size_t)arm->capFormulas * sizeof(unsigned)
+               + arm->capTexto
+               + (size_t)arm->capNomes * sizeof(unsigned)
+               + (arm->mascaraNomes + 1) * sizeof(int);
+    est->bytesPorFormula = arm->nFormulas ? (double)est->bytes / arm->nFormulas : 0.0;
+    est->deduplicacao = arm->nNos ? (double)arm->nosLogicos / (double)arm->nNos : 0.0;
+}
@@ -0,0 +1,49 @@
+#ifndef ARMAZEM_H
+#define ARMAZEM_H
+#include <stddef.h>
+
+/*
+ * Armazém de fórmulas com nós compartilhados (hash-consing). Cada fórmula
+ * vira uma árvore de nós (constante, variável, operador ou função), mas um
+ * nó igual a outro já guardado (mesma operação e mesmos filhos) não é
+ * criado de novo: subexpressões repetidas, em qualquer fórmula, ocupam um
+ * só nó, e cada constante, variável e chamada distinta existe uma vez.
+ * Os nós ficam em vetores paralelos (operação, função, filhos), cerca de
+ * 10 bytes por nó mais a tabela hash, e cada fórmula é só o índice da raiz.
+ * Nomes de variáveis são globais ao armazém. Os valores são os de
+ * avaliarPrograma (float, funções embutidas da libm). Nós nunca são
+ * removidos; não é seguro adicionar fórmulas de várias threads ao mesmo
+ * tempo, mas avaliar e ler sim, se ninguém estiver adicionando.
+ */
+typedef struct ArmazemExpressoes ArmazemExpressoes;
+
+typedef struct {
+    int formulas;
+    int variaveis;
+    size_t nos;              // nós distintos guardados
+    size_t nosLogicos;       // nós somando as árvores de todas as fórmulas, sem compartilhar
+    size_t bytes;            // memória do armazém (vetores e tabelas, pela capacidade)
+    double bytesPorFormula;
+    double deduplicacao;     // nosLogicos / nos
+} EstatisticasArmazem;
+
+ArmazemExpressoes *criarArmazem(void);
+void destruirArmazem(ArmazemExpressoes *arm);
+
+/* Acrescenta a fórmula (infixa ou pós-fixa) e retorna o índice dela, ou -1 se for inválida ou faltar memória */
+int adicionarFormulaArmazem(ArmazemExpressoes *arm, const char *expr);
+int quantidadeFormulasArmazem(const ArmazemExpressoes *arm);
+
+/* Variáveis na ordem em que apareceram pela primeira vez, em qualquer fórmula */
+int quantidadeVariaveisArmazem(const ArmazemExpressoes *arm);
+const char *nomeVariavelArmazem(const ArmazemExpressoes *arm, int v);
+int indiceVariavelArmazem(const ArmazemExpressoes *arm, const char *nome); // -1 se não existe
+
+/* Valor da fórmula f; valores tem uma posição por variável do armazém. 0 se f não existe. */
+float avaliarFormulaArmazem(const ArmazemExpressoes *arm, int f, const float *valores);
+
+/* Forma pós-fixa da fórmula f (malloc), que recompila para os mesmos valores; NULL em erro */
+char *textoFormulaArmazem(const ArmazemExpressoes *arm, int f);
+
+void estatisticasArmazem(const ArmazemExpressoes *arm, EstatisticasArmazem *est);
+#endif
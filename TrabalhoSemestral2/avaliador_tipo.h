@@ -0,0 +1,97 @@
+/*
+ * avaliador_tipo.h - modelo do avaliador pós-fixo sobre um tipo numérico.
+ * Não é um cabeçalho comum: expressao.c o inclui uma vez por tipo, com
+ *   TIPO    tipo dos valores (float, double, long long)
+ *   SUFIXO  sufixo dos nomes gerados (Float, Double, Inteiro)
+ * já definidos, além destas funções com o mesmo sufixo:
+ *   int literal<S>(const char *texto, const Token *t, TIPO *r)  // t no texto de origem
+ *   int operar<S>(char op, TIPO a, TIPO b, TIPO *r)
+ *   int funcao<S>(int id, const TIPO *args, TIPO *r)   // args[0..aridade)
+ * Cada uma retorna 0, ou -1 se o resultado não existir nesse tipo
+ * (só acontece no inteiro: estouro, divisão com resto, função...).
+ * Gera Pilha<S> e avaliarTokens<S>; TIPO e SUFIXO são desfeitos no fim.
+ */
+
+#define COLAR_(a, b) a##b
+#define COLAR(a, b) COLAR_(a, b)
+#define NOME(n) COLAR(n, SUFIXO)
+
+/* pilha de valores: começa no vetor local e dobra (malloc ou arena) quando enche */
+typedef struct {
+    TIPO local[PILHA_VALORES_LOCAL];
+    TIPO *itens;
+    int topo;
+    int capacidade;
+    int erro;     // faltou memória para crescer
+    Arena *arena;
+} NOME(Pilha);
+
+static void NOME(inicializarPilha)(NOME(Pilha) *p, Arena *arena) {
+    p->itens = p->local;
+    p->topo = -1;
+    p->capacidade = PILHA_VALORES_LOCAL;
+    p->erro = 0;
+    p->arena = arena;
+}
+
+static void NOME(liberarPilha)(NOME(Pilha) *p) {
+    if (p->itens != p->local) devolver(p->arena, p->itens);
+    p->itens = p->local;
+}
+
+static int NOME(empilhar)(NOME(Pilha) *p, TIPO v) {
+    if (p->topo + 1 == p->capacidade) {
+        int novaCap = p->capacidade * 2;
+        TIPO *novo = (TIPO*)reservar(p->arena, sizeof(TIPO) * (size_t)novaCap);
+        if (!novo) { p->erro = 1; return -1; }
+        memcpy(novo, p->itens, sizeof(TIPO) * (size_t)(p->topo + 1));
+        NOME(liberarPilha)(p);
+        p->itens = novo;
+        p->capacidade = novaCap;
+    }
+    p->itens[++(p->topo)] = v;
+    EST_PICO_VALORES(p->topo + 1);
+    return 0;
+}
+
+/* valor da sequência pós-fixa (tokens de texto) em *r; -1 (e *r = 0) se ela for inválida ou o valor não couber em TIPO */
+static int NOME(avaliarTokens)(Arena *arena, const char *texto, const Token *toks, int n, TIPO *r) {
+    NOME(Pilha) p;
+    TIPO v;
+    int i, ok = 1;
+    *r = 0;
+    NOME(inicializarPilha)(&p, arena);
+    for (i = 0; i < n && ok; ++i) {
+        const Token *t = &toks[i];
+        if (t->tipo == TOK_NUMERO) {
+            ok = (NOME(literal)(texto, t, &v) == 0);
+        } else if (t->tipo == TOK_FUNCAO) {
+            int aridade = aridadeFuncao(t->funcao);
+            ok = (p.topo + 1 >= aridade && aridade > 0);
+            if (ok) {
+                p.topo -= aridade;
+                ok = (NOME(funcao)(t->funcao, &p.itens[p.topo + 1], &v) == 0);
+            }
+        } else if (t->tipo == TOK_OPERADOR) {
+            ok = (p.topo >= 1);
+            if (ok) {
+                p.topo -= 2;
+                ok = (NOME(operar)(t->op, p.itens[p.topo + 1], p.itens[p.topo + 2], &v) == 0);
+            }
+        } else {
+            ok = 0;
+        }
+        if (ok) ok = (NOME(empilhar)(&p, v) == 0);
+    }
+
+    ok = ok && p.topo >= 0;
+    if (ok) *r = p.itens[p.topo]; // sobra na pilha (infixa malformada aceita): vale o topo, como antes
+    NOME(liberarPilha)(&p);
+    return ok ? 0 : -1;
+}
+
+#undef NOME
+#undef COLAR
+#undef COLAR_
+#undef TIPO
+#undef SUFIXO
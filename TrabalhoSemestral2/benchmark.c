@@ -0,0 +1,240 @@
+/* benchmark.c - corpus sintético e medição de cada etapa do processamento */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "expressao.h"
+#include "benchmark.h"
+#include "estatisticas.h"
+
+/* Etapas internas de expressao.c */
+char *normalizarInfixa(const char *expr);
+int detectarPosfixa(const char *entrada);
+char *infixaParaPosfixaInterna(const char *infixa_raw);
+char *converterPosfixaParaInfixaInterna(const char *posfixa_raw);
+
+static const char *nomesFuncoes[] = { "sen", "cos", "tg", "log", "log10", "raiz", "sqrt" };
+static const char operadores[] = "+-*/%^";
+
+void configBenchmarkPadrao(ConfigBenchmark *cfg) {
+    cfg->quantidade = 10000;
+    cfg->profundidade = 4;
+    cfg->largura = 3;
+    cfg->pctFuncoes = 20;
+    cfg->numeros = "idn";
+    cfg->semente = 1;
+    cfg->repeticoes = 5;
+}
+
+int lerConfigBenchmark(int argc, char **argv, ConfigBenchmark *cfg) {
+    int i;
+    for (i = 0; i + 1 < argc; i += 2) {
+        const char *op = argv[i], *v = argv[i+1];
+        if (strcmp(op, "--quantidade") == 0) cfg->quantidade = atoi(v);
+        else if (strcmp(op, "--profundidade") == 0) cfg->profundidade = atoi(v);
+        else if (strcmp(op, "--largura") == 0) cfg->largura = atoi(v);
+        else if (strcmp(op, "--funcoes") == 0) cfg->pctFuncoes = atoi(v);
+        else if (strcmp(op, "--numeros") == 0) cfg->numeros = v;
+        else if (strcmp(op, "--semente") == 0) cfg->semente = (unsigned)strtoul(v, NULL, 10);
+        else if (strcmp(op, "--repeticoes") == 0) cfg->repeticoes = atoi(v);
+        else return -1;
+    }
+    if (i != argc) return -1;
+    if (cfg->quantidade < 1 || cfg->profundidade < 0 || cfg->largura < 2 || cfg->repeticoes < 1 ||
+        cfg->pctFuncoes < 0 || cfg->pctFuncoes > 100 || !cfg->numeros[0] ||
+        strspn(cfg->numeros, "idne") != strlen(cfg->numeros)) return -1;
+    return 0;
+}
+
+/* ---- gerador ---- */
+
+/* xorshift32: sequência reproduzível para a mesma semente em qualquer plataforma */
+static unsigned sortear(unsigned *s, unsigned n) {
+    unsigned x = *s ? *s : 0x9E3779B9u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *s = x;
+    return x % n;
+}
+
+typedef struct {
+    char *dados;
+    size_t tam, cap;
+    int erro;
+} Texto;
+
+static void escrever(Texto *t, const char *s) {
+    size_t n = strlen(s);
+    if (t->erro) return;
+    if (t->tam + n + 1 > t->cap) {
+        size_t novaCap = t->cap ? t->cap * 2 : 64;
+        char *novo;
+        while (novaCap < t->tam + n + 1) novaCap *= 2;
+        novo = (char*)realloc(t->dados, novaCap);
+        if (!novo) { t->erro = 1; return; }
+        t->dados = novo;
+        t->cap = novaCap;
+    }
+    memcpy(t->dados + t->tam, s, n + 1);
+    t->tam += n;
+}
+
+static void gerarNumero(const ConfigBenchmark *cfg, unsigned *s, char *buf) {
+    char formato = cfg->numeros[sortear(s, (unsigned)strlen(cfg->numeros))];
+    unsigned inteiro = 1 + sortear(s, 999);
+    switch (formato) {
+        case 'd': sprintf(buf, "%u.%02u", inteiro, sortear(s, 100)); break;
+        case 'n': sprintf(buf, "-%u", inteiro); break;
+        case 'e': sprintf(buf, "%u.%ue%d", inteiro % 10, sortear(s, 1000), (int)sortear(s, 7) - 3); break;
+        default: sprintf(buf, "%u", inteiro); break;
+    }
+}
+
+/* escreve o mesmo nó nas duas formas; % e ^ recebem um inteiro pequeno à direita */
+static void gerarNo(const ConfigBenchmark *cfg, unsigned *s, int nivel, Texto *in, Texto *pos) {
+    char num[32];
+    int i, n;
+    if (nivel == 0) {
+        gerarNumero(cfg, s, num);
+        escrever(in, num);
+        escrever(pos, num);
+        return;
+    }
+    if ((int)sortear(s, 100) < cfg->pctFuncoes) {
+        const char *f = nomesFuncoes[sortear(s, sizeof(nomesFuncoes) / sizeof(nomesFuncoes[0]))];
+        escrever(in, f);
+        escrever(in, "(");
+        gerarNo(cfg, s, nivel - 1, in, pos);
+        escrever(in, ")");
+        escrever(pos, " ");
+        escrever(pos, f);
+        return;
+    }
+    /* encadeamento sempre entre parênteses à esquerda, para coincidir com a pós-fixa */
+    n = 2 + (int)sortear(s, (unsigned)cfg->largura - 1);
+    for (i = 1; i < n; ++i) escrever(in, "(");
+    gerarNo(cfg, s, nivel - 1, in, pos);
+    for (i = 1; i < n; ++i) {
+        char op[4] = { ' ', operadores[sortear(s, sizeof(operadores) - 1)], ' ', '\0' };
+        escrever(in, op);
+        escrever(pos, " ");
+        if (op[1] == '%' || op[1] == '^') {
+            sprintf(num, "%u", 1 + sortear(s, 4));
+            escrever(in, num);
+            escrever(pos, num);
+        } else {
+            gerarNo(cfg, s, nivel - 1, in, pos);
+        }
+        escrever(in, ")");
+        op[2] = '\0';
+        escrever(pos, op); /* " op" na pós-fixa */
+    }
+}
+
+int gerarExpressao(const ConfigBenchmark *cfg, unsigned *semente, char **infixa, char **posfixa) {
+    Texto in = { NULL, 0, 0, 0 }, pos = { NULL, 0, 0, 0 };
+    gerarNo(cfg, semente, cfg->profundidade, &in, &pos);
+    if (in.erro || pos.erro) {
+        free(in.dados);
+        free(pos.dados);
+        return -1;
+    }
+    *infixa = in.dados;
+    *posfixa = pos.dados;
+    return 0;
+}
+
+/* ---- medição ---- */
+
+enum { ET_NORMALIZAR, ET_DETECTAR, ET_INFIXA_POSFIXA, ET_POSFIXA_INFIXA, ET_VALOR, ET_QUANTIDADE };
+
+static const char *nomesEtapas[] = {
+    "normalizarInfixa", "detectarPosfixa", "infixaParaPosfixaInterna",
+    "converterPosfixaParaInfixaInterna", "getValorPosFixa"
+};
+
+/* o volatile impede que o compilador descarte chamadas sem efeito visível */
+static volatile float sumidouro;
+
+static void executarEtapa(int etapa, char *entrada) {
+    char *r = NULL;
+    switch (etapa) {
+        case ET_NORMALIZAR: r = normalizarInfixa(entrada); break;
+        case ET_DETECTAR: sumidouro = (float)detectarPosfixa(entrada); break;
+        case ET_INFIXA_POSFIXA: r = infixaParaPosfixaInterna(entrada); break;
+        case ET_POSFIXA_INFIXA: r = converterPosfixaParaInfixaInterna(entrada); break;
+        case ET_VALOR: sumidouro = getValorPosFixa(entrada); break;
+    }
+    free(r);
+}
+
+static int compararLongLong(const void *a, const void *b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+static long long percentil(const long long *ordenado, size_t n, int p) {
+    size_t i = (n * (size_t)p + 99) / 100;
+    return ordenado[i > 0 ? i - 1 : 0];
+}
+
+int executarBenchmark(const ConfigBenchmark *cfg, FILE *saida) {
+    size_t n = (size_t)cfg->quantidade;
+    size_t chamadas = n * (size_t)cfg->repeticoes;
+    char **infixas = (char**)calloc(n, sizeof(char*));
+    char **posfixas = (char**)calloc(n, sizeof(char*));
+    long long *latencias = (long long*)malloc(sizeof(long long) * chamadas);
+    unsigned semente = cfg->semente;
+    size_t bytesIn = 0, bytesPos = 0, i;
+    int etapa, r, ok = 0;
+
+    if (!infixas || !posfixas || !latencias) goto fim;
+    for (i = 0; i < n; ++i) {
+        if (gerarExpressao(cfg, &semente, &infixas[i], &posfixas[i]) != 0) goto fim;
+        bytesIn += strlen(infixas[i]);
+        bytesPos += strlen(posfixas[i]);
+    }
+
+    for (etapa = 0; etapa < ET_QUANTIDADE; ++etapa) {
+        /* detectarPosfixa recebe as duas formas, alternadas */
+        size_t bytes = 0, k = 0;
+        long long total;
+        for (r = 0; r < cfg->repeticoes; ++r) {
+            for (i = 0; i < n; ++i) {
+                int usaPos = (etapa == ET_POSFIXA_INFIXA || etapa == ET_VALOR ||
+                              (etapa == ET_DETECTAR && (i & 1)));
+                char *entrada = usaPos ? posfixas[i] : infixas[i];
+                long long t0 = relogioNs();
+                executarEtapa(etapa, entrada);
+                latencias[k++] = relogioNs() - t0;
+                if (r == 0) bytes += strlen(entrada);
+            }
+        }
+        total = 0;
+        for (i = 0; i < chamadas; ++i) total += latencias[i];
+        qsort(latencias, chamadas, sizeof(long long), compararLongLong);
+        fprintf(saida,
+                "{\"etapa\":\"%s\",\"chamadas\":%lu,\"bytes\":%lu,\"ns_total\":%lld,"
+                "\"por_segundo\":%.0f,\"mb_por_segundo\":%.2f,\"p50_ns\":%lld,\"p99_ns\":%lld}\n",
+                nomesEtapas[etapa], (unsigned long)chamadas, (unsigned long)bytes, total,
+                total > 0 ? (double)chamadas * 1e9 / (double)total : 0.0,
+                total > 0 ? (double)bytes * cfg->repeticoes * 1e3 / (double)total : 0.0,
+                percentil(latencias, chamadas, 50), percentil(latencias, chamadas, 99));
+    }
+    fprintf(saida,
+            "{\"corpus\":{\"quantidade\":%d,\"profundidade\":%d,\"largura\":%d,\"funcoes\":%d,"
+            "\"numeros\":\"%s\",\"semente\":%u,\"repeticoes\":%d,\"bytes_infixa\":%lu,\"bytes_posfixa\":%lu}}\n",
+            cfg->quantidade, cfg->profundidade, cfg->largura, cfg->pctFuncoes, cfg->numeros,
+            cfg->semente, cfg->repeticoes, (unsigned long)bytesIn, (unsigned long)bytesPos);
+    ok = 1;
+
+fim:
+    if (infixas) for (i = 0; i < n; ++i) free(infixas[i]);
+    if (posfixas) for (i = 0; i < n; ++i) free(posfixas[i]);
+    free(infixas);
+    free(posfixas);
+    free(latencias);
+    return ok ? 0 : -1;
+}
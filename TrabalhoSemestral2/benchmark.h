@@ -0,0 +1,36 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+#include <stdio.h>
+
+/* Parâmetros do gerador de expressões aleatórias */
+typedef struct {
+    int quantidade;    // expressões no corpus
+    int profundidade;  // níveis de aninhamento
+    int largura;       // operandos encadeados em cada nível (>= 2)
+    int pctFuncoes;    // % dos nós que viram chamada de função (sen, log, ...)
+    const char *numeros; // formatos dos literais: 'i' inteiro, 'd' decimal, 'n' negativo, 'e' com expoente
+    unsigned semente;
+    int repeticoes;    // passadas sobre o corpus em cada etapa
+} ConfigBenchmark;
+
+void configBenchmarkPadrao(ConfigBenchmark *cfg);
+
+/* Lê "--opcao valor" de argv[0..argc) (ver main.c). Retorna 0 ou -1 se houver opção inválida. */
+int lerConfigBenchmark(int argc, char **argv, ConfigBenchmark *cfg);
+
+/*
+ * Gera uma expressão aleatória válida nas duas formas, a partir das mesmas
+ * escolhas: *infixa e *posfixa recebem strings alocadas com malloc.
+ * semente é o estado do gerador e avança a cada chamada. Retorna 0 ou -1.
+ */
+int gerarExpressao(const ConfigBenchmark *cfg, unsigned *semente, char **infixa, char **posfixa);
+
+/*
+ * Gera o corpus e mede normalizarInfixa, detectarPosfixa,
+ * infixaParaPosfixaInterna, converterPosfixaParaInfixaInterna e
+ * getValorPosFixa separadamente. Escreve em saida uma linha JSON por
+ * etapa (chamadas, bytes, vazão e latências p50/p99 em ns), estável para
+ * comparar entre builds. Retorna 0, ou -1 em erro de memória.
+ */
+int executarBenchmark(const ConfigBenchmark *cfg, FILE *saida);
+#endif
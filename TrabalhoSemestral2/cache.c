@@ -0,0 +1,259 @@
+/* cache.c - cache fatiado de resultados de processarExpressao */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "expressao.h"
+#include "tokens.h"
+#include "paralelo.h"
+#include "cache.h"
+
+typedef struct EntradaCache {
+    struct EntradaCache *proxima; // próxima do mesmo balde
+    unsigned long long hash;
+    size_t tamChave;
+    size_t bytes;                 // tamanho total da alocação
+    float valor;
+    int ehPos;
+    unsigned char referenciada;   // bit do relógio
+    char *saida;                  // aponta para depois da chave
+    char chave[];
+} EntradaCache;
+
+typedef struct {
+    pthread_mutex_t mtx;
+    EntradaCache **baldes;
+    size_t nBaldes;               // potência de 2
+    EntradaCache **anel;
+    int nAnel;
+    int capAnel;
+    int ponteiro;                 // ponteiro do relógio
+    size_t bytes;
+    size_t orcamento;
+    unsigned long long acertos, falhas, remocoes;
+} FatiaCache;
+
+struct CacheExpressoes {
+    FatiaCache *fatias;
+    int nFatias;                  // potência de 2
+    size_t orcamento;
+};
+
+#define BALDES_INICIAIS 64
+#define TAM_CHAVE_LOCAL 256
+
+/* FNV-1a de 64 bits */
+static unsigned long long hashChave(const char *s, size_t n) {
+    unsigned long long h = 1469598103934665603ULL;
+    size_t i;
+    for (i = 0; i < n; ++i) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+CacheExpressoes *criarCacheExpressoes(size_t orcamento, int nFatias) {
+    CacheExpressoes *cache;
+    int n = 1, i;
+    if (nFatias <= 0) nFatias = 4 * nucleosDisponiveis();
+    while (n < nFatias) n *= 2;
+    cache = (CacheExpressoes*)calloc(1, sizeof(CacheExpressoes));
+    if (!cache) return NULL;
+    cache->fatias = (FatiaCache*)calloc((size_t)n, sizeof(FatiaCache));
+    if (!cache->fatias) { free(cache); return NULL; }
+    cache->nFatias = n;
+    cache->orcamento = orcamento;
+    for (i = 0; i < n; ++i) {
+        FatiaCache *f = &cache->fatias[i];
+        pthread_mutex_init(&f->mtx, NULL);
+        f->orcamento = orcamento / (size_t)n;
+    }
+    return cache;
+}
+
+void destruirCacheExpressoes(CacheExpressoes *cache) {
+    int i, k;
+    if (!cache) return;
+    for (i = 0; i < cache->nFatias; ++i) {
+        FatiaCache *f = &cache->fatias[i];
+        for (k = 0; k < f->nAnel; ++k) free(f->anel[k]);
+        free(f->anel);
+        free(f->baldes);
+        pthread_mutex_destroy(&f->mtx);
+    }
+    free(cache->fatias);
+    free(cache);
+}
+
+static EntradaCache *buscar(FatiaCache *f, unsigned long long h, const char *chave, size_t tam) {
+    EntradaCache *e;
+    if (!f->baldes) return NULL;
+    for (e = f->baldes[h & (f->nBaldes - 1)]; e; e = e->proxima) {
+        if (e->hash == h && e->tamChave == tam && memcmp(e->chave, chave, tam) == 0) return e;
+    }
+    return NULL;
+}
+
+static void retirarDoBalde(FatiaCache *f, EntradaCache *alvo) {
+    EntradaCache **p = &f->baldes[alvo->hash & (f->nBaldes - 1)];
+    while (*p != alvo) p = &(*p)->proxima;
+    *p = alvo->proxima;
+}
+
+/* relógio: pula (e limpa) as referenciadas e remove a primeira que não foi usada desde a última volta */
+static void removerUma(FatiaCache *f) {
+    EntradaCache *e;
+    for (;;) {
+        if (f->ponteiro >= f->nAnel) f->ponteiro = 0;
+        e = f->anel[f->ponteiro];
+        if (!e->referenciada) break;
+        e->referenciada = 0;
+        f->ponteiro++;
+    }
+    retirarDoBalde(f, e);
+    f->anel[f->ponteiro] = f->anel[--f->nAnel];
+    f->bytes -= e->bytes;
+    f->remocoes++;
+    free(e);
+}
+
+static int crescerBaldes(FatiaCache *f) {
+    size_t n = f->nBaldes ? f->nBaldes * 2 : BALDES_INICIAIS;
+    EntradaCache **novos = (EntradaCache**)calloc(n, sizeof(EntradaCache*));
+    int k;
+    if (!novos) return -1;
+    for (k = 0; k < f->nAnel; ++k) {
+        EntradaCache *e = f->anel[k];
+        e->proxima = novos[e->hash & (n - 1)];
+        novos[e->hash & (n - 1)] = e;
+    }
+    free(f->baldes);
+    f->baldes = novos;
+    f->nBaldes = n;
+    return 0;
+}
+
+/* chamada com o mutex da fatia travado; e passa a pertencer à fatia se retornar 0 */
+static int inserir(FatiaCache *f, EntradaCache *e) {
+    if (e->bytes > f->orcamento) return -1;
+    while (f->nAnel > 0 && f->bytes + e->bytes > f->orcamento) removerUma(f);
+    if ((size_t)f->nAnel >= f->nBaldes && crescerBaldes(f) != 0) return -1;
+    if (f->nAnel == f->capAnel) {
+        int cap = f->capAnel ? f->capAnel * 2 : BALDES_INICIAIS;
+        EntradaCache **novo = (EntradaCache**)realloc(f->anel, sizeof(EntradaCache*) * (size_t)cap);
+        if (!novo) return -1;
+        f->anel = novo;
+        f->capAnel = cap;
+    }
+    e->proxima = f->baldes[e->hash & (f->nBaldes - 1)];
+    f->baldes[e->hash & (f->nBaldes - 1)] = e;
+    f->anel[f->nAnel++] = e;
+    f->bytes += e->bytes;
+    return 0;
+}
+
+/* monta em *chave os tokens de entrada separados por um espaço ("-num" continua colado,
+   o que preserva a diferença entre "3 -4 +" e "3 - 4 +"). Retorna o tamanho ou -1. */
+static long montarChave(const char *entrada, char *local, size_t tamLocal, char **chave) {
+    char memoria[4096];
+    Arena arena;
+    ListaTokens toks;
+    size_t n = strlen(entrada), total = 0, p = 0;
+    int i, r;
+    inicializarArena(&arena, memoria, sizeof(memoria));
+    inicializarListaTokensArena(&toks, &arena);
+    r = tokenizarExpressao(entrada, n, &toks);
+    if (r != 0 && arena.esgotada) {
+        inicializarListaTokens(&toks);
+        r = tokenizarExpressao(entrada, n, &toks);
+    }
+    if (r != 0 || toks.quantidade == 0) { liberarListaTokens(&toks); return -1; }
+    for (i = 0; i < toks.quantidade; ++i) total += (size_t)toks.itens[i].tam + 1;
+    *chave = (total <= tamLocal) ? local : (char*)malloc(total);
+    if (!*chave) { liberarListaTokens(&toks); return -1; }
+    for (i = 0; i < toks.quantidade; ++i) {
+        if (i > 0) (*chave)[p++] = ' ';
+        memcpy(*chave + p, entrada + toks.itens[i].inicio, (size_t)toks.itens[i].tam);
+        p += (size_t)toks.itens[i].tam;
+    }
+    liberarListaTokens(&toks);
+    return (long)p;
+}
+
+int processarExpressaoCache(CacheExpressoes *cache, const char *entrada, char **saida, float *valor, int *ehPos) {
+    char local[TAM_CHAVE_LOCAL];
+    char *chave;
+    long tam;
+    unsigned long long h;
+    FatiaCache *f;
+    EntradaCache *e;
+    int r;
+    if (!cache || !entrada || !saida || !valor || !ehPos) return processarExpressao(entrada, saida, valor, ehPos);
+
+    tam = montarChave(entrada, local, sizeof(local), &chave);
+    if (tam < 0) return processarExpressao(entrada, saida, valor, ehPos);
+    h = hashChave(chave, (size_t)tam);
+    f = &cache->fatias[(h >> 48) & (unsigned long long)(cache->nFatias - 1)];
+
+    pthread_mutex_lock(&f->mtx);
+    e = buscar(f, h, chave, (size_t)tam);
+    if (e) {
+        size_t n = strlen(e->saida) + 1;
+        e->referenciada = 1;
+        f->acertos++;
+        *valor = e->valor;
+        *ehPos = e->ehPos;
+        *saida = (char*)malloc(n);
+        if (*saida) memcpy(*saida, e->saida, n);
+        pthread_mutex_unlock(&f->mtx);
+        if (chave != local) free(chave);
+        return *saida ? 0 : -1;
+    }
+    f->falhas++;
+    pthread_mutex_unlock(&f->mtx);
+
+    /* a chave tem os mesmos tokens da entrada: o resultado é o mesmo */
+    r = processarExpressao(entrada, saida, valor, ehPos);
+    if (r == 0 && *saida) {
+        size_t tamSaida = strlen(*saida) + 1;
+        size_t bytes = sizeof(EntradaCache) + (size_t)tam + tamSaida;
+        e = (EntradaCache*)malloc(bytes);
+        if (e) {
+            memset(e, 0, sizeof(*e));
+            e->hash = h;
+            e->tamChave = (size_t)tam;
+            e->bytes = bytes;
+            e->valor = *valor;
+            e->ehPos = *ehPos;
+            memcpy(e->chave, chave, (size_t)tam);
+            e->saida = e->chave + tam;
+            memcpy(e->saida, *saida, tamSaida);
+            pthread_mutex_lock(&f->mtx);
+            /* outra thread pode ter inserido a mesma chave enquanto calculávamos */
+            if (buscar(f, h, chave, (size_t)tam) || inserir(f, e) != 0) free(e);
+            pthread_mutex_unlock(&f->mtx);
+        }
+    }
+    if (chave != local) free(chave);
+    return r;
+}
+
+void estatisticasCache(CacheExpressoes *cache, EstatisticasCache *est) {
+    int i;
+    if (!est) return;
+    memset(est, 0, sizeof(*est));
+    if (!cache) return;
+    est->orcamento = cache->orcamento;
+    for (i = 0; i < cache->nFatias; ++i) {
+        FatiaCache *f = &cache->fatias[i];
+        pthread_mutex_lock(&f->mtx);
+        est->acertos += f->acertos;
+        est->falhas += f->falhas;
+        est->remocoes += f->remocoes;
+        est->entradas += (size_t)f->nAnel;
+        est->bytes += f->bytes;
+        pthread_mutex_unlock(&f->mtx);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef CACHE_H
+#define CACHE_H
+#include <stddef.h>
+
+/*
+ * Cache de resultados de processarExpressao, seguro para várias threads.
+ * A chave é a sequência de tokens da entrada separados por um espaço, então
+ * "3+4*5" e "3 + 4 * 5" caem na mesma entrada. As entradas ficam espalhadas
+ * em fatias, cada uma com seu mutex, tabela hash e remoção pelo algoritmo
+ * do relógio (CLOCK) quando a fatia passa da sua parte do orçamento.
+ */
+typedef struct CacheExpressoes CacheExpressoes;
+
+typedef struct {
+    unsigned long long acertos;
+    unsigned long long falhas;
+    unsigned long long remocoes;
+    size_t entradas;
+    size_t bytes;      // memória ocupada pelas entradas
+    size_t orcamento;
+} EstatisticasCache;
+
+/* orcamento: bytes máximos somando todas as fatias; nFatias <= 0 escolhe pelo número de núcleos */
+CacheExpressoes *criarCacheExpressoes(size_t orcamento, int nFatias);
+void destruirCacheExpressoes(CacheExpressoes *cache);
+
+/* Mesmo contrato de processarExpressao (*saida é malloc); cache NULL só repassa. */
+int processarExpressaoCache(CacheExpressoes *cache, const char *entrada, char **saida, float *valor, int *ehPos);
+
+void estatisticasCache(CacheExpressoes *cache, EstatisticasCache *est);
+#endif
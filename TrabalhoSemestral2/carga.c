@@ -0,0 +1,453 @@
+/* carga.c - gerador de carga para o servidor de expressões */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "carga.h"
+
+void configCargaPadrao(ConfigCarga *cfg) {
+    cfg->caminhoUnix = NULL;
+    cfg->porta = 0;
+    cfg->conexoes = 64;
+    cfg->pipeline = 16;
+    cfg->pedidos = 200000;
+    cfg->threads = 1;
+    cfg->threadsServidor = 0;
+    cfg->quantidade = 1000;
+    cfg->semente = 1;
+}
+
+int lerConfigCarga(int argc, char **argv, ConfigCarga *cfg) {
+    int i;
+    for (i = 0; i + 1 < argc; i += 2) {
+        const char *op = argv[i], *v = argv[i+1];
+        if (strcmp(op, "--unix") == 0) cfg->caminhoUnix = v;
+        else if (strcmp(op, "--porta") == 0) cfg->porta = atoi(v);
+        else if (strcmp(op, "--conexoes") == 0) cfg->conexoes = atoi(v);
+        else if (strcmp(op, "--pipeline") == 0) cfg->pipeline = atoi(v);
+        else if (strcmp(op, "--pedidos") == 0) cfg->pedidos = atol(v);
+        else if (strcmp(op, "--threads") == 0) cfg->threads = atoi(v);
+        else if (strcmp(op, "--threads-servidor") == 0) cfg->threadsServidor = atoi(v);
+        else if (strcmp(op, "--quantidade") == 0) cfg->quantidade = atoi(v);
+        else if (strcmp(op, "--semente") == 0) cfg->semente = (unsigned)strtoul(v, NULL, 10);
+        else return -1;
+    }
+    if (i != argc) return -1;
+    if (cfg->porta < 0 || cfg->porta > 65535 || cfg->conexoes < 1 || cfg->pipeline < 1 ||
+        cfg->pedidos < 1 || cfg->threads < 1 || cfg->quantidade < 1) return -1;
+    return 0;
+}
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "expressao.h"
+#include "benchmark.h"
+#include "estatisticas.h"
+#include "servidor.h"
+
+#define MAX_EVENTOS 256
+#define TAM_LEITURA 4096       // espaço livre garantido antes de cada leitura
+#define TAM_CABECALHO 4
+#define ESPERA_MAXIMA_MS 10000  // sem nenhuma resposta nesse tempo, desiste
+
+/* pedido e resposta esperada já com o cabeçalho de tamanho */
+typedef struct {
+    char *pedido;
+    size_t tamPedido;
+    char *resposta;
+    size_t tamResposta;
+} ItemCorpus;
+
+typedef struct {
+    int fd;
+    unsigned eventos;
+    long cota;            // pedidos desta conexão
+    long enviados, recebidos;
+    int *itens;           // fila circular dos pedidos em voo: item do corpus e hora do envio
+    long long *horas;
+    char *saida;
+    size_t enviado, tamSaida, capSaida;
+    char *entrada;
+    size_t ini, tam, cap;
+} ConexaoCarga;
+
+typedef struct {
+    const ConfigCarga *cfg;
+    const ItemCorpus *corpus;
+    struct sockaddr_storage end;
+    socklen_t tamEnd;
+    int primeira, nConexoes;   // fatia das conexões
+    long long *latencias;      // uma por pedido da fatia
+    long nLatencias;
+    long erros, divergentes;
+    unsigned proximo;          // próximo item do corpus
+    pthread_t thread;
+} ThreadCarga;
+
+static unsigned lerTamanho(const char *p) {
+    unsigned n;
+    memcpy(&n, p, TAM_CABECALHO);
+    return ntohl(n);
+}
+
+static char *montarQuadro(const char *texto, size_t n, size_t *tam) {
+    char *q = (char*)malloc(TAM_CABECALHO + n);
+    unsigned v = htonl((unsigned)n);
+    if (!q) return NULL;
+    memcpy(q, &v, TAM_CABECALHO);
+    memcpy(q + TAM_CABECALHO, texto, n);
+    *tam = TAM_CABECALHO + n;
+    return q;
+}
+
+/* as mesmas expressões do benchmark; a resposta esperada sai de processarExpressao */
+static int montarCorpus(const ConfigCarga *cfg, ItemCorpus *corpus) {
+    ConfigBenchmark cb;
+    unsigned semente = cfg->semente;
+    int i;
+    configBenchmarkPadrao(&cb);
+    cb.profundidade = 3;
+    for (i = 0; i < cfg->quantidade; ++i) {
+        char *in, *pos, *saida = NULL, texto[64];
+        const char *expr;
+        float valor;
+        int ehPos, r, n;
+        if (gerarExpressao(&cb, &semente, &in, &pos) != 0) return -1;
+        expr = (i & 1) ? pos : in;
+        corpus[i].pedido = montarQuadro(expr, strlen(expr), &corpus[i].tamPedido);
+        r = processarExpressao(expr, &saida, &valor, &ehPos);
+        free(in);
+        free(pos);
+        if (r == 0) {
+            char *linha;
+            n = snprintf(texto, sizeof(texto), "\t%.6f", valor);
+            linha = (char*)malloc(strlen(saida) + (size_t)n + 1);
+            if (linha) {
+                strcpy(linha, saida);
+                strcat(linha, texto);
+                corpus[i].resposta = montarQuadro(linha, strlen(linha), &corpus[i].tamResposta);
+                free(linha);
+            }
+        } else {
+            corpus[i].resposta = montarQuadro("ERRO", 4, &corpus[i].tamResposta);
+        }
+        free(saida);
+        if (!corpus[i].pedido || !corpus[i].resposta) return -1;
+    }
+    return 0;
+}
+
+static int crescer(char **buf, size_t *cap, size_t minimo) {
+    size_t novo = *cap ? *cap : TAM_LEITURA;
+    char *p;
+    if (minimo <= *cap) return 0;
+    while (novo < minimo) novo *= 2;
+    p = (char*)realloc(*buf, novo);
+    if (!p) return -1;
+    *buf = p;
+    *cap = novo;
+    return 0;
+}
+
+static int conectar(ThreadCarga *t) {
+    int fd = socket(t->end.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&t->end, t->tamEnd) != 0 ||
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (t->end.ss_family == AF_INET) {
+        int um = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+    }
+    return fd;
+}
+
+/* completa a janela de pedidos em voo da conexão */
+static int encher(ThreadCarga *t, ConexaoCarga *c) {
+    long long agora = relogioNs();
+    while (c->enviados < c->cota && c->enviados - c->recebidos < t->cfg->pipeline) {
+        int item = (int)(t->proximo++ % (unsigned)t->cfg->quantidade);
+        const ItemCorpus *it = &t->corpus[item];
+        int k = (int)(c->enviados % t->cfg->pipeline);
+        if (crescer(&c->saida, &c->capSaida, c->tamSaida + it->tamPedido) != 0) return -1;
+        memcpy(c->saida + c->tamSaida, it->pedido, it->tamPedido);
+        c->tamSaida += it->tamPedido;
+        c->itens[k] = item;
+        c->horas[k] = agora;
+        c->enviados++;
+    }
+    return 0;
+}
+
+static int enviar(ConexaoCarga *c) {
+    while (c->enviado < c->tamSaida) {
+        ssize_t r = send(c->fd, c->saida + c->enviado, c->tamSaida - c->enviado, MSG_NOSIGNAL);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        c->enviado += (size_t)r;
+    }
+    c->enviado = c->tamSaida = 0;
+    return 0;
+}
+
+/* lê o que chegou e confere as respostas completas; -1 se a conexão caiu */
+static int receber(ThreadCarga *t, ConexaoCarga *c) {
+    long long agora;
+    ssize_t r;
+    if (crescer(&c->entrada, &c->cap, c->tam + TAM_LEITURA) != 0) return -1;
+    r = recv(c->fd, c->entrada + c->tam, c->cap - c->tam, 0);
+    if (r == 0) return -1;
+    if (r < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    c->tam += (size_t)r;
+    agora = relogioNs();
+    while (c->tam - c->ini >= TAM_CABECALHO) {
+        size_t n = lerTamanho(c->entrada + c->ini);
+        int k = (int)(c->recebidos % t->cfg->pipeline);
+        const ItemCorpus *it;
+        if (c->tam - c->ini - TAM_CABECALHO < n) break;
+        if (c->recebidos == c->enviados) return -1; // resposta sem pedido
+        it = &t->corpus[c->itens[k]];
+        if (it->tamResposta != TAM_CABECALHO + n ||
+            memcmp(it->resposta, c->entrada + c->ini, it->tamResposta) != 0) t->divergentes++;
+        t->latencias[t->nLatencias++] = agora - c->horas[k];
+        c->recebidos++;
+        c->ini += TAM_CABECALHO + n;
+    }
+    memmove(c->entrada, c->entrada + c->ini, c->tam - c->ini);
+    c->tam -= c->ini;
+    c->ini = 0;
+    return 0;
+}
+
+static void *executarThread(void *arg) {
+    ThreadCarga *t = (ThreadCarga*)arg;
+    const ConfigCarga *cfg = t->cfg;
+    ConexaoCarga *cs = (ConexaoCarga*)calloc((size_t)t->nConexoes, sizeof(ConexaoCarga));
+    struct epoll_event evs[MAX_EVENTOS];
+    int ep = epoll_create1(EPOLL_CLOEXEC), i, abertas = 0;
+
+    if (!cs || ep < 0) { t->erros += t->nConexoes; goto fim; }
+    for (i = 0; i < t->nConexoes; ++i) {
+        ConexaoCarga *c = &cs[i];
+        struct epoll_event ev;
+        int g = t->primeira + i;
+        c->fd = -1;
+        c->cota = cfg->pedidos / cfg->conexoes + (g < cfg->pedidos % cfg->conexoes ? 1 : 0);
+        if (c->cota == 0) continue;
+        c->itens = (int*)malloc(sizeof(int) * (size_t)cfg->pipeline);
+        c->horas = (long long*)malloc(sizeof(long long) * (size_t)cfg->pipeline);
+        if (!c->itens || !c->horas || (c->fd = conectar(t)) < 0) {
+            t->erros++;
+            continue;
+        }
+        /* os primeiros pedidos saem no laço, para a hora do envio não incluir as outras conexões */
+        memset(&ev, 0, sizeof(ev));
+        c->eventos = EPOLLIN | EPOLLOUT;
+        ev.events = c->eventos;
+        ev.data.ptr = c;
+        if (epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev) != 0) { t->erros++; continue; }
+        abertas++;
+    }
+
+    while (abertas > 0) {
+        int n = epoll_wait(ep, evs, MAX_EVENTOS, ESPERA_MAXIMA_MS);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) { t->erros += abertas; break; }
+        for (i = 0; i < n; ++i) {
+            ConexaoCarga *c = (ConexaoCarga*)evs[i].data.ptr;
+            int ok = !(evs[i].events & EPOLLERR);
+            unsigned eventos;
+            if (ok && (evs[i].events & (EPOLLIN | EPOLLHUP))) ok = (receber(t, c) == 0);
+            if (ok) ok = (encher(t, c) == 0 && enviar(c) == 0);
+            if (ok && c->recebidos == c->cota) {
+                close(c->fd);
+                c->fd = -1;
+                abertas--;
+                continue;
+            }
+            if (!ok) {
+                close(c->fd);
+                c->fd = -1;
+                abertas--;
+                t->erros++;
+                continue;
+            }
+            eventos = EPOLLIN | (c->tamSaida > 0 ? EPOLLOUT : 0);
+            if (eventos != c->eventos) {
+                struct epoll_event ev;
+                memset(&ev, 0, sizeof(ev));
+                ev.events = eventos;
+                ev.data.ptr = c;
+                epoll_ctl(ep, EPOLL_CTL_MOD, c->fd, &ev);
+                c->eventos = eventos;
+            }
+        }
+    }
+
+fim:
+    if (cs) {
+        for (i = 0; i < t->nConexoes; ++i) {
+            if (cs[i].fd >= 0) close(cs[i].fd);
+            free(cs[i].itens);
+            free(cs[i].horas);
+            free(cs[i].saida);
+            free(cs[i].entrada);
+        }
+        free(cs);
+    }
+    if (ep >= 0) close(ep);
+    return NULL;
+}
+
+static int compararLongLong(const void *a, const void *b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+static long long percentil(const long long *ordenado, long n, int pormil) {
+    long i = (n * pormil + 999) / 1000;
+    return n > 0 ? ordenado[i > 0 ? i - 1 : 0] : 0;
+}
+
+static void *rodarServidor(void *s) {
+    executarServidor((ServidorExpressoes*)s);
+    return NULL;
+}
+
+int executarCarga(const ConfigCarga *cfg, FILE *saida) {
+    ItemCorpus *corpus = (ItemCorpus*)calloc((size_t)cfg->quantidade, sizeof(ItemCorpus));
+    ThreadCarga *ts = (ThreadCarga*)calloc((size_t)cfg->threads, sizeof(ThreadCarga));
+    long long *latencias = (long long*)malloc(sizeof(long long) * (size_t)cfg->pedidos);
+    ServidorExpressoes *servidor = NULL;
+    pthread_t threadServidor;
+    struct sockaddr_storage end;
+    socklen_t tamEnd;
+    long erros = 0, divergentes = 0, n = 0, base = 0;
+    long long t0, total;
+    int i, criadas = 0, ok = 0;
+
+    if (!corpus || !ts || !latencias || montarCorpus(cfg, corpus) != 0) goto fim;
+    aumentarLimiteDescritores();
+
+    memset(&end, 0, sizeof(end));
+    if (cfg->caminhoUnix) {
+        struct sockaddr_un *un = (struct sockaddr_un*)&end;
+        if (strlen(cfg->caminhoUnix) >= sizeof(un->sun_path)) goto fim;
+        un->sun_family = AF_UNIX;
+        strcpy(un->sun_path, cfg->caminhoUnix);
+        tamEnd = sizeof(*un);
+    } else {
+        struct sockaddr_in *in = (struct sockaddr_in*)&end;
+        int porta = cfg->porta;
+        if (porta == 0) {
+            ConfigServidor cs;
+            configServidorPadrao(&cs);
+            cs.porta = 0;
+            cs.threads = cfg->threadsServidor;
+            servidor = criarServidor(&cs);
+            if (!servidor) goto fim;
+            if (pthread_create(&threadServidor, NULL, rodarServidor, servidor) != 0) {
+                destruirServidor(servidor);
+                servidor = NULL;
+                goto fim;
+            }
+            porta = portaServidor(servidor);
+        }
+        in->sin_family = AF_INET;
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        in->sin_port = htons((unsigned short)porta);
+        tamEnd = sizeof(*in);
+    }
+
+    /* cada thread fica com uma fatia contínua das conexões e dos pedidos */
+    for (i = 0; i < cfg->threads; ++i) {
+        ThreadCarga *t = &ts[i];
+        int c;
+        t->cfg = cfg;
+        t->corpus = corpus;
+        t->end = end;
+        t->tamEnd = tamEnd;
+        t->primeira = (int)((long)cfg->conexoes * i / cfg->threads);
+        t->nConexoes = (int)((long)cfg->conexoes * (i + 1) / cfg->threads) - t->primeira;
+        t->latencias = latencias + base;
+        t->proximo = (unsigned)t->primeira * 7919u; // threads começam em pontos diferentes do corpus
+        for (c = t->primeira; c < t->primeira + t->nConexoes; ++c)
+            base += cfg->pedidos / cfg->conexoes + (c < cfg->pedidos % cfg->conexoes ? 1 : 0);
+    }
+    t0 = relogioNs();
+    for (criadas = 0; criadas < cfg->threads; ++criadas)
+        if (pthread_create(&ts[criadas].thread, NULL, executarThread, &ts[criadas]) != 0) break;
+    for (i = 0; i < criadas; ++i) pthread_join(ts[i].thread, NULL);
+    total = relogioNs() - t0;
+    if (criadas < cfg->threads) goto fim;
+
+    /* junta as latências das threads no começo do vetor */
+    for (i = 0; i < cfg->threads; ++i) {
+        memmove(latencias + n, ts[i].latencias, sizeof(long long) * (size_t)ts[i].nLatencias);
+        n += ts[i].nLatencias;
+        erros += ts[i].erros;
+        divergentes += ts[i].divergentes;
+    }
+    qsort(latencias, (size_t)n, sizeof(long long), compararLongLong);
+    fprintf(saida,
+            "{\"carga\":{\"conexoes\":%d,\"pipeline\":%d,\"threads\":%d,\"pedidos\":%ld,\"respostas\":%ld,"
+            "\"erros\":%ld,\"divergentes\":%ld,\"ns_total\":%lld,\"por_segundo\":%.0f,"
+            "\"p50_ns\":%lld,\"p99_ns\":%lld,\"p999_ns\":%lld}}\n",
+            cfg->conexoes, cfg->pipeline, cfg->threads, cfg->pedidos, n, erros, divergentes, total,
+            total > 0 ? (double)n * 1e9 / (double)total : 0.0,
+            percentil(latencias, n, 500), percentil(latencias, n, 990), percentil(latencias, n, 999));
+    if (servidor) {
+        EstatisticasServidor est;
+        estatisticasServidor(servidor, &est);
+        fprintf(saida,
+                "{\"servidor\":{\"conexoes\":%llu,\"pedidos\":%llu,\"lotes\":%llu,\"pedidos_por_lote\":%.1f,"
+                "\"maior_lote\":%llu,\"bytes_recebidos\":%llu,\"bytes_enviados\":%llu}}\n",
+                est.conexoes, est.pedidos, est.lotes,
+                est.lotes ? (double)est.pedidos / (double)est.lotes : 0.0,
+                est.maiorLote, est.bytesRecebidos, est.bytesEnviados);
+    }
+    ok = (erros == 0 && divergentes == 0 && n == cfg->pedidos);
+
+fim:
+    if (servidor) {
+        pararServidor(servidor);
+        pthread_join(threadServidor, NULL);
+        destruirServidor(servidor);
+    }
+    if (corpus) {
+        for (i = 0; i < cfg->quantidade; ++i) {
+            free(corpus[i].pedido);
+            free(corpus[i].resposta);
+        }
+        free(corpus);
+    }
+    free(ts);
+    free(latencias);
+    return ok ? 0 : -1;
+}
+
+#else /* sem epoll */
+
+int executarCarga(const ConfigCarga *cfg, FILE *saida) {
+    (void)cfg;
+    (void)saida;
+    return -1;
+}
+
+#endif
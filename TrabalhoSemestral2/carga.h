@@ -0,0 +1,39 @@
+#ifndef CARGA_H
+#define CARGA_H
+#include <stdio.h>
+
+/*
+ * Gerador de carga para o servidor (servidor.h). Abre várias conexões,
+ * mantém até "pipeline" pedidos em voo em cada uma e confere cada resposta
+ * com o resultado de processarExpressao calculado antes, no próprio
+ * processo. As expressões vêm do gerador do benchmark (metade infixa,
+ * metade pós-fixa). Sem endereço (caminhoUnix NULL e porta 0), sobe um
+ * servidor no próprio processo numa porta livre, então roda sem nada
+ * além deste executável.
+ */
+typedef struct {
+    const char *caminhoUnix;  // servidor a testar
+    int porta;                // TCP no 127.0.0.1
+    int conexoes;
+    int pipeline;             // pedidos em voo por conexão
+    long pedidos;             // total, dividido entre as conexões
+    int threads;              // threads do gerador, cada uma com parte das conexões
+    int threadsServidor;      // servidor no próprio processo (<= 0: um por núcleo)
+    int quantidade;           // expressões distintas no corpus
+    unsigned semente;
+} ConfigCarga;
+
+void configCargaPadrao(ConfigCarga *cfg);
+
+/* Lê "--opcao valor" de argv[0..argc) (ver main.c). Retorna 0 ou -1 se houver opção inválida. */
+int lerConfigCarga(int argc, char **argv, ConfigCarga *cfg);
+
+/*
+ * Executa a carga e escreve uma linha JSON com pedidos, erros, respostas
+ * divergentes, vazão e latências p50/p99/p999 em ns (da escrita do pedido à
+ * chegada da resposta); com servidor próprio, mais uma com as estatísticas
+ * dele (lotes e pedidos por lote). Retorna 0, ou -1 se houve erro de
+ * conexão ou resposta divergente.
+ */
+int executarCarga(const ConfigCarga *cfg, FILE *saida);
+#endif
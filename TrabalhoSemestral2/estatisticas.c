@@ -0,0 +1,93 @@
+/* estatisticas.c - contadores opcionais do processamento (compilar com -DESTATISTICAS) */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "estatisticas.h"
+
+static const char *nomesEstagios[] = {
+    "tokenizar", "detectar", "infixa_posfixa", "posfixa_infixa", "juntar", "avaliar", "processar"
+};
+
+long long relogioNs(void) {
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (long long)((double)c.QuadPart * 1e9 / (double)f.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+#ifdef ESTATISTICAS
+
+EstatisticasExpressao estGlobais;
+
+void estSomar(unsigned long long *contador, unsigned long long v) {
+    __atomic_fetch_add(contador, v, __ATOMIC_RELAXED);
+}
+
+void estPico(unsigned long long *pico, unsigned long long v) {
+    unsigned long long atual = __atomic_load_n(pico, __ATOMIC_RELAXED);
+    while (v > atual && !__atomic_compare_exchange_n(pico, &atual, v, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void estRegistrarEstagio(int estagio, long long ns) {
+    estSomar(&estGlobais.chamadas[estagio], 1);
+    estSomar(&estGlobais.ns[estagio], (unsigned long long)ns);
+}
+
+int estatisticasDisponiveis(void) {
+    return 1;
+}
+
+/* a estrutura só tem contadores unsigned long long: percorre como vetor */
+void capturarEstatisticas(EstatisticasExpressao *est, int zerar) {
+    unsigned long long *orig = (unsigned long long*)&estGlobais;
+    unsigned long long *dest = (unsigned long long*)est;
+    size_t i, n = sizeof(EstatisticasExpressao) / sizeof(unsigned long long);
+    for (i = 0; i < n; ++i) {
+        dest[i] = zerar ? __atomic_exchange_n(&orig[i], 0ULL, __ATOMIC_RELAXED)
+                        : __atomic_load_n(&orig[i], __ATOMIC_RELAXED);
+    }
+}
+
+void zerarEstatisticas(void) {
+    EstatisticasExpressao descartadas;
+    capturarEstatisticas(&descartadas, 1);
+}
+
+#else
+
+int estatisticasDisponiveis(void) {
+    return 0;
+}
+
+void capturarEstatisticas(EstatisticasExpressao *est, int zerar) {
+    (void)zerar;
+    memset(est, 0, sizeof(*est));
+}
+
+void zerarEstatisticas(void) {
+}
+
+#endif
+
+void imprimirEstatisticas(FILE *saida, const EstatisticasExpressao *est) {
+    int i;
+    fprintf(saida, "{\"tokens\":%llu,\"alocacoes\":%llu,\"bytes_alocados\":%llu,"
+            "\"pico_pilha_valores\":%llu,\"pico_pilha_op\":%llu",
+            est->tokens, est->alocacoes, est->bytesAlocados, est->picoPilhaValores, est->picoPilhaOp);
+    for (i = 0; i < ESTAGIO_QUANTIDADE; ++i) {
+        fprintf(saida, ",\"%s\":{\"chamadas\":%llu,\"ns\":%llu}", nomesEstagios[i], est->chamadas[i], est->ns[i]);
+    }
+    fprintf(saida, "}\n");
+}
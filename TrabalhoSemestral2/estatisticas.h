@@ -0,0 +1,66 @@
+#ifndef ESTATISTICAS_H
+#define ESTATISTICAS_H
+#include <stdio.h>
+
+/*
+ * Contadores de uso do processamento de expressões. Só existem quando o
+ * programa é compilado com -DESTATISTICAS; sem a opção as macros abaixo
+ * não geram código e capturarEstatisticas devolve tudo zerado.
+ * Os contadores são globais e atualizados atomicamente (várias threads).
+ */
+
+/* Etapas medidas; ESTAGIO_PROCESSAR inclui o tempo das demais */
+typedef enum {
+    ESTAGIO_TOKENIZAR,       // tokenizarExpressao
+    ESTAGIO_DETECTAR,        // ehPosfixaTokens
+    ESTAGIO_INFIXA_POSFIXA,  // infixaParaPosfixaTokens
+    ESTAGIO_POSFIXA_INFIXA,  // montagem da infixa a partir da pós-fixa
+    ESTAGIO_JUNTAR,          // texto da pós-fixa/normalizada a partir dos tokens
+    ESTAGIO_AVALIAR,         // valor da pós-fixa
+    ESTAGIO_PROCESSAR,       // processarExpressao e processarExpressaoArena
+    ESTAGIO_QUANTIDADE
+} Estagio;
+
+typedef struct {
+    unsigned long long chamadas[ESTAGIO_QUANTIDADE];
+    unsigned long long ns[ESTAGIO_QUANTIDADE]; // tempo acumulado
+    unsigned long long tokens;        // tokens produzidos pelo analisador léxico
+    unsigned long long alocacoes;     // malloc/realloc (memória de arena não entra)
+    unsigned long long bytesAlocados;
+    unsigned long long picoPilhaValores; // maior altura de PilhaFloat
+    unsigned long long picoPilhaOp;      // maior altura da pilha de operadores
+} EstatisticasExpressao;
+
+int estatisticasDisponiveis(void); // 1 se compilado com -DESTATISTICAS
+
+/* Copia os contadores; com zerar, cada um é lido e zerado na mesma operação */
+void capturarEstatisticas(EstatisticasExpressao *est, int zerar);
+void zerarEstatisticas(void);
+
+/* Uma linha JSON com todos os contadores */
+void imprimirEstatisticas(FILE *saida, const EstatisticasExpressao *est);
+
+long long relogioNs(void); // relógio monotônico em ns
+
+#ifdef ESTATISTICAS
+void estRegistrarEstagio(int estagio, long long ns);
+void estSomar(unsigned long long *contador, unsigned long long v);
+void estPico(unsigned long long *pico, unsigned long long v);
+extern EstatisticasExpressao estGlobais;
+
+#define EST_INICIO(t) long long t = relogioNs()
+#define EST_FIM(estagio, t) estRegistrarEstagio((estagio), relogioNs() - (t))
+#define EST_TOKENS(n) estSomar(&estGlobais.tokens, (unsigned long long)(n))
+#define EST_ALOCACAO(bytes) (estSomar(&estGlobais.alocacoes, 1), estSomar(&estGlobais.bytesAlocados, (unsigned long long)(bytes)))
+#define EST_PICO_VALORES(h) estPico(&estGlobais.picoPilhaValores, (unsigned long long)(h))
+#define EST_PICO_OP(h) estPico(&estGlobais.picoPilhaOp, (unsigned long long)(h))
+#else
+/* sizeof não avalia o argumento: nada é gerado, mas as variáveis contam como usadas */
+#define EST_INICIO(t) ((void)0)
+#define EST_FIM(estagio, t) ((void)0)
+#define EST_TOKENS(n) ((void)sizeof(n))
+#define EST_ALOCACAO(bytes) ((void)sizeof(bytes))
+#define EST_PICO_VALORES(h) ((void)sizeof(h))
+#define EST_PICO_OP(h) ((void)sizeof(h))
+#endif
+#endif
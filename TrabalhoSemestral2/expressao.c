@@ -5,12 +5,16 @@
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
+#include <limits.h>
 
 #include "expressao.h"
+#include "tokens.h"
+#include "estatisticas.h"
+#include "funcoes.h"
+#include "varredura.h"
 
 #define PI_F 3.14159265358979323846f
-#define MAXTOKENS 1024
-#define MAXTOKENLEN 128
+#define PI_D 3.14159265358979323846
 
 char *normalizarInfixa(const char *expr);
 char *infixaParaPosfixaInterna(const char *infixa_tokens); /* retorna malloc */
@@ -23,7 +27,17 @@ int precedenciaToken(const char *tok);
 int detectarPosfixa(const char *entrada);
 int detectaPosFixa(const char *entrada);
 
-static char *minha_strdup(const char *s);
+static void *reservar(Arena *arena, size_t tam);
+static void devolver(Arena *arena, void *p);
+static int lerTokens(const char *texto, size_t tam, ListaTokens *lista);
+static char *juntarTokens(Arena *arena, const char *texto, const Token *toks, int n, int separarSinal);
+static char *posfixaTokensParaInfixa(Arena *arena, const char *texto, const Token *toks, int n, int envolver);
+static float avaliarTokensPosfixa(Arena *arena, const char *texto, const Token *toks, int n);
+static char *escreverJuncao(Arena *arena, const char *texto, const Token *toks, int n, int separarSinal);
+static char *montarInfixa(Arena *arena, const char *texto, const Token *toks, int n, int envolver);
+static float calcularPosfixa(Arena *arena, const char *texto, const Token *toks, int n);
+static int processar(const char *entrada, char **saida, float *valor, int *ehPos);
+static int processarNaArena(const char *entrada, size_t tam, Arena *arena, const char **saida, float *valor, int *ehPos);
 
 float senoAprox(float graus);
 float cossenoAprox(float graus);
@@ -33,118 +47,14 @@ float lnAprox(float x);
 float log10Aprox(float x);
 float aplicarFuncaoUnaria(const char *func, float x);
 
-static int tem_par_externa(const char *s) {
-    if (!s) return 0;
-    if (s[0] != '(') return 0;
-    int nivel = 0;
-    size_t i;
-    size_t L = strlen(s);
-    for (i = 0; i < L; ++i) {
-        if (s[i] == '(') ++nivel;
-        else if (s[i] == ')') {
-            --nivel;
-            if (nivel == 0 && i < L - 1) return 0;
-        }
-    }
-    return (nivel == 0) ? 1 : 0;
-}
-
-static char top_level_high_op(const char *t) {
-    if (!t) return 0;
-    int n = 0; size_t j;
-    for (j = 0; t[j]; ++j) {
-        if (t[j] == '(') ++n;
-        else if (t[j] == ')') --n;
-        else if (n == 0) {
-            if (t[j] == '*' || t[j] == '/' || t[j] == '%' || t[j] == '^') return t[j];
-        }
-    }
-    return 0;
-}
-
-static int left_token_is_func_or_paren(const char *s) {
-    if (!s) return 0;
-    size_t i = 0;
-    while (s[i] && isspace((unsigned char)s[i])) i++;
-    if (!s[i]) return 0;
-    if (s[i] == '(') return 1;
-    if (isalpha((unsigned char)s[i])) return 1;
-    return 0;
-}
-
-static char *ajustar_parenteses_root(char *s) {
-    if (!s) return s;
-    size_t L = strlen(s);
-    int nivel = 0;
-    int pos = -1;
-    size_t i;
-    /* encontra o último '+' ou '-' em nível 0 (divide principal) */
-    for (i = 0; i < L; ++i) {
-        char c = s[i];
-        if (c == '(') ++nivel;
-        else if (c == ')') --nivel;
-        else if (nivel == 0 && (c == '+' || c == '-')) {
-            pos = (int)i; /* manter última ocorrência */
-        }
-    }
-    if (pos < 0) return s;
-    /* separa em dois lados */
-    char *esq = (char*)malloc(pos + 1);
-    if (!esq) return s;
-    memcpy(esq, s, pos);
-    esq[pos] = '\0';
-    char *dir = minha_strdup(s + pos + 1);
-    if (!dir) { free(esq); return s; }
-
-    char opLeft = top_level_high_op(esq);
-    char opRight = top_level_high_op(dir);
-
-    int need_left = (opLeft != 0) && !tem_par_externa(esq);
-    int need_right = (opRight != 0) && !tem_par_externa(dir);
-
-    if (opLeft == '^' && left_token_is_func_or_paren(esq)) need_left = 0;
-    if (opRight == '^' && left_token_is_func_or_paren(dir)) need_right = 0;
-
-    if (!need_left && !need_right) { free(esq); free(dir); return s; }
-
-    /* monta nova string */
-    size_t newlen = strlen(esq) + strlen(dir) + 3 + (need_left?2:0) + (need_right?2:0);
-    char *novo = (char*)malloc(newlen + 1);
-    if (!novo) { free(esq); free(dir); return s; }
-    novo[0] = '\0';
-    if (need_left) { strcat(novo, "("); strcat(novo, esq); strcat(novo, ")"); }
-    else strcat(novo, esq);
-    {
-        size_t p = strlen(novo);
-        novo[p] = s[pos];
-        novo[p+1] = '\0';
-    }
-    if (need_right) { strcat(novo, "("); strcat(novo, dir); strcat(novo, ")"); }
-    else strcat(novo, dir);
-
-    free(esq); free(dir); free(s);
-    return novo;
-}
-
-typedef struct {
-    float itens[256];
-    int topo;
-} PilhaFloat;
-
-static void inicializarPilhaFloat(PilhaFloat *p){p->topo=-1;} static int pilhaFloatVazia(PilhaFloat *p){return p->topo==-1;} static int pilhaFloatCheia(PilhaFloat *p){return p->topo==255;} static void empilharFloat(PilhaFloat *p,float v){if(!pilhaFloatCheia(p))p->itens[++(p->topo)]=v;} static float desempilharFloat(PilhaFloat *p){if(!pilhaFloatVazia(p))return p->itens[(p->topo)--];return 0.0f;}
+/* posições da pilha de valores no vetor local antes de crescer (avaliador_tipo.h) */
+#define PILHA_VALORES_LOCAL 256
 
 int ehNumeroToken(const char *tok) {
     if (!tok || tok[0] == '\0') return 0;
-    int i = 0;
-    if (tok[0] == '-' && tok[1] != '\0') i = 1;
-    int temPonto = 0;
-    for (; tok[i] != '\0'; ++i) {
-        if (tok[i] == '.') {
-            if (temPonto) return 0;
-            temPonto = 1;
-        } else if (!isdigit((unsigned char)tok[i])) return 0;
-    }
-    return 1;
+    size_t n = strlen(tok);
+    size_t i = (tok[0] == '-' && tok[1] != '\0') ? 1 : 0;
+    return (size_t)lerNumero(tok + i, n - i, NULL) == n - i;
 }
 
 int ehOperadorToken(const char *tok) {
@@ -156,14 +66,7 @@ int ehOperadorToken(const char *tok) {
 
 int ehFuncaoToken(const char *tok) {
     if (!tok) return 0;
-    if (strcmp(tok, "sen") == 0) return 1;
-    if (strcmp(tok, "cos") == 0) return 1;
-    if (strcmp(tok, "tg") == 0) return 1;
-    if (strcmp(tok, "log") == 0) return 1;
-    if (strcmp(tok, "log10") == 0) return 1;
-    if (strcmp(tok, "raiz") == 0) return 1;
-    if (strcmp(tok, "sqrt") == 0) return 1;
-    return 0;
+    return idFuncao(tok, (int)strlen(tok)) >= 0;
 }
 
 int precedenciaToken(const char *tok) {
@@ -174,106 +77,141 @@ int precedenciaToken(const char *tok) {
     return 0;
 }
 
+/* posição do texto nas máscaras do bloco em uso, recarregando ao sair dele */
+typedef struct {
+    const char *texto;
+    size_t tam;
+    size_t base; // início do bloco em c
+    ClassesBloco c;
+} Varredura;
+
+static inline int posicaoNoBloco(Varredura *v, size_t i) {
+    if (i - v->base >= TAM_BLOCO_VARREDURA) { // também quando i < base (diferença sem sinal)
+        v->base = i - i % TAM_BLOCO_VARREDURA;
+        classificarBloco(v->texto + v->base, v->tam - v->base, &v->c);
+    }
+    return (int)(i - v->base);
+}
+
+/* primeira posição a partir de i fora dos espaços (ou, com nome, fora de letra/dígito/'_'); tam se não houver */
+static inline size_t pularClasse(Varredura *v, size_t i, int nome) {
+    while (i < v->tam) {
+        int k = posicaoNoBloco(v, i);
+        unsigned long long fora = ~(nome ? v->c.palavra : v->c.espaco) >> k;
+        if (fora) {
+            i += (size_t)primeiroBit(fora);
+            return i < v->tam ? i : v->tam;
+        }
+        i = v->base + TAM_BLOCO_VARREDURA;
+    }
+    return v->tam;
+}
+
+/* tamanho do literal numérico em i, como lerNumero (0 se inválido); dígitos e '.' pelas máscaras */
+static inline int tamanhoNumero(Varredura *v, size_t i) {
+    int k = posicaoNoBloco(v, i), n, pontos;
+    unsigned long long fora = ~(v->c.digito | v->c.ponto) >> k;
+    /* passa do bloco ou tem expoente: lerNumero decide */
+    if (!fora) return lerNumero(v->texto + i, v->tam - i, NULL);
+    n = primeiroBit(fora);
+    if (i + (size_t)n < v->tam && (v->texto[i + n] | 0x20) == 'e') return lerNumero(v->texto + i, v->tam - i, NULL);
+    pontos = contarBits((v->c.ponto >> k) & ((1ULL << n) - 1)); // n < 64: fora tem bit em [0, 64 - k)
+    return (pontos > 1 || pontos == n) ? 0 : n;
+}
+
+/* cópia de um token curto como um movimento de 16 bytes, se houver folga na entrada (a saída tem) */
+static inline void copiarToken(char *dst, const Varredura *v, const char *src, size_t n) {
+    if (n <= 16 && (size_t)(src - v->texto) + 16 <= v->tam) memcpy(dst, src, 16);
+    else memcpy(dst, src, n);
+}
+
+/*
+ * Tokens separados por um espaço, numa passada só: as classes de cada
+ * bloco de 64 bytes vêm em máscaras (varredura.h), então espaços, nomes e
+ * números são pulados e copiados por trechos, e a saída é escrita direto,
+ * sem lista de tokens. As regras são as de tokenizarExpressao: '-' colado
+ * a um número é sinal no início, depois de '(' ',' ou operador; depois de
+ * um valor e de espaço ("3 -4") sai separado como "- 4". NULL em
+ * caractere ou número inválido.
+ */
 char *normalizarInfixa(const char *expr) {
+    Varredura v;
+    size_t i = 0, w = 0;
+    int esperaValor = 1, depoisDeEspaco = 1;
+    char *out;
     if (!expr) return NULL;
-    size_t n = strlen(expr);
-    size_t cap = n * 3 + 16;
-    char *tmp = (char*)malloc(cap);
-    if (!tmp) return NULL;
-    size_t w = 0;
-    char last = '\0';
-    size_t i;
-    for (i = 0; i < n; ++i) {
-        char c = expr[i];
-        if (c == ' ' || c == '\t') continue;
-        if (isalpha((unsigned char)c)) {
-            char nome[MAXTOKENLEN];
-            int p = 0;
-            while (i < n && isalpha((unsigned char)expr[i]) && p + 1 < MAXTOKENLEN) {
-                nome[p++] = expr[i++];
-            }
-            nome[p] = '\0';
-            --i;
-            if (w > 0 && tmp[w-1] != ' ') tmp[w++] = ' ';
-            strcpy(tmp + w, nome);
-            w += (int)strlen(nome);
-            tmp[w++] = ' ';
-            last = 'a';
-            continue;
-        }
-        /* sinal unário '-' antes de número */
-        if (c == '-' && i + 1 < n && (isdigit((unsigned char)expr[i+1]) || expr[i+1] == '.')) {
-            if (last == '\0' || last == '(' || last == '+' || last == '-' ||
-                last == '*' || last == '/' || last == '%' || last == '^') {
-                tmp[w++] = '-';
-                last = '-';
-                continue;
-            }
-        }
-        if (c == '(' || c == ')') {
-            if (w > 0 && tmp[w-1] != ' ') tmp[w++] = ' ';
-            tmp[w++] = c;
-            tmp[w++] = ' ';
-            last = c;
-            continue;
-        }
-        if (strchr("+-*/%^", c)) {
-            if (w > 0 && tmp[w-1] != ' ') tmp[w++] = ' ';
-            tmp[w++] = c;
-            tmp[w++] = ' ';
-            last = c;
-            continue;
+    v.texto = expr;
+    v.tam = strlen(expr);
+    if (v.tam > (size_t)INT_MAX) return NULL;
+    v.base = 0;
+    classificarBloco(expr, v.tam, &v.c);
+    /* cada token sai com no máximo um espaço a mais ("- num" usa o espaço que havia antes),
+       mais a folga de copiarToken */
+    out = (char*)reservar(NULL, 2 * v.tam + 17);
+    if (!out) return NULL;
+    for (;;) {
+        unsigned long long bit;
+        const char *ini;
+        size_t j;
+        if (i >= v.tam) break;
+        bit = 1ULL << posicaoNoBloco(&v, i);
+        if (v.c.espaco & bit) {
+            i = pularClasse(&v, i + 1, 0);
+            depoisDeEspaco = 1;
+            if (i >= v.tam) break;
+            bit = 1ULL << posicaoNoBloco(&v, i);
         }
-        /* dígitos e ponto */
-        tmp[w++] = c;
-        last = c;
-    }
-    tmp[w] = '\0';
-
-    /* compacta espaços sequenciais */
-    char *out = (char*)malloc(w + 1);
-    if (!out) { free(tmp); return NULL; }
-    size_t r = 0;
-    int in_space = 0;
-    for (i = 0; i < w; ++i) {
-        char c = tmp[i];
-        if (c == ' ') {
-            if (!in_space && r > 0) { out[r++] = ' '; in_space = 1; }
+        ini = expr + i;
+        if (w > 0) out[w++] = ' ';
+        if ((v.c.palavra & ~v.c.digito) & bit) {
+            j = pularClasse(&v, i + 1, 1);
+            esperaValor = 0;
+        } else if ((v.c.digito | v.c.ponto) & bit) {
+            int n = tamanhoNumero(&v, i);
+            if (n == 0) goto erro;
+            j = i + (size_t)n;
+            esperaValor = 0;
+        } else if (!(v.c.simbolo & bit)) {
+            goto erro;
+        } else if (*ini == '(' || *ini == ')' || *ini == ',') {
+            j = i + 1;
+            esperaValor = (*ini != ')');
         } else {
-            out[r++] = c;
-            in_space = 0;
+            int n = 0;
+            if (*ini == '-' && i + 1 < v.tam && (isdigit((unsigned char)ini[1]) || ini[1] == '.') &&
+                (esperaValor || depoisDeEspaco)) {
+                n = tamanhoNumero(&v, i + 1);
+                if (n == 0) goto erro;
+            }
+            j = i + 1 + (size_t)n;
+            if (n > 0 && !esperaValor) {
+                /* ambíguo depois de um valor: '-' binário */
+                out[w++] = '-';
+                out[w++] = ' ';
+                ++ini;
+                ++i;
+            }
+            esperaValor = (n == 0);
         }
+        copiarToken(out + w, &v, ini, j - i);
+        w += j - i;
+        i = j;
+        depoisDeEspaco = 0;
     }
-    if (r > 0 && out[r-1] == ' ') r--;
-    out[r] = '\0';
-    free(tmp);
+    out[w] = '\0';
     return out;
+erro:
+    devolver(NULL, out);
+    return NULL;
 }
 
 int detectarPosfixa(const char *entrada) {
     if (!entrada) return 0;
-    char *copia = minha_strdup(entrada);
-    if (!copia) return 0;
-    char *tok = strtok(copia, " ");
-    int contador = 0;
-    int valido = 1;
-    while (tok && valido) {
-        if (ehNumeroToken(tok)) {
-            contador++;
-        } else if (ehFuncaoToken(tok)) {
-            if (contador < 1) { valido = 0; break; }
-            /* função mantém contador (consome 1 empilha 1) */
-        } else if (ehOperadorToken(tok)) {
-            if (contador < 2) { valido = 0; break; }
-            contador -= 1; /* consome 2 empilha 1 */
-        } else {
-            valido = 0;
-            break;
-        }
-        tok = strtok(NULL, " ");
-    }
-    free(copia);
-    return (valido && contador == 1) ? 1 : 0;
+    ListaTokens toks;
+    inicializarListaTokens(&toks);
+    int r = (lerTokens(entrada, strlen(entrada), &toks) == 0) && ehPosfixaTokens(toks.itens, toks.quantidade);
+    liberarListaTokens(&toks);
+    return r ? 1 : 0;
 }
 
 int detectaPosFixa(const char *entrada) {
@@ -287,241 +225,39 @@ int detectaPosFixa(const char *entrada) {
 
 char *infixaParaPosfixaInterna(const char *infixa_raw) {
     if (!infixa_raw) return NULL;
-    char *norm = normalizarInfixa(infixa_raw);
-    if (!norm) return NULL;
-    char *copia = minha_strdup(norm);
-    if (!copia) { free(norm); return NULL; }
-
-    /* pilha de operadores */
-    char **pilhaOp = (char**)malloc(sizeof(char*) * MAXTOKENS);
-    if (!pilhaOp) { free(norm); free(copia); return NULL; }
-    int topo = 0;
-
-    /* saída dinâmica */
-    size_t capOut = strlen(norm) * 2 + 32;
-    char *saida = (char*)malloc(capOut);
-    if (!saida) { free(copia); free(norm); free(pilhaOp); return NULL; }
-    saida[0] = '\0';
-    int j = 0;
-
-    char *token = strtok(copia, " ");
-    while (token) {
-        if (ehNumeroToken(token)) {
-            if (j > 0) { saida[j++] = ' '; saida[j] = '\0'; }
-            strcpy(saida + j, token);
-            j += (int)strlen(token);
-        } else if (ehFuncaoToken(token)) {
-            pilhaOp[topo++] = minha_strdup(token); /* duplica */
-            if (!pilhaOp[topo-1]) { /* falha malloc */
-                /* cleanup */
-                int k;
-                for (k = topo-1; k >= 0; --k) free(pilhaOp[k]);
-                free(pilhaOp); free(saida); free(norm); free(copia);
-                return NULL;
-            }
-        } else if (strcmp(token, "(") == 0) {
-            pilhaOp[topo++] = minha_strdup(token);
-            if (!pilhaOp[topo-1]) {
-                int k;
-                for (k = topo-1; k >= 0; --k) free(pilhaOp[k]);
-                free(pilhaOp); free(saida); free(norm); free(copia);
-                return NULL;
-            }
-        } else if (strcmp(token, ")") == 0) {
-            while (topo > 0 && strcmp(pilhaOp[topo-1], "(") != 0) {
-                if (j > 0) { saida[j++] = ' '; saida[j] = '\0'; }
-                strcpy(saida + j, pilhaOp[topo-1]);
-                j += (int)strlen(saida + j);
-                free(pilhaOp[--topo]);
-            }
-            if (topo > 0 && strcmp(pilhaOp[topo-1], "(") == 0) {
-                free(pilhaOp[--topo]); /* remove "(" */
-            }
-            if (topo > 0 && ehFuncaoToken(pilhaOp[topo-1])) {
-                if (j > 0) { saida[j++] = ' '; saida[j] = '\0'; }
-                strcpy(saida + j, pilhaOp[topo-1]);
-                j += (int)strlen(saida + j);
-                free(pilhaOp[--topo]);
-            }
-        } else if (ehOperadorToken(token)) {
-            int prec = precedenciaToken(token);
-            int right_assoc = (strcmp(token, "^") == 0);
-            while (topo > 0 && strcmp(pilhaOp[topo-1], "(") != 0 && !ehFuncaoToken(pilhaOp[topo-1])) {
-                if (ehOperadorToken(pilhaOp[topo-1])) {
-                    int precTop = precedenciaToken(pilhaOp[topo-1]);
-                    if (precTop > prec || (precTop == prec && !right_assoc)) {
-                        if (j > 0) { saida[j++] = ' '; saida[j] = '\0'; }
-                        strcpy(saida + j, pilhaOp[topo-1]);
-                        j += (int)strlen(saida + j);
-                        free(pilhaOp[--topo]);
-                        continue;
-                    }
-                }
-                break;
-            }
-            pilhaOp[topo++] = minha_strdup(token);
-            if (!pilhaOp[topo-1]) {
-                int k;
-                for (k = topo-1; k >= 0; --k) free(pilhaOp[k]);
-                free(pilhaOp); free(saida); free(norm); free(copia);
-                return NULL;
-            }
-        } else {
-            /* desconhecido */
-            int k;
-            for (k = topo-1; k >= 0; --k) free(pilhaOp[k]);
-            free(pilhaOp); free(saida); free(norm); free(copia);
-            return NULL;
-        }
-        token = strtok(NULL, " ");
-    }
-
-    while (topo > 0) {
-        if (j > 0) { saida[j++] = ' '; saida[j] = '\0'; }
-        strcpy(saida + j, pilhaOp[topo-1]);
-        j += (int)strlen(saida + j);
-        free(pilhaOp[--topo]);
+    ListaTokens toks, pos;
+    inicializarListaTokens(&toks);
+    inicializarListaTokens(&pos);
+    char *saida = NULL;
+    if (lerTokens(infixa_raw, strlen(infixa_raw), &toks) == 0 &&
+        infixaParaPosfixaTokens(toks.itens, toks.quantidade, &pos) == 0) {
+        saida = juntarTokens(NULL, infixa_raw, pos.itens, pos.quantidade, 0);
     }
-
-    if (j == 0) saida[0] = '\0';
-    free(pilhaOp);
-    free(norm);
-    free(copia);
+    liberarListaTokens(&toks);
+    liberarListaTokens(&pos);
     return saida;
 }
 
 char *converterPosfixaParaInfixaInterna(const char *posfixa_raw) {
     if (!posfixa_raw) return NULL;
-    char *copia = minha_strdup(posfixa_raw);
-    if (!copia) return NULL;
     /* Detecta parênteses externos envolvendo toda a entrada posfixa */
     int wrap_final = 0;
-    {
-        size_t L = strlen(copia);
-        size_t s = 0;
-        while (s < L && isspace((unsigned char)copia[s])) s++;
-        size_t e = L;
-        while (e > s && isspace((unsigned char)copia[e-1])) e--;
-        if (e - s >= 2 && copia[s] == '(' && copia[e-1] == ')') {
-            /* copia substring [s+1, e-1) */
-            size_t newlen = e - s - 1;
-            char *tmp = (char*)malloc(newlen + 1);
-            if (tmp) {
-                memcpy(tmp, copia + s + 1, newlen - 1);
-                tmp[newlen - 1] = '\0';
-                free(copia);
-                copia = tmp;
-                wrap_final = 1;
-            }
-        }
-    }
-
-    typedef struct {
-        char *str;
-        int prec;
-    } NoExpr;
-
-    NoExpr *pilha = (NoExpr*)malloc(sizeof(NoExpr) * MAXTOKENS);
-    if (!pilha) { free(copia); return NULL; }
-    int topo = 0;
-
-    char *token = strtok(copia, " ");
-    while (token) {
-        if (ehNumeroToken(token)) {
-            pilha[topo].str = minha_strdup(token);
-            if (!pilha[topo].str) { while (topo>0) free(pilha[--topo].str); free(pilha); free(copia); return NULL; }
-            pilha[topo].prec = 100;
-            topo++;
-        } else if (ehFuncaoToken(token)) {
-            if (topo < 1) { while (topo>0) free(pilha[--topo].str); free(pilha); free(copia); return NULL; }
-            char *arg = pilha[--topo].str;
-            size_t len = strlen(token) + 1 + strlen(arg) + 3;
-            char *novo = (char*)malloc(len);
-            if (!novo) { free(arg); while (topo>0) free(pilha[--topo].str); free(pilha); free(copia); return NULL; }
-            sprintf(novo, "%s(%s)", token, arg);
-            free(arg);
-            pilha[topo].str = novo;
-            pilha[topo].prec = 4;
-            topo++;
-        } else if (ehOperadorToken(token)) {
-            if (topo < 2) { while (topo>0) free(pilha[--topo].str); free(pilha); free(copia); return NULL; }
-            char *b = pilha[--topo].str;
-            int precB = pilha[topo].prec;
-            char *a = pilha[--topo].str;
-            int precA = pilha[topo].prec;
-
-            int prioridade = (token[0] == '+' || token[0] == '-') ? 1 : ((token[0] == '*' || token[0] == '/' || token[0] == '%') ? 2 : 3);
-            int is_right_assoc = (token[0] == '^');
-
-            int precisaParEsq = (precA < prioridade) || (precA == prioridade && is_right_assoc);
-            int precisaParDir = (precB < prioridade) || (precB == prioridade && !is_right_assoc);
-
-            
-
-            size_t len = strlen(a) + strlen(b) + 5 + (precisaParEsq?2:0) + (precisaParDir?2:0);
-            char *novo = (char*)malloc(len);
-            if (!novo) { free(a); free(b); while (topo>0) free(pilha[--topo].str); free(pilha); free(copia); return NULL; }
-            novo[0] = '\0';
-            if (precisaParEsq) {
-                if (tem_par_externa(a)) {
-                    strcat(novo, a);
-                } else {
-                    strcat(novo, "(");
-                    strcat(novo, a);
-                    strcat(novo, ")");
-                }
-            } else {
-                strcat(novo, a);
-            }
-            {
-                size_t p = strlen(novo);
-                novo[p] = token[0];
-                novo[p+1] = '\0';
-            }
-            if (precisaParDir) {
-                if (tem_par_externa(b)) {
-                    strcat(novo, b);
-                } else {
-                    strcat(novo, "(");
-                    strcat(novo, b);
-                    strcat(novo, ")");
-                }
-            } else {
-                strcat(novo, b);
-            }
-
-            free(a); free(b);
-            pilha[topo].str = novo;
-            pilha[topo].prec = prioridade;
-            topo++;
-        } else {
-            while (topo>0) free(pilha[--topo].str);
-            free(pilha); free(copia); return NULL;
-        }
-        token = strtok(NULL, " ");
-    }
-
-    if (topo != 1) { while (topo>0) free(pilha[--topo].str); free(pilha); free(copia); return NULL; }
-    char *res = minha_strdup(pilha[0].str);
-    free(pilha[0].str);
-    free(pilha);
-    free(copia);
-
-    if (res && wrap_final) {
-        size_t lr = strlen(res);
-        char *aux = (char*)malloc(lr + 3);
-        if (aux) {
-            aux[0] = '(';
-            memcpy(aux + 1, res, lr);
-            aux[lr+1] = ')';
-            aux[lr+2] = '\0';
-            free(res);
-            res = aux;
-        }
+    size_t L = strlen(posfixa_raw);
+    size_t ini = 0;
+    while (ini < L && isspace((unsigned char)posfixa_raw[ini])) ini++;
+    size_t fim = L;
+    while (fim > ini && isspace((unsigned char)posfixa_raw[fim-1])) fim--;
+    if (fim - ini >= 2 && posfixa_raw[ini] == '(' && posfixa_raw[fim-1] == ')') {
+        ini++;
+        fim--;
+        wrap_final = 1;
     }
 
-     res = ajustar_parenteses_root(res);
-
+    ListaTokens toks;
+    inicializarListaTokens(&toks);
+    if (lerTokens(posfixa_raw + ini, fim - ini, &toks) != 0) { liberarListaTokens(&toks); return NULL; }
+    char *res = posfixaTokensParaInfixa(NULL, posfixa_raw + ini, toks.itens, toks.quantidade, wrap_final);
+    liberarListaTokens(&toks);
     return res;
 }
 
@@ -536,110 +272,438 @@ float lnAprox(float x){return (x<=0.0f)?0.0f:logf(x);}
 float log10Aprox(float x){return (x<=0.0f)?0.0f:log10f(x);} 
 float aplicarFuncaoUnaria(const char *func, float x){
     if (!func) return 0.0f;
-    if (strcmp(func,"sen")==0) return senoAprox(x);
-    if (strcmp(func,"cos")==0) return cossenoAprox(x);
-    if (strcmp(func,"tg")==0) return tangenteAprox(x);
-    if (strcmp(func,"log")==0) return log10Aprox(x);
-    if (strcmp(func,"log10")==0) return log10Aprox(x);
-    if (strcmp(func,"raiz")==0) return raizAprox(x);
-    if (strcmp(func,"sqrt")==0) return raizAprox(x);
-    return 0.0f;
+    return aplicarFuncaoId(idFuncao(func, (int)strlen(func)), x);
+}
+/* a ^ b: expoente inteiro por quadrados sucessivos (lote.c repete a mesma ordem),
+   fracionário ou |b| >= 2^31 por powf; expoente negativo dá 1 / a^|b|, ou 0 se a^|b| for 0 */
+static float potenciaFloat(float a, float b){
+    float acc = 1.0f, base = a;
+    unsigned n;
+    if (!(b == truncf(b) && fabsf(b) < 2147483648.0f)) return (a == 0.0f && b < 0.0f) ? 0.0f : powf(a, b);
+    for (n = (unsigned)fabsf(b); n; n >>= 1) {
+        if (n & 1) acc *= base;
+        base *= base;
+    }
+    if (b < 0.0f) return (acc != 0.0f) ? 1.0f / acc : 0.0f;
+    return acc;
+}
+float aplicarOperadorBinario(char op, float a, float b){
+    float r = 0.0f;
+    switch (op) {
+        case '+': r = a + b; break;
+        case '-': r = a - b; break;
+        case '*': r = a * b; break;
+        case '/': r = (b != 0.0f) ? a / b : 0.0f; break;
+        /* resto dos operandos truncados, como (int)a % (int)b, sem limite de int; divisor 0 dá 0.
+           O + 0.0f troca o -0 de fmodf(-4, 2) pelo 0 da versão inteira. */
+        case '%': r = (truncf(b) != 0.0f) ? fmodf(truncf(a), truncf(b)) + 0.0f : 0.0f; break;
+        case '^': r = potenciaFloat(a, b); break;
+    }
+    return r;
 }
 float getValorPosFixa(char *expr){
     if (!expr) return 0.0f;
-    PilhaFloat p;
-    inicializarPilhaFloat(&p);
-
-    char copia[2048];
-    strncpy(copia, expr, sizeof(copia) - 1);
-    copia[sizeof(copia)-1] = '\0';
-
-    char *token = strtok(copia, " ");
-    while (token) {
-        if (ehNumeroToken(token)) {
-            empilharFloat(&p, (float)atof(token));
-        } else if (ehFuncaoToken(token)) {
-            if (p.topo < 0) return 0.0f;
-            float a = desempilharFloat(&p);
-            empilharFloat(&p, aplicarFuncaoUnaria(token, a));
-        } else if (ehOperadorToken(token)) {
-            if (p.topo < 1) return 0.0f;
-            float b = desempilharFloat(&p);
-            float a = desempilharFloat(&p);
-            float r = 0.0f;
-            switch (token[0]) {
-                case '+': r = a + b; break;
-                case '-': r = a - b; break;
-                case '*': r = a * b; break;
-                case '/': r = (b != 0.0f) ? a / b : 0.0f; break;
-                case '%': r = (float)((int)a % (int)b); break;
-                case '^': {
-                    int e = (int)b;
-                    float acc = 1.0f;
-                    int ii;
-                    if (e >= 0) {
-                        for (ii = 0; ii < e; ++ii) acc *= a;
-                        r = acc;
-                    } else {
-                        for (ii = 0; ii < -e; ++ii) acc *= a;
-                        if (acc != 0.0f) r = 1.0f / acc; else r = 0.0f;
-                    }
-                } break;
-            }
-            empilharFloat(&p, r);
-        } else {
-            return 0.0f;
-        }
-        token = strtok(NULL, " ");
-    }
-
-    if (p.topo < 0) return 0.0f;
-    return desempilharFloat(&p);
+    ListaTokens toks;
+    inicializarListaTokens(&toks);
+    float r = 0.0f;
+    if (tokenizarExpressao(expr, strlen(expr), &toks) == 0) r = avaliarTokensPosfixa(NULL, expr, toks.itens, toks.quantidade);
+    liberarListaTokens(&toks);
+    return r;
 }
 char *getFormaInFixa(char *Str){
     return converterPosfixaParaInfixaInterna(Str);
-}char *infixaParaPosfixa(const char *infixa_raw){return infixaParaPosfixaInterna(infixa_raw);}int processarExpressao(const char *entrada,char **saida,float *valor,int *ehPos){
+}char *infixaParaPosfixa(const char *infixa_raw){return infixaParaPosfixaInterna(infixa_raw);}static int processar(const char *entrada,char **saida,float *valor,int *ehPos){
     if (!entrada || !saida || !valor || !ehPos) return -1;
     *saida = NULL;
     *valor = 0.0f;
     *ehPos = 0;
 
-    /* detecta rápido: se contém parênteses -> infixa */
-    int ehPosDirect = detectaPosFixa(entrada);
+    /* a entrada é lida uma única vez; todas as etapas usam os tokens */
+    ListaTokens toks;
+    inicializarListaTokens(&toks);
+    if (lerTokens(entrada, strlen(entrada), &toks) != 0) { liberarListaTokens(&toks); return -1; }
+
+    if (ehPosfixaTokens(toks.itens, toks.quantidade)) {
+        /* entrada posfixa: converte para infixa legível e calcula */
+        *ehPos = 1;
+        *saida = posfixaTokensParaInfixa(NULL, entrada, toks.itens, toks.quantidade, 0); /* caller deve free */
+        *valor = avaliarTokensPosfixa(NULL, entrada, toks.itens, toks.quantidade);
+        liberarListaTokens(&toks);
+        return 0;
+    }
 
-    char *norm = NULL;
-    if (!ehPosDirect) {
-        norm = normalizarInfixa(entrada);
-        if (!norm) return -1;
-    } else {
-        norm = minha_strdup(entrada);
-        if (!norm) return -1;
+    /* entrada infixa: converte para posfixa e calcula */
+    ListaTokens pos;
+    inicializarListaTokens(&pos);
+    if (infixaParaPosfixaTokens(toks.itens, toks.quantidade, &pos) != 0) {
+        liberarListaTokens(&toks);
+        liberarListaTokens(&pos);
+        return -1;
     }
+    *saida = juntarTokens(NULL, entrada, pos.itens, pos.quantidade, 0); /* caller deve free */
+    if (*saida) *valor = avaliarTokensPosfixa(NULL, entrada, pos.itens, pos.quantidade);
+    liberarListaTokens(&toks);
+    liberarListaTokens(&pos);
+    return *saida ? 0 : -1;
+}
+static int processarNaArena(const char *entrada, size_t tam, Arena *arena, const char **saida, float *valor, int *ehPos){
+    if (!entrada || !arena || !saida || !valor || !ehPos) return -1;
+    *saida = NULL;
+    *valor = 0.0f;
+    *ehPos = 0;
 
-    /* confirmar após normalização */
-    int ehPosFinal = detectarPosfixa(norm) ? 1 : 0;
-    *ehPos = ehPosFinal;
+    ListaTokens toks;
+    inicializarListaTokensArena(&toks, arena);
+    if (lerTokens(entrada, tam, &toks) != 0) return arena->esgotada ? -2 : -1;
 
-    if(ehPosFinal){
-        /* entrada posfixa: converte para infixa legível e calcula */
-        char *infixa = converterPosfixaParaInfixaInterna(norm);
-        if (infixa) {
-            *saida = infixa; /* caller deve free */
+    if (ehPosfixaTokens(toks.itens, toks.quantidade)) {
+        *ehPos = 1;
+        *saida = posfixaTokensParaInfixa(arena, entrada, toks.itens, toks.quantidade, 0);
+        *valor = avaliarTokensPosfixa(arena, entrada, toks.itens, toks.quantidade);
+        return arena->esgotada ? -2 : 0;
+    }
+
+    ListaTokens pos;
+    inicializarListaTokensArena(&pos, arena);
+    if (infixaParaPosfixaTokens(toks.itens, toks.quantidade, &pos) != 0) return arena->esgotada ? -2 : -1;
+    char *saidaPos = juntarTokens(arena, entrada, pos.itens, pos.quantidade, 0);
+    if (!saidaPos) return -2;
+    *saida = saidaPos;
+    *valor = avaliarTokensPosfixa(arena, entrada, pos.itens, pos.quantidade);
+    return arena->esgotada ? -2 : 0;
+}
+/* reservar/devolver: memória da arena quando houver, senão malloc/free */
+static void *reservar(Arena *arena, size_t tam){if(arena)return alocarArena(arena,tam);EST_ALOCACAO(tam);return malloc(tam);}
+static void devolver(Arena *arena, void *p){if(!arena)free(p);}
+/* lerTokens: tokeniza e rejeita nomes que não são funções (não há variáveis aqui) */
+static int lerTokens(const char *texto, size_t tam, ListaTokens *lista){
+    int i;
+    if (tokenizarExpressao(texto, tam, lista) != 0) return -1;
+    for (i = 0; i < lista->quantidade; ++i) {
+        if (lista->itens[i].tipo == TOK_NOME) return -1;
+    }
+    return 0;
+}
+
+/* juntarTokens: texto dos tokens separado por um espaço (malloc ou arena). Com separarSinal,
+   "-num" ambíguo depois de um valor sai como "- num", como na normalização infixa. */
+static char *escreverJuncao(Arena *arena, const char *texto, const Token *toks, int n, int separarSinal){
+    size_t total = 1;
+    int i;
+    for (i = 0; i < n; ++i) total += (size_t)toks[i].tam + 2;
+    char *out = (char*)reservar(arena, total);
+    if (!out) return NULL;
+    size_t w = 0;
+    for (i = 0; i < n; ++i) {
+        const Token *t = &toks[i];
+        if (w > 0) out[w++] = ' ';
+        if (separarSinal && t->ambiguo) {
+            out[w++] = '-';
+            out[w++] = ' ';
+            memcpy(out + w, texto + t->inicio + 1, (size_t)t->tam - 1);
+            w += (size_t)t->tam - 1;
         } else {
-            *saida = NULL;
+            memcpy(out + w, texto + t->inicio, (size_t)t->tam);
+            w += (size_t)t->tam;
         }
-        *valor = getValorPosFixa(norm);
-        free(norm);
-        return 0;
-    } else {
-        /* entrada infixa: converte para posfixa e calcula */
-        char *pos = infixaParaPosfixaInterna(norm);
-        if (!pos) { free(norm); return -1; }
-        *saida = pos; /* caller deve free */
-        *valor = getValorPosFixa(pos);
-        free(norm);
+    }
+    out[w] = '\0';
+    return out;
+}
+
+/* nó da árvore montada a partir da pós-fixa; o índice do nó é o do seu token */
+typedef struct {
+    int esq, dir;                /* filhos; função usa só esq */
+    size_t tam;                  /* tamanho do texto do nó (com parênteses dos filhos) */
+    size_t pos;                  /* onde o texto do nó começa na saída */
+    char altoTopo;               /* primeiro * / % ^ fora de parênteses no texto, ou 0 */
+    unsigned char prec;
+    unsigned char parEsq, parDir;
+    unsigned char comecaFuncPar; /* texto começa com nome de função ou '(' */
+} NoExpr;
+
+static size_t tamanhoOperador(const NoExpr *nos, const NoExpr *no) {
+    return nos[no->esq].tam + nos[no->dir].tam + 1 + (no->parEsq ? 2 : 0) + (no->parDir ? 2 : 0);
+}
+
+/*
+ * posfixaTokensParaInfixa: monta a infixa com parênteses mínimos (malloc ou arena),
+ * NULL se inválida. Uma passada de baixo para cima calcula parênteses e tamanhos;
+ * outra, da raiz para as folhas, escreve cada token direto na posição final.
+ * Na raiz '+'/'-', lados com * / % ^ no topo ganham parênteses para legibilidade
+ * (ex.: (7*2)+4), salvo potência que começa com função ou parêntese. Com envolver,
+ * a saída inteira fica entre parênteses e a raiz não é ajustada.
+ */
+static char *montarInfixa(Arena *arena, const char *texto, const Token *toks, int n, int envolver){
+    if (n <= 0) return NULL;
+    NoExpr *nos = (NoExpr*)reservar(arena, sizeof(NoExpr) * (size_t)n);
+    int *pilha = (int*)reservar(arena, sizeof(int) * (size_t)n);
+    if (!nos || !pilha) { devolver(arena, nos); devolver(arena, pilha); return NULL; }
+    int topo = 0;
+    int i;
+
+    for (i = 0; i < n; ++i) {
+        const Token *t = &toks[i];
+        NoExpr *no = &nos[i];
+        memset(no, 0, sizeof(*no));
+        no->esq = no->dir = -1;
+        if (t->tipo == TOK_NUMERO) {
+            no->tam = (size_t)t->tam;
+            no->prec = 100;
+        } else if (t->tipo == TOK_FUNCAO) {
+            int aridade = aridadeFuncao(t->funcao);
+            if (aridade < 1 || topo < aridade) break;
+            if (aridade == 2) no->dir = pilha[--topo]; /* f(a,b) */
+            no->esq = pilha[--topo];
+            no->tam = (size_t)t->tam + 2 + nos[no->esq].tam + (no->dir >= 0 ? 1 + nos[no->dir].tam : 0);
+            no->prec = 4;
+            no->comecaFuncPar = 1;
+        } else if (t->tipo == TOK_OPERADOR) {
+            if (topo < 2) break;
+            no->dir = pilha[--topo];
+            no->esq = pilha[--topo];
+            const NoExpr *a = &nos[no->esq];
+            const NoExpr *b = &nos[no->dir];
+            int prioridade = precedenciaOperador(t->op);
+            int is_right_assoc = (t->op == '^');
+            no->prec = (unsigned char)prioridade;
+            no->parEsq = (a->prec < prioridade) || (a->prec == prioridade && is_right_assoc);
+            no->parDir = (b->prec < prioridade) || (b->prec == prioridade && !is_right_assoc);
+            no->tam = tamanhoOperador(nos, no);
+            no->comecaFuncPar = no->parEsq ? 1 : a->comecaFuncPar;
+            no->altoTopo = no->parEsq ? 0 : a->altoTopo;
+            if (!no->altoTopo) no->altoTopo = (prioridade >= 2) ? t->op : (no->parDir ? 0 : b->altoTopo);
+        } else {
+            break;
+        }
+        pilha[topo++] = i;
+    }
+    if (i < n || topo != 1) { devolver(arena, nos); devolver(arena, pilha); return NULL; }
+
+    int raiz = pilha[0];
+    NoExpr *r = &nos[raiz];
+    if (!envolver && r->prec == 1) {
+        const NoExpr *a = &nos[r->esq];
+        const NoExpr *b = &nos[r->dir];
+        if (a->altoTopo && !(a->altoTopo == '^' && a->comecaFuncPar)) r->parEsq = 1;
+        if (!r->parDir && b->altoTopo && !(b->altoTopo == '^' && b->comecaFuncPar)) r->parDir = 1;
+        r->tam = tamanhoOperador(nos, r);
+    }
+
+    size_t total = r->tam + (envolver ? 2 : 0);
+    char *out = (char*)reservar(arena, total + 1);
+    if (!out) { devolver(arena, nos); devolver(arena, pilha); return NULL; }
+    r->pos = envolver ? 1 : 0;
+    /* pais vêm depois dos filhos na pós-fixa: percorrer de trás para frente visita a raiz primeiro */
+    for (i = raiz; i >= 0; --i) {
+        const Token *t = &toks[i];
+        const NoExpr *no = &nos[i];
+        size_t p = no->pos;
+        if (t->tipo == TOK_NUMERO) {
+            memcpy(out + p, texto + t->inicio, (size_t)t->tam);
+        } else if (t->tipo == TOK_FUNCAO) {
+            memcpy(out + p, texto + t->inicio, (size_t)t->tam);
+            out[p + (size_t)t->tam] = '(';
+            nos[no->esq].pos = p + (size_t)t->tam + 1;
+            if (no->dir >= 0) {
+                size_t virgula = nos[no->esq].pos + nos[no->esq].tam;
+                out[virgula] = ',';
+                nos[no->dir].pos = virgula + 1;
+            }
+            out[p + no->tam - 1] = ')';
+        } else {
+            if (no->parEsq) out[p++] = '(';
+            nos[no->esq].pos = p;
+            p += nos[no->esq].tam;
+            if (no->parEsq) out[p++] = ')';
+            out[p++] = t->op;
+            if (no->parDir) out[p++] = '(';
+            nos[no->dir].pos = p;
+            p += nos[no->dir].tam;
+            if (no->parDir) out[p] = ')';
+        }
+    }
+    if (envolver) {
+        out[0] = '(';
+        out[total - 1] = ')';
+    }
+    out[total] = '\0';
+    devolver(arena, nos);
+    devolver(arena, pilha);
+    return out;
+}
+
+/* ---- avaliador pós-fixo por tipo: avaliador_tipo.h com as operações de cada um ---- */
+
+/* float: as mesmas regras de aplicarOperadorBinario e das funções registradas */
+static int literalFloat(const char *texto, const Token *t, float *r){(void)texto; *r = (float)t->valor; return 0;}
+static int operarFloat(char op, float a, float b, float *r){*r = aplicarOperadorBinario(op, a, b); return 0;}
+static int funcaoFloat(int id, const float *args, float *r){
+    *r = (aridadeFuncao(id) == 2) ? aplicarFuncaoId2(id, args[0], args[1]) : aplicarFuncaoId(id, args[0]);
+    return 0;
+}
+#define TIPO float
+#define SUFIXO Float
+#include "avaliador_tipo.h"
+
+/* double: mesmas regras em double; funções do usuário só existem em float */
+static double potenciaDouble(double a, double b){
+    double acc = 1.0, base = a;
+    unsigned long long n;
+    if (!(b == trunc(b) && fabs(b) < 9223372036854775808.0)) return (a == 0.0 && b < 0.0) ? 0.0 : pow(a, b);
+    for (n = (unsigned long long)fabs(b); n; n >>= 1) {
+        if (n & 1) acc *= base;
+        base *= base;
+    }
+    if (b < 0.0) return (acc != 0.0) ? 1.0 / acc : 0.0;
+    return acc;
+}
+static int literalDouble(const char *texto, const Token *t, double *r){(void)texto; *r = t->valor; return 0;}
+static int operarDouble(char op, double a, double b, double *r){
+    switch (op) {
+        case '+': *r = a + b; break;
+        case '-': *r = a - b; break;
+        case '*': *r = a * b; break;
+        case '/': *r = (b != 0.0) ? a / b : 0.0; break;
+        case '%': *r = (trunc(b) != 0.0) ? fmod(trunc(a), trunc(b)) + 0.0 : 0.0; break;
+        case '^': *r = potenciaDouble(a, b); break;
+        default: return -1;
+    }
+    return 0;
+}
+static int funcaoDouble(int id, const double *args, double *r){
+    double x = args[0];
+    switch (id) {
+        case FUNC_SEN: *r = sin(x * PI_D / 180.0); break;
+        case FUNC_COS: *r = cos(x * PI_D / 180.0); break;
+        case FUNC_TG: *r = tan(x * PI_D / 180.0); break;
+        case FUNC_LOG:
+        case FUNC_LOG10: *r = (x <= 0.0) ? 0.0 : log10(x); break;
+        case FUNC_RAIZ:
+        case FUNC_SQRT: *r = (x <= 0.0) ? 0.0 : sqrt(x); break;
+        default:
+            *r = (aridadeFuncao(id) == 2) ? aplicarFuncaoId2(id, (float)args[0], (float)args[1])
+                                          : aplicarFuncaoId(id, (float)x);
+            break;
+    }
+    return 0;
+}
+#define TIPO double
+#define SUFIXO Double
+#include "avaliador_tipo.h"
+
+/* int64 exato: falha (-1) em estouro, divisão com resto, expoente negativo que não dê
+   inteiro, função e literal que não seja inteiro (lido do texto, até LLONG_MAX) */
+static int potenciaInteiro(long long a, long long b, long long *r){
+    long long acc = 1, base = a;
+    if (b < 0) {
+        if (a != 0 && a != 1 && a != -1) return -1;
+        *r = (a == -1 && (b & 1)) ? -1 : a * a; // 0 ^ -n segue a regra do float e dá 0
         return 0;
     }
+    for (; b; b >>= 1) {
+        if ((b & 1) && __builtin_mul_overflow(acc, base, &acc)) return -1;
+        if (b > 1 && __builtin_mul_overflow(base, base, &base)) return -1;
+    }
+    *r = acc;
+    return 0;
+}
+static int literalInteiro(const char *texto, const Token *t, long long *r){
+    return lerInteiro(texto + t->inicio, (size_t)t->tam, r);
+}
+static int operarInteiro(char op, long long a, long long b, long long *r){
+    switch (op) {
+        case '+': return __builtin_add_overflow(a, b, r) ? -1 : 0;
+        case '-': return __builtin_sub_overflow(a, b, r) ? -1 : 0;
+        case '*': return __builtin_mul_overflow(a, b, r) ? -1 : 0;
+        case '/':
+            if (b == 0) { *r = 0; return 0; }
+            if (b == -1) return __builtin_sub_overflow(0, a, r) ? -1 : 0;
+            if (a % b != 0) return -1;
+            *r = a / b;
+            return 0;
+        case '%': *r = (b == 0 || b == -1) ? 0 : a % b; return 0;
+        case '^': return potenciaInteiro(a, b, r);
+    }
+    return -1;
+}
+static int funcaoInteiro(int id, const long long *args, long long *r){
+    (void)id; (void)args; (void)r;
+    return -1;
+}
+#define TIPO long long
+#define SUFIXO Inteiro
+#include "avaliador_tipo.h"
+
+/* avaliarTokensPosfixa: valor da sequência pós-fixa; 0 se ela for inválida. Só com inteiros o
+   cálculo é exato em int64 e arredondado uma vez no fim; se não der, é refeito em float. */
+static float calcularPosfixa(Arena *arena, const char *texto, const Token *toks, int n){
+    long long inteiro;
+    float r;
+    if (literaisInteiros(texto, toks, n) && avaliarTokensInteiro(arena, texto, toks, n, &inteiro) == 0) return (float)inteiro;
+    avaliarTokensFloat(arena, texto, toks, n, &r);
+    return r;
+}
+
+int calcularExpressaoTipada(const char *entrada, TipoNumerico tipo, ValorNumerico *valor){
+    ListaTokens toks, pos;
+    const ListaTokens *seq = &toks;
+    int r = -1;
+    if (!entrada || !valor || tipo < TIPO_FLOAT || tipo > TIPO_AUTOMATICO) return -1;
+    memset(valor, 0, sizeof(*valor));
+    valor->tipo = (tipo == TIPO_AUTOMATICO) ? TIPO_DOUBLE : tipo;
+    inicializarListaTokens(&toks);
+    inicializarListaTokens(&pos);
+    if (lerTokens(entrada, strlen(entrada), &toks) != 0) goto fim;
+    if (!ehPosfixaTokens(toks.itens, toks.quantidade)) {
+        if (infixaParaPosfixaTokens(toks.itens, toks.quantidade, &pos) != 0) goto fim;
+        seq = &pos;
+    }
+    if (tipo == TIPO_AUTOMATICO && literaisInteiros(entrada, seq->itens, seq->quantidade) &&
+        avaliarTokensInteiro(NULL, entrada, seq->itens, seq->quantidade, &valor->v.i) == 0) {
+        valor->tipo = TIPO_INTEIRO;
+        r = 0;
+        goto fim;
+    }
+    switch (valor->tipo) {
+        case TIPO_FLOAT: r = avaliarTokensFloat(NULL, entrada, seq->itens, seq->quantidade, &valor->v.f); break;
+        case TIPO_INTEIRO: r = avaliarTokensInteiro(NULL, entrada, seq->itens, seq->quantidade, &valor->v.i); break;
+        default: r = avaliarTokensDouble(NULL, entrada, seq->itens, seq->quantidade, &valor->v.d); break;
+    }
+fim:
+    liberarListaTokens(&toks);
+    liberarListaTokens(&pos);
+    return r;
+}
+
+/* pontos de entrada das etapas: medem tempo quando compilado com -DESTATISTICAS */
+static char *juntarTokens(Arena *arena, const char *texto, const Token *toks, int n, int separarSinal){
+    EST_INICIO(t0);
+    char *r = escreverJuncao(arena, texto, toks, n, separarSinal);
+    EST_FIM(ESTAGIO_JUNTAR, t0);
+    return r;
+}
+static char *posfixaTokensParaInfixa(Arena *arena, const char *texto, const Token *toks, int n, int envolver){
+    EST_INICIO(t0);
+    char *r = montarInfixa(arena, texto, toks, n, envolver);
+    EST_FIM(ESTAGIO_POSFIXA_INFIXA, t0);
+    return r;
+}
+static float avaliarTokensPosfixa(Arena *arena, const char *texto, const Token *toks, int n){
+    EST_INICIO(t0);
+    float r = calcularPosfixa(arena, texto, toks, n);
+    EST_FIM(ESTAGIO_AVALIAR, t0);
+    return r;
+}
+int processarExpressao(const char *entrada, char **saida, float *valor, int *ehPos){
+    EST_INICIO(t0);
+    int r = processar(entrada, saida, valor, ehPos);
+    EST_FIM(ESTAGIO_PROCESSAR, t0);
+    return r;
+}
+int processarExpressaoArena(const char *entrada, size_t tam, Arena *arena, const char **saida, float *valor, int *ehPos){
+    EST_INICIO(t0);
+    int r = processarNaArena(entrada, tam, arena, saida, valor, ehPos);
+    EST_FIM(ESTAGIO_PROCESSAR, t0);
+    return r;
 }
-/* minha_strdup: implementação local de strdup */
-static char *minha_strdup(const char *s){if(!s)return NULL;size_t n=strlen(s);char*r=(char*)malloc(n+1);if(!r)return NULL;memcpy(r,s,n+1);return r;}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #ifndef EXPRESSAO_H
 #define EXPRESSAO_H
+#include <stddef.h>
+#include "arena.h"
 typedef struct {
     char posFixa[512]; // Expressão na forma pos-fixa, como 3 12 4 + *
     char inFixa[512]; // Expressão na forma infixa, como 3*(12+4)
@@ -7,4 +9,48 @@ typedef struct {
 } Expressao;
 char * getFormaInFixa(char *Str); // Retorna a forma inFixa de Str (posFixa)
 float getValorPosFixa(char *StrPosFixa); // Calcula o valor de Str (na forma posFixa)
+/* Converte e calcula (0 = ok, *saida é malloc). Só com literais inteiros e sem funções o valor é
+   calculado exato em int64 e arredondado para float no fim; se estourar ou não for exato, em float.
+   compilarExpressao e o armazém dobram essas expressões do mesmo jeito, então os valores coincidem. */
+int processarExpressao(const char *entrada, char **saida, float *valor, int *ehPos);
+/* Igual a processarExpressao sobre entrada[0..tam), sem nenhum malloc: tokens, pilhas e *saida vêm da
+   arena e valem até o próximo reiniciarArena. Retorna 0, -1 (expressão inválida) ou -2 (arena sem espaço). */
+int processarExpressaoArena(const char *entrada, size_t tam, Arena *arena, const char **saida, float *valor, int *ehPos);
+
+/* Identificadores das funções unárias reconhecidas */
+enum {
+    FUNC_SEN,
+    FUNC_COS,
+    FUNC_TG,
+    FUNC_LOG,
+    FUNC_LOG10,
+    FUNC_RAIZ,
+    FUNC_SQRT,
+    FUNC_QUANTIDADE
+};
+
+float senoAprox(float graus);
+float cossenoAprox(float graus);
+float tangenteAprox(float graus);
+float raizAprox(float x);
+float lnAprox(float x);
+float log10Aprox(float x);
+
+int idFuncao(const char *nome, int tam); // Id da função de nome[0..tam), ou -1 (registro em funcoes.h)
+float aplicarFuncaoId(int id, float x); // Aplica a função unária de id dado a x
+float aplicarOperadorBinario(char op, float a, float b); // a op b, mesma regra de getValorPosFixa
+
+/* Tipo numérico do cálculo em calcularExpressaoTipada */
+typedef enum {
+    TIPO_FLOAT,      // as regras de aplicarOperadorBinario, sem o caminho inteiro automático
+    TIPO_DOUBLE,     // as mesmas regras em double; funções do usuário são chamadas em float
+    TIPO_INTEIRO,    // int64 exato: falha em estouro, divisão com resto, função ou literal não inteiro (lerInteiro)
+    TIPO_AUTOMATICO  // inteiro quando só há literais inteiros e o cálculo é exato; senão double
+} TipoNumerico;
+typedef struct {
+    TipoNumerico tipo; // o tipo usado de fato (nunca TIPO_AUTOMATICO)
+    union { float f; double d; long long i; } v;
+} ValorNumerico;
+/* Calcula entrada (infixa ou pós-fixa) no tipo pedido. Retorna 0, ou -1 se for inválida ou o valor não existir no tipo */
+int calcularExpressaoTipada(const char *entrada, TipoNumerico tipo, ValorNumerico *valor);
 #endif
\ No newline at end of file
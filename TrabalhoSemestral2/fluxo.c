@@ -0,0 +1,174 @@
+/* fluxo.c - processamento de arquivos de expressões linha a linha */
+
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "expressao.h"
+#include "arena.h"
+#include "fluxo.h"
+#include "formatacao.h"
+
+#define TAM_SAIDA (1 << 20)  // buffer de saída
+#define TAM_BLOCO (1 << 20)  // leitura inicial da entrada padrão
+#define TAM_ARENA (1 << 16)  // arena inicial por linha (cresce se faltar)
+
+typedef struct {
+    FILE *arq;
+    char *dados;
+    size_t usado;
+    int erro;
+    Arena arena;
+    size_t linhas;
+} EstadoFluxo;
+
+static void descarregar(EstadoFluxo *st) {
+    if (st->usado > 0 && fwrite(st->dados, 1, st->usado, st->arq) != st->usado) st->erro = 1;
+    st->usado = 0;
+}
+
+static void escrever(EstadoFluxo *st, const char *p, size_t n) {
+    if (n > TAM_SAIDA - st->usado) descarregar(st);
+    if (n > TAM_SAIDA) {
+        if (fwrite(p, 1, n, st->arq) != n) st->erro = 1;
+        return;
+    }
+    memcpy(st->dados + st->usado, p, n);
+    st->usado += n;
+}
+
+static void processarLinha(EstadoFluxo *st, const char *linha, size_t tam) {
+    const char *convertida;
+    float valor;
+    int ehPos, r;
+    char num[TAM_TEXTO_FLOAT + 2];
+    if (tam > 0 && linha[tam-1] == '\r') --tam;
+    for (;;) {
+        reiniciarArena(&st->arena);
+        r = processarExpressaoArena(linha, tam, &st->arena, &convertida, &valor, &ehPos);
+        if (r != -2) break;
+        /* arena pequena para esta linha: dobra e tenta de novo */
+        size_t cap = st->arena.capacidade * 2;
+        liberarArena(&st->arena);
+        if (criarArena(&st->arena, cap) != 0) { st->erro = 1; return; }
+    }
+    st->linhas++;
+    if (r != 0) {
+        escrever(st, "ERRO\n", 5);
+        return;
+    }
+    escrever(st, convertida, strlen(convertida));
+    num[0] = '\t';
+    r = 1 + formatarFloat(num + 1, valor, 6);
+    num[r++] = '\n';
+    escrever(st, num, (size_t)r);
+}
+
+/* processa as linhas completas de dados[0..tam); com final, também o resto sem '\n'.
+   Retorna quantos bytes foram consumidos. */
+static size_t processarLinhas(EstadoFluxo *st, const char *dados, size_t tam, int final) {
+    size_t ini = 0;
+    while (ini < tam && !st->erro) {
+        const char *nl = (const char*)memchr(dados + ini, '\n', tam - ini);
+        if (!nl) {
+            if (!final) break;
+            processarLinha(st, dados + ini, tam - ini);
+            return tam;
+        }
+        processarLinha(st, dados + ini, (size_t)(nl - (dados + ini)));
+        ini = (size_t)(nl - dados) + 1;
+    }
+    return ini;
+}
+
+/* entrada sem mmap: blocos grandes, a linha incompleta do fim vai para o início do buffer */
+static int processarBlocos(EstadoFluxo *st, FILE *arq) {
+    size_t cap = TAM_BLOCO, pend = 0;
+    char *buf = (char*)malloc(cap);
+    if (!buf) return -1;
+    for (;;) {
+        size_t lidos, usados;
+        if (pend == cap) {
+            char *maior = (char*)realloc(buf, cap * 2);
+            if (!maior) { free(buf); return -1; }
+            buf = maior;
+            cap *= 2;
+        }
+        lidos = fread(buf + pend, 1, cap - pend, arq);
+        if (lidos == 0) {
+            if (ferror(arq)) { free(buf); return -1; }
+            processarLinhas(st, buf, pend, 1);
+            break;
+        }
+        /* só o trecho novo pode completar a linha pendente: sem '\n' nele, continua lendo
+           (evita reler uma linha enorme a cada bloco) */
+        if (!memchr(buf + pend, '\n', lidos)) { pend += lidos; continue; }
+        pend += lidos;
+        usados = processarLinhas(st, buf, pend, 0);
+        memmove(buf, buf + usados, pend - usados);
+        pend -= usados;
+        if (st->erro) break;
+    }
+    free(buf);
+    return st->erro ? -1 : 0;
+}
+
+#ifndef _WIN32
+/* 1 = arquivo processado pelo mapeamento, 0 = não dá para mapear, -1 = erro */
+static int processarMapeado(EstadoFluxo *st, const char *caminho) {
+    struct stat info;
+    void *mapa;
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) return -1;
+    if (fstat(fd, &info) != 0) { close(fd); return -1; }
+    if (!S_ISREG(info.st_mode) || info.st_size == 0) { close(fd); return 0; }
+    mapa = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED) return 0;
+    madvise(mapa, (size_t)info.st_size, MADV_SEQUENTIAL);
+    processarLinhas(st, (const char*)mapa, (size_t)info.st_size, 1);
+    munmap(mapa, (size_t)info.st_size);
+    return 1;
+}
+#endif
+
+int processarArquivoFluxo(const char *caminho, FILE *saida, size_t *linhas) {
+    EstadoFluxo st;
+    int r = 0;
+    int padrao = (!caminho || strcmp(caminho, "-") == 0);
+    if (!saida) return -1;
+    memset(&st, 0, sizeof(st));
+    st.arq = saida;
+    st.dados = (char*)malloc(TAM_SAIDA);
+    if (!st.dados || criarArena(&st.arena, TAM_ARENA) != 0) {
+        free(st.dados);
+        return -1;
+    }
+
+    if (padrao) {
+        r = processarBlocos(&st, stdin);
+    } else {
+#ifndef _WIN32
+        r = processarMapeado(&st, caminho);
+        if (r == 1) r = 0;
+        else if (r == 0)
+#endif
+        {
+            FILE *arq = fopen(caminho, "rb");
+            if (!arq) r = -1;
+            else { r = processarBlocos(&st, arq); fclose(arq); }
+        }
+    }
+
+    descarregar(&st);
+    if (fflush(saida) != 0) st.erro = 1;
+    if (linhas) *linhas = st.linhas;
+    free(st.dados);
+    liberarArena(&st.arena);
+    return (r != 0 || st.erro) ? -1 : 0;
+}
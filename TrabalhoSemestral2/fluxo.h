@@ -0,0 +1,16 @@
+#ifndef FLUXO_H
+#define FLUXO_H
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Processa um arquivo com uma expressão (infixa ou pós-fixa) por linha e
+ * escreve em saida, para cada linha, "convertida<TAB>valor" ou "ERRO".
+ * Arquivos regulares são mapeados em memória (mmap) e as linhas são lidas
+ * no lugar, sem cópia; caminho NULL ou "-" lê a entrada padrão em blocos
+ * grandes. A saída é acumulada num buffer e gravada em blocos.
+ * Se linhas não for NULL, recebe a quantidade de linhas processadas.
+ * Retorna 0, ou -1 em erro de leitura, escrita ou memória.
+ */
+int processarArquivoFluxo(const char *caminho, FILE *saida, size_t *linhas);
+#endif
@@ -0,0 +1,277 @@
+/* formatacao.c - float e double em texto com casas fixas, sem printf */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "formatacao.h"
+#include "estatisticas.h"
+
+#define CASAS_MAX 9
+#define BLOCO_FORMATACAO 4096
+
+static const char pares[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const unsigned long long potencias10[CASAS_MAX + 1] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL,
+    1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL
+};
+
+/* escreve os dígitos de n para trás, terminando em fim; retorna o início */
+static char *digitos64(char *fim, unsigned long long n) {
+    while (n >= 100) {
+        unsigned r = (unsigned)(n % 100);
+        n /= 100;
+        fim -= 2;
+        memcpy(fim, pares + 2 * r, 2);
+    }
+    if (n >= 10) {
+        fim -= 2;
+        memcpy(fim, pares + 2 * n, 2);
+    } else {
+        *--fim = (char)('0' + n);
+    }
+    return fim;
+}
+
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 u128;
+
+static char *digitos128(char *fim, u128 n) {
+    const unsigned long long bloco = 10000000000000000000ULL; // 10^19
+    while (n > (u128)~0ULL) {
+        char *p = digitos64(fim, (unsigned long long)(n % bloco));
+        n /= bloco;
+        while (p > fim - 19) *--p = '0';
+        fim = p;
+    }
+    return digitos64(fim, (unsigned long long)n);
+}
+#endif
+
+/* sinal, os dígitos ini..fim com o ponto antes dos últimos casas (completando com zeros à esquerda) */
+static int montar(char *buf, int neg, char *ini, char *fim, int casas) {
+    int n = (int)(fim - ini), inteiros, t = 0;
+    while (n < casas + 1) { *--ini = '0'; ++n; }
+    inteiros = n - casas;
+    if (neg) buf[t++] = '-';
+    memcpy(buf + t, ini, (size_t)inteiros);
+    t += inteiros;
+    if (casas > 0) {
+        buf[t++] = '.';
+        memcpy(buf + t, ini + inteiros, (size_t)casas);
+        t += casas;
+    }
+    return t;
+}
+
+/*
+ * Texto de (-1)^neg * m * 2^e com casas fixas. Com e < 0 o valor escalado
+ * m * 10^casas / 2^-e é arredondado exatamente (empate para o par, como a
+ * glibc); com e >= 0 o valor é inteiro e as casas são zeros. Retorna -1 se
+ * não couber em 128 bits (o chamador usa o snprintf).
+ */
+static int formatarBinario(char *buf, int neg, unsigned long long m, int e, int casas) {
+    char tmp[64];
+    char *fim = tmp + sizeof(tmp), *ini;
+    if (e >= 0) {
+        char *p;
+        int t;
+        if (e < 64 && (m >> (63 - e)) >> 1 == 0) {
+            ini = digitos64(fim, m << e);
+        } else {
+#ifdef __SIZEOF_INT128__
+            if (e >= 128 || ((u128)m >> (128 - e)) != 0) return -1; // aqui e >= 1
+            ini = digitos128(fim, (u128)m << e);
+#else
+            return -1;
+#endif
+        }
+        p = buf;
+        if (neg) *p++ = '-';
+        t = (int)(fim - ini);
+        memcpy(p, ini, (size_t)t);
+        p += t;
+        if (casas > 0) {
+            *p++ = '.';
+            memset(p, '0', (size_t)casas);
+            p += casas;
+        }
+        return (int)(p - buf);
+    }
+    {
+        int k = -e;
+        if (m <= ~0ULL / potencias10[casas]) {
+            unsigned long long n = m * potencias10[casas], q;
+            if (k >= 64) {
+                q = (k == 64 && n > (1ULL << 63)) ? 1 : 0;
+            } else {
+                unsigned long long r = n & ((1ULL << k) - 1), metade = 1ULL << (k - 1);
+                q = n >> k;
+                if (r > metade || (r == metade && (q & 1))) ++q;
+            }
+            ini = digitos64(fim, q);
+        } else {
+#ifdef __SIZEOF_INT128__
+            u128 n = (u128)m * potencias10[casas], q;
+            if (k >= 128) {
+                q = 0; // n < 2^83 <= metade
+            } else {
+                u128 r = n & (((u128)1 << k) - 1), metade = (u128)1 << (k - 1);
+                q = n >> k;
+                if (r > metade || (r == metade && (q & 1))) ++q;
+            }
+            ini = digitos128(fim, q);
+#else
+            return -1;
+#endif
+        }
+    }
+    return montar(buf, neg, ini, fim, casas);
+}
+
+static int naoFinito(char *buf, int neg, int nan) {
+    int t = 0;
+    if (neg) buf[t++] = '-';
+    memcpy(buf + t, nan ? "nan" : "inf", 3);
+    return t + 3;
+}
+
+static int limitarCasas(int casas) {
+    return casas < 0 ? 0 : (casas > CASAS_MAX ? CASAS_MAX : casas);
+}
+
+int formatarFloat(char *buf, float v, int casas) {
+    unsigned int bits, expoente, fracao;
+    int neg;
+    memcpy(&bits, &v, sizeof(bits));
+    neg = (int)(bits >> 31);
+    expoente = (bits >> 23) & 0xFF;
+    fracao = bits & 0x7FFFFF;
+    casas = limitarCasas(casas);
+    if (expoente == 0xFF) return naoFinito(buf, neg, fracao != 0);
+    /* todo float cabe em 128 bits: formatarBinario não falha */
+    if (expoente == 0) return formatarBinario(buf, neg, fracao, -149, casas);
+    return formatarBinario(buf, neg, fracao | 0x800000u, (int)expoente - 150, casas);
+}
+
+int formatarDouble(char *buf, double v, int casas) {
+    unsigned long long bits, fracao;
+    unsigned expoente;
+    int neg, r;
+    memcpy(&bits, &v, sizeof(bits));
+    neg = (int)(bits >> 63);
+    expoente = (unsigned)(bits >> 52) & 0x7FF;
+    fracao = bits & 0xFFFFFFFFFFFFFULL;
+    casas = limitarCasas(casas);
+    if (expoente == 0x7FF) return naoFinito(buf, neg, fracao != 0);
+    if (expoente == 0) r = formatarBinario(buf, neg, fracao, -1074, casas);
+    else r = formatarBinario(buf, neg, fracao | (1ULL << 52), (int)expoente - 1075, casas);
+    if (r < 0) r = snprintf(buf, TAM_TEXTO_DOUBLE, "%.*f", casas, v);
+    return r;
+}
+
+/* ---------- verificação contra o snprintf ---------- */
+
+typedef struct {
+    unsigned long long valores, divergentes;
+    long long nsSnprintf, nsFormatar;
+} MedidaFormatacao;
+
+static unsigned long long proximoAleatorio(unsigned long long *s) {
+    unsigned long long x = *s;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *s = x;
+}
+
+/* resultado típico: mantissa aleatória, |v| entre 10^-3 e 10^6, metade negativos */
+static double valorTipico(unsigned long long *s) {
+    static const double escala[] = { 1e-3, 1e-2, 1e-1, 1, 10, 100, 1e3, 1e4, 1e5, 1e6 };
+    unsigned long long a = proximoAleatorio(s);
+    double v = (double)(a >> 11) / 9007199254740992.0 * escala[(a >> 1) % 10];
+    return (a & 1) ? -v : v;
+}
+
+static void medirBlocoFormatacao(const double *x, int n, int ehFloat, int casas, char *ref, char *res,
+                                 MedidaFormatacao *med) {
+    int tamRef[BLOCO_FORMATACAO], tamRes[BLOCO_FORMATACAO];
+    long long t0;
+    int i;
+    t0 = relogioNs();
+    for (i = 0; i < n; ++i) {
+        /* float vai ao printf promovido a double, como em printf("%.6f", valor) */
+        tamRef[i] = snprintf(ref + (size_t)i * TAM_TEXTO_DOUBLE, TAM_TEXTO_DOUBLE, "%.*f", casas, x[i]);
+    }
+    med->nsSnprintf += relogioNs() - t0;
+    t0 = relogioNs();
+    if (ehFloat) {
+        for (i = 0; i < n; ++i) tamRes[i] = formatarFloat(res + (size_t)i * TAM_TEXTO_DOUBLE, (float)x[i], casas);
+    } else {
+        for (i = 0; i < n; ++i) tamRes[i] = formatarDouble(res + (size_t)i * TAM_TEXTO_DOUBLE, x[i], casas);
+    }
+    med->nsFormatar += relogioNs() - t0;
+    for (i = 0; i < n; ++i) {
+        size_t o = (size_t)i * TAM_TEXTO_DOUBLE;
+        if (tamRef[i] != tamRes[i] || memcmp(ref + o, res + o, (size_t)tamRes[i]) != 0) med->divergentes++;
+    }
+    med->valores += (unsigned long long)n;
+}
+
+int verificarFormatacao(unsigned long long amostras, FILE *saida) {
+    static const int casasTestadas[] = { 2, 6, 9 };
+    static const char *const faixas[] = { "espalhados", "tipicos" };
+    char *ref = (char*)malloc((size_t)BLOCO_FORMATACAO * TAM_TEXTO_DOUBLE);
+    char *res = (char*)malloc((size_t)BLOCO_FORMATACAO * TAM_TEXTO_DOUBLE);
+    double x[BLOCO_FORMATACAO];
+    int falhou = 0, ehFloat, faixa;
+    size_t ic;
+    if (!ref || !res) {
+        free(ref);
+        free(res);
+        return -1;
+    }
+    for (ehFloat = 1; ehFloat >= 0; --ehFloat) {
+        for (faixa = 0; faixa < 2; ++faixa) {
+            /* todos os floats só em amostras == 0; doubles e a faixa típica usam 2^22 nesse caso */
+            unsigned long long total = amostras ? amostras : ((ehFloat && faixa == 0) ? (1ULL << 32) : (1ULL << 22));
+            for (ic = 0; ic < sizeof(casasTestadas) / sizeof(casasTestadas[0]); ++ic) {
+                int casas = casasTestadas[ic];
+                MedidaFormatacao med;
+                unsigned long long k = 0, semente = 0x9E3779B97F4A7C15ULL;
+                memset(&med, 0, sizeof(med));
+                while (k < total) {
+                    int n = 0;
+                    for (; n < BLOCO_FORMATACAO && k < total; ++n, ++k) {
+                        if (faixa == 1) {
+                            x[n] = ehFloat ? (double)(float)valorTipico(&semente) : valorTipico(&semente);
+                        } else if (ehFloat) {
+                            /* bits espaçados por todo o intervalo */
+                            unsigned int bits = (unsigned int)(k * ((1ULL << 32) / total ? (1ULL << 32) / total : 1));
+                            float f;
+                            memcpy(&f, &bits, sizeof(f));
+                            x[n] = f;
+                        } else {
+                            unsigned long long bits = k * (~0ULL / total);
+                            memcpy(&x[n], &bits, sizeof(double));
+                        }
+                    }
+                    medirBlocoFormatacao(x, n, ehFloat, casas, ref, res, &med);
+                }
+                if (med.divergentes) falhou = 1;
+                fprintf(saida, "{\"tipo\":\"%s\",\"faixa\":\"%s\",\"casas\":%d,\"valores\":%llu,\"divergentes\":%llu,"
+                        "\"ns_snprintf\":%.2f,\"ns_formatar\":%.2f,\"aceleracao\":%.2f}\n",
+                        ehFloat ? "float" : "double", faixas[faixa], casas, med.valores, med.divergentes,
+                        med.valores ? (double)med.nsSnprintf / (double)med.valores : 0.0,
+                        med.valores ? (double)med.nsFormatar / (double)med.valores : 0.0,
+                        med.nsFormatar ? (double)med.nsSnprintf / (double)med.nsFormatar : 0.0);
+            }
+        }
+    }
+    free(ref);
+    free(res);
+    return falhou ? -1 : 0;
+}
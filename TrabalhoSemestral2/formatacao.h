@@ -0,0 +1,30 @@
+#ifndef FORMATACAO_H
+#define FORMATACAO_H
+#include <stdio.h>
+
+/*
+ * Números em texto com casas decimais fixas, escritos direto no buffer do
+ * chamador, sem '\0' no fim. O texto é o mesmo de printf("%.*f") no locale
+ * "C" (valor binário exato arredondado, empate para o par, "-0.000000",
+ * "inf", "-nan"...), mas sem passar pelo printf: independe do locale e
+ * custa uma fração do snprintf. casas vai de 0 a 9 (fora disso é limitado).
+ */
+#define TAM_TEXTO_FLOAT 56    // sinal, 39 dígitos inteiros, ponto e 9 casas
+#define TAM_TEXTO_DOUBLE 330  // sinal, 309 dígitos inteiros, ponto e 9 casas
+
+/* Escreve v em buf (TAM_TEXTO_FLOAT bytes) e retorna quantos bytes escreveu */
+int formatarFloat(char *buf, float v, int casas);
+
+/* Igual para double (buf com TAM_TEXTO_DOUBLE); |v| >= 2^128 ainda passa pelo snprintf */
+int formatarDouble(char *buf, double v, int casas);
+
+/*
+ * Compara formatarFloat com snprintf("%.*f") para 2, 6 e 9 casas e escreve
+ * uma linha JSON por caso (valores, divergências, ns por valor de cada um).
+ * amostras > 0 percorre esse número de floats espalhados por todo o
+ * intervalo de bits, mais a mesma quantidade de resultados típicos
+ * (|v| < 10^6); amostras == 0 percorre todos os 2^32 floats.
+ * Retorna 0 se os textos forem sempre iguais, -1 caso contrário.
+ */
+int verificarFormatacao(unsigned long long amostras, FILE *saida);
+#endif
@@ -0,0 +1,128 @@
+/* funcoes.c - registro de funções e despacho por id */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+
+#include "expressao.h"
+#include "funcoes.h"
+
+#define TAM_TABELA (2 * MAX_FUNCOES) // potência de 2, no máximo meio cheia
+
+/* Embutidas na ordem do enum FUNC_*; log é base 10, como no trabalho original */
+static DescritorFuncao funcoes[MAX_FUNCOES] = {
+    { "sen",   3, 1, senoAprox,     NULL, NULL },
+    { "cos",   3, 1, cossenoAprox,  NULL, NULL },
+    { "tg",    2, 1, tangenteAprox, NULL, NULL },
+    { "log",   3, 1, log10Aprox,    NULL, NULL },
+    { "log10", 5, 1, log10Aprox,    NULL, NULL },
+    { "raiz",  4, 1, raizAprox,     NULL, NULL },
+    { "sqrt",  4, 1, raizAprox,     NULL, NULL }
+};
+static int nFuncoes = FUNC_QUANTIDADE;
+
+/* nomes do usuário: id + 1 por posição (0 = vazio); entradas publicadas com release */
+static int tabela[TAM_TABELA];
+static pthread_mutex_t mtxRegistro = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned hashNome(const char *s, int n) {
+    unsigned h = 2166136261u;
+    int i;
+    for (i = 0; i < n; ++i) h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+
+/* embutidas: o tamanho e a primeira letra já separam todas, resta uma comparação */
+static int idEmbutida(const char *nome, int tam) {
+    int id = -1;
+    switch (tam) {
+        case 2: id = FUNC_TG; break;
+        case 3: id = (nome[0] == 's') ? FUNC_SEN : (nome[0] == 'c') ? FUNC_COS : FUNC_LOG; break;
+        case 4: id = (nome[0] == 'r') ? FUNC_RAIZ : FUNC_SQRT; break;
+        case 5: id = FUNC_LOG10; break;
+        default: return -1;
+    }
+    return memcmp(nome, funcoes[id].nome, (size_t)tam) == 0 ? id : -1;
+}
+
+int idFuncao(const char *nome, int tam) {
+    unsigned i;
+    int id;
+    if (!nome || tam <= 0) return -1;
+    id = idEmbutida(nome, tam);
+    if (id >= 0 || __atomic_load_n(&nFuncoes, __ATOMIC_ACQUIRE) == FUNC_QUANTIDADE) return id;
+    for (i = hashNome(nome, tam) & (TAM_TABELA - 1); ; i = (i + 1) & (TAM_TABELA - 1)) {
+        int v = __atomic_load_n(&tabela[i], __ATOMIC_ACQUIRE);
+        if (v == 0) return -1;
+        if (funcoes[v-1].tamNome == tam && memcmp(funcoes[v-1].nome, nome, (size_t)tam) == 0) return v - 1;
+    }
+}
+
+static int nomeValido(const char *nome) {
+    const char *p;
+    if (!nome || !(isalpha((unsigned char)nome[0]) || nome[0] == '_')) return 0;
+    for (p = nome; *p; ++p) {
+        if (!isalnum((unsigned char)*p) && *p != '_') return 0;
+    }
+    return 1;
+}
+
+static int registrar(const char *nome, int aridade, FuncaoUnaria f1, FuncaoBinaria f2, FuncaoLote lote) {
+    DescritorFuncao *d;
+    char *copia;
+    int id, tam;
+    unsigned i;
+    if (!nomeValido(nome) || (!f1 && !f2)) return -1;
+    tam = (int)strlen(nome);
+
+    pthread_mutex_lock(&mtxRegistro);
+    id = nFuncoes;
+    if (id == MAX_FUNCOES || idFuncao(nome, tam) >= 0 || !(copia = (char*)malloc((size_t)tam + 1))) {
+        pthread_mutex_unlock(&mtxRegistro);
+        return -1;
+    }
+    memcpy(copia, nome, (size_t)tam + 1);
+    d = &funcoes[id];
+    d->nome = copia;
+    d->tamNome = tam;
+    d->aridade = aridade;
+    d->unaria = f1;
+    d->binaria = f2;
+    d->lote = lote;
+    /* o descritor fica visível antes do nome e da contagem */
+    for (i = hashNome(nome, tam) & (TAM_TABELA - 1); tabela[i] != 0; i = (i + 1) & (TAM_TABELA - 1)) {
+    }
+    __atomic_store_n(&tabela[i], id + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&nFuncoes, id + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&mtxRegistro);
+    return id;
+}
+
+int registrarFuncaoUnaria(const char *nome, FuncaoUnaria f, FuncaoLote lote) {
+    return f ? registrar(nome, 1, f, NULL, lote) : -1;
+}
+
+int registrarFuncaoBinaria(const char *nome, FuncaoBinaria f, FuncaoLote lote) {
+    return f ? registrar(nome, 2, NULL, f, lote) : -1;
+}
+
+const DescritorFuncao *descritorFuncao(int id) {
+    if (id < 0 || id >= __atomic_load_n(&nFuncoes, __ATOMIC_ACQUIRE)) return NULL;
+    return &funcoes[id];
+}
+
+int aridadeFuncao(int id) {
+    const DescritorFuncao *d = descritorFuncao(id);
+    return d ? d->aridade : 0;
+}
+
+float aplicarFuncaoId(int id, float x) {
+    const DescritorFuncao *d = descritorFuncao(id);
+    return (d && d->aridade == 1) ? d->unaria(x) : 0.0f;
+}
+
+float aplicarFuncaoId2(int id, float a, float b) {
+    const DescritorFuncao *d = descritorFuncao(id);
+    return (d && d->aridade == 2) ? d->binaria(a, b) : 0.0f;
+}
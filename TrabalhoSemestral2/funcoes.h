@@ -0,0 +1,41 @@
+#ifndef FUNCOES_H
+#define FUNCOES_H
+
+/*
+ * Registro de funções: o analisador léxico resolve cada nome para um id
+ * (idFuncao) e a avaliação chama pela tabela, sem comparar strings. As
+ * funções embutidas ocupam os ids FUNC_SEN..FUNC_SQRT; as do usuário vêm
+ * depois, na ordem de registro.
+ */
+
+#define MAX_FUNCOES 256 // ids cabem no campo funcao de Instrucao
+
+typedef float (*FuncaoUnaria)(float x);
+typedef float (*FuncaoBinaria)(float a, float b);
+/* r[i] = f(a[i]) ou f(a[i], b[i]) para i em [0, n); b é NULL nas unárias e r pode coincidir com a */
+typedef void (*FuncaoLote)(float *r, const float *a, const float *b, int n);
+
+typedef struct {
+    const char *nome;
+    int tamNome;
+    int aridade;           // 1 ou 2
+    FuncaoUnaria unaria;   // aridade 1
+    FuncaoBinaria binaria; // aridade 2
+    FuncaoLote lote;       // opcional, usado por avaliarProgramaLote
+} DescritorFuncao;
+
+/*
+ * Registra uma função do usuário e retorna o id dela, ou -1 se o nome não
+ * for um identificador, já existir, o registro estiver cheio ou faltar
+ * memória. Na infixa as binárias são escritas f(a, b); na pós-fixa, a b f.
+ * A função deve ser pura, pois o otimizador calcula na compilação as
+ * chamadas com argumentos constantes. Pode ser chamada a qualquer momento
+ * e de qualquer thread; a consulta não usa trava.
+ */
+int registrarFuncaoUnaria(const char *nome, FuncaoUnaria f, FuncaoLote lote);
+int registrarFuncaoBinaria(const char *nome, FuncaoBinaria f, FuncaoLote lote);
+
+const DescritorFuncao *descritorFuncao(int id); // NULL se o id não existe
+int aridadeFuncao(int id);                      // 0 se o id não existe
+float aplicarFuncaoId2(int id, float a, float b); // binária de id dado; 0 se não for binária
+#endif
@@ -0,0 +1,301 @@
+/* geracao.c - código C em linha reta para fórmulas conhecidas na compilação */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "expressao.h"
+#include "funcoes.h"
+#include "matematica.h"
+#include "programa.h"
+#include "geracao.h"
+
+#define TAM_OPERANDO 48 // "valores[N]", "vN" ou um literal hexadecimal entre parênteses
+
+typedef char Operando[TAM_OPERANDO];
+
+static const char *nomesEmbutidas[FUNC_QUANTIDADE] = {
+    "FUNC_SEN", "FUNC_COS", "FUNC_TG", "FUNC_LOG", "FUNC_LOG10", "FUNC_RAIZ", "FUNC_SQRT"
+};
+/* as mesmas funções do registro (funcoes.c), chamadas direto em PRECISAO_LIBM */
+static const char *funcoesEmbutidas[FUNC_QUANTIDADE] = {
+    "senoAprox", "cossenoAprox", "tangenteAprox", "log10Aprox", "log10Aprox", "raizAprox", "raizAprox"
+};
+static const char *nomesPrecisao[PRECISAO_QUANTIDADE] = { "PRECISAO_LIBM", "PRECISAO_ULP", "PRECISAO_RAPIDA" };
+
+static int ehIdentificadorC(const char *s, size_t n) {
+    size_t i;
+    if (n == 0 || !(isalpha((unsigned char)s[0]) || s[0] == '_')) return 0;
+    for (i = 1; i < n; ++i) {
+        if (!(isalnum((unsigned char)s[i]) || s[i] == '_')) return 0;
+    }
+    return 1;
+}
+
+/* literal float exato: hexadecimal com sufixo f (o valor cabe em float, então não há arredondamento) */
+static void escreverLiteral(char *buf, float v) {
+    if (isnan(v)) snprintf(buf, TAM_OPERANDO, "NAN");
+    else if (isinf(v)) snprintf(buf, TAM_OPERANDO, "%s", v < 0 ? "(-INFINITY)" : "INFINITY");
+    else if (signbit(v)) snprintf(buf, TAM_OPERANDO, "(%af)", (double)v);
+    else snprintf(buf, TAM_OPERANDO, "%af", (double)v);
+}
+
+/* produto em vN, com a barreira contra FMA do cabeçalho gerado */
+static void escreverProduto(FILE *saida, int n, const char *a, const char *b) {
+    fprintf(saida, "    float v%d = %s * %s;\n", n, a, b);
+    fprintf(saida, "    GERADO_SEM_FMA(v%d);\n", n);
+}
+
+/*
+ * base ^ n como potenciaFloat (expressao.c): acc começa em 1 e, por bit de
+ * n, acc *= base e base *= base; 1 * base é exato, então a primeira
+ * multiplicação some. Expoente negativo dá 1 / acc, ou 0 se acc for 0.
+ * Troca base pelo nome do resultado.
+ */
+static void gerarPotencia(FILE *saida, char *base, unsigned n, int negativo, int *locais) {
+    Operando acc, b;
+    int temAcc = 0;
+    if (n == 0) {
+        if (base[0] == 'v') fprintf(saida, "    (void)%s;\n", base); // vN ou valores[i] que não são mais usados
+        snprintf(base, TAM_OPERANDO, "0x1p+0f");
+        return;
+    }
+    memcpy(b, base, sizeof(Operando));
+    while (n) {
+        if (n & 1) {
+            if (temAcc) {
+                escreverProduto(saida, *locais, acc, b);
+                snprintf(acc, TAM_OPERANDO, "v%d", (*locais)++);
+            } else {
+                memcpy(acc, b, sizeof(Operando));
+                temAcc = 1;
+            }
+        }
+        n >>= 1;
+        if (n) {
+            escreverProduto(saida, *locais, b, b);
+            snprintf(b, TAM_OPERANDO, "v%d", (*locais)++);
+        }
+    }
+    if (negativo) {
+        fprintf(saida, "    float v%d = (%s != 0.0f) ? 0x1p+0f / %s : 0.0f;\n", *locais, acc, acc);
+        snprintf(acc, TAM_OPERANDO, "v%d", (*locais)++);
+    }
+    memcpy(base, acc, sizeof(Operando));
+}
+
+void gerarPreambuloC(FILE *saida) {
+    fprintf(saida,
+            "#include <math.h>\n"
+            "#include <stdio.h>\n"
+            "#include <stdlib.h>\n"
+            "#include \"expressao.h\"\n"
+            "#include \"funcoes.h\"\n"
+            "#include \"matematica.h\"\n\n"
+            "/* função do usuário pelo nome; se não estiver registrada com a aridade certa, aborta */\n"
+            "static inline const DescritorFuncao *geradoDescritor(const char *nome, int tam, int aridade) {\n"
+            "    const DescritorFuncao *d = descritorFuncao(idFuncao(nome, tam));\n"
+            "    if (!d || d->aridade != aridade) {\n"
+            "        fprintf(stderr, \"formula gerada: funcao %%s/%%d nao registrada\\n\", nome, aridade);\n"
+            "        abort();\n"
+            "    }\n"
+            "    return d;\n"
+            "}\n"
+            "static inline FuncaoUnaria geradoFuncaoUnaria(const char *nome, int tam) {\n"
+            "    return geradoDescritor(nome, tam, 1)->unaria;\n"
+            "}\n"
+            "static inline FuncaoBinaria geradoFuncaoBinaria(const char *nome, int tam) {\n"
+            "    return geradoDescritor(nome, tam, 2)->binaria;\n"
+            "}\n\n"
+            "/* o GCC junta a * b + c numa FMA por padrão (-ffp-contract=fast), que arredonda uma vez só;\n"
+            "   a barreira depois de cada produto mantém os dois arredondamentos do interpretador */\n"
+            "#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)\n"
+            "#define GERADO_SEM_FMA(v) __asm__(\"\" : \"+x\"(v))\n"
+            "#elif defined(__GNUC__) && !defined(__clang__) && defined(__aarch64__)\n"
+            "#define GERADO_SEM_FMA(v) __asm__(\"\" : \"+w\"(v))\n"
+            "#else\n"
+            "#define GERADO_SEM_FMA(v) ((void)0)\n"
+            "#endif\n");
+}
+
+int gerarFuncaoC(const Programa *prog, const char *nome, FILE *saida) {
+    Operando *pilha, *temp;
+    unsigned char procuradas[MAX_FUNCOES / 8] = { 0 }; // funções do usuário com o ponteiro já declarado
+    int topo = -1, locais = 0, usaValores = 0, i;
+    if (!prog || !nome || !ehIdentificadorC(nome, strlen(nome))) return -1;
+    pilha = (Operando*)malloc(sizeof(Operando) * (size_t)(prog->profundidadeMax + prog->nTemporarios + 1));
+    if (!pilha) return -1;
+    temp = pilha + prog->profundidadeMax;
+
+    fprintf(saida, "static inline float %s(const float *valores) {\n", nome);
+    for (i = 0; i < prog->tamanho; ++i) {
+        const Instrucao *ins = &prog->codigo[i];
+        switch (ins->op) {
+            case OP_CONST: escreverLiteral(pilha[++topo], ins->arg.valor); break;
+            case OP_VAR:
+                snprintf(pilha[++topo], TAM_OPERANDO, "valores[%d]", ins->arg.indice);
+                usaValores = 1;
+                break;
+            case OP_SOMA:
+            case OP_SUB:
+            case OP_MUL:
+                --topo;
+                if (ins->op == OP_MUL) escreverProduto(saida, locais, pilha[topo], pilha[topo + 1]);
+                else fprintf(saida, "    float v%d = %s %c %s;\n", locais, pilha[topo], operadorDoCodigo(ins->op), pilha[topo + 1]);
+                snprintf(pilha[topo], TAM_OPERANDO, "v%d", locais++);
+                break;
+            case OP_DIV:
+                --topo;
+                if (prog->codigo[i - 1].op == OP_CONST && prog->codigo[i - 1].arg.valor != 0.0f) {
+                    fprintf(saida, "    float v%d = %s / %s;\n", locais, pilha[topo], pilha[topo + 1]);
+                    snprintf(pilha[topo], TAM_OPERANDO, "v%d", locais++);
+                    break;
+                }
+                fprintf(saida, "    float v%d = (%s != 0.0f) ? %s / %s : 0.0f;\n", locais,
+                        pilha[topo + 1], pilha[topo], pilha[topo + 1]);
+                snprintf(pilha[topo], TAM_OPERANDO, "v%d", locais++);
+                break;
+            case OP_POT:
+                /* expoente constante inteiro: os mesmos quadrados de aplicarOperadorBinario, sem chamada */
+                if (i > 0 && prog->codigo[i - 1].op == OP_CONST) {
+                    float b = prog->codigo[i - 1].arg.valor;
+                    if (b == truncf(b) && fabsf(b) < 2147483648.0f) {
+                        --topo;
+                        gerarPotencia(saida, pilha[topo], (unsigned)fabsf(b), b < 0.0f, &locais);
+                        break;
+                    }
+                }
+                /* fall through */
+            case OP_MOD:
+                --topo;
+                fprintf(saida, "    float v%d = aplicarOperadorBinario('%c', %s, %s);\n", locais,
+                        operadorDoCodigo(ins->op), pilha[topo], pilha[topo + 1]);
+                snprintf(pilha[topo], TAM_OPERANDO, "v%d", locais++);
+                break;
+            case OP_FUNC: {
+                const DescritorFuncao *d = descritorFuncao(ins->funcao);
+                if (ins->funcao < FUNC_QUANTIDADE && prog->precisao == PRECISAO_LIBM) {
+                    fprintf(saida, "    float v%d = %s(%s);\n", locais, funcoesEmbutidas[ins->funcao], pilha[topo]);
+                } else if (ins->funcao < FUNC_QUANTIDADE) {
+                    fprintf(saida, "    float v%d = funcaoPrecisao(%s, %s)(%s);\n", locais,
+                            nomesEmbutidas[ins->funcao], nomesPrecisao[prog->precisao], pilha[topo]);
+                } else {
+                    /* função do usuário (a mesma em toda precisão): ponteiro procurado pelo nome só na primeira chamada */
+                    const char *tipo = (d->aridade == 2) ? "Binaria" : "Unaria";
+                    if (!(procuradas[ins->funcao / 8] & (1u << (ins->funcao % 8)))) {
+                        procuradas[ins->funcao / 8] |= (unsigned char)(1u << (ins->funcao % 8));
+                        fprintf(saida, "    static Funcao%s funcao_%s;\n", tipo, d->nome);
+                        fprintf(saida, "    if (!funcao_%s) funcao_%s = geradoFuncao%s(\"%s\", %d);\n",
+                                d->nome, d->nome, tipo, d->nome, d->tamNome);
+                    }
+                    if (d->aridade == 2) {
+                        --topo;
+                        fprintf(saida, "    float v%d = funcao_%s(%s, %s);\n", locais, d->nome, pilha[topo], pilha[topo + 1]);
+                    } else {
+                        fprintf(saida, "    float v%d = funcao_%s(%s);\n", locais, d->nome, pilha[topo]);
+                    }
+                }
+                snprintf(pilha[topo], TAM_OPERANDO, "v%d", locais++);
+            } break;
+            /* temporários são só nomes: a variável local já guarda o valor */
+            case OP_GUARDAR: memcpy(temp[ins->arg.indice], pilha[topo], sizeof(Operando)); break;
+            case OP_CARREGAR: memcpy(pilha[++topo], temp[ins->arg.indice], sizeof(Operando)); break;
+        }
+    }
+    if (!usaValores) fprintf(saida, "    (void)valores;\n");
+    fprintf(saida, "    return %s;\n}\n", topo >= 0 ? pilha[topo] : "0.0f");
+    free(pilha);
+    return 0;
+}
+
+static char *lerTudo(FILE *arq) {
+    size_t cap = 1 << 16, tam = 0, lidos;
+    char *buf = (char*)malloc(cap);
+    if (!buf) return NULL;
+    while ((lidos = fread(buf + tam, 1, cap - tam - 1, arq)) > 0) {
+        tam += lidos;
+        if (tam + 1 == cap) {
+            char *maior = (char*)realloc(buf, cap * 2);
+            if (!maior) { free(buf); return NULL; }
+            buf = maior;
+            cap *= 2;
+        }
+    }
+    if (ferror(arq)) { free(buf); return NULL; }
+    buf[tam] = '\0';
+    return buf;
+}
+
+static void aparar(char **ini, char **fim) {
+    while (*ini < *fim && isspace((unsigned char)**ini)) ++*ini;
+    while (*fim > *ini && isspace((unsigned char)(*fim)[-1])) --*fim;
+}
+
+/* comentário com o texto da fórmula, separando "*" "/" para não fechar nem abrir outro comentário */
+static void escreverComentario(FILE *saida, const char *nome, const char *expr, const Programa *prog) {
+    const char *p;
+    int i;
+    fprintf(saida, "\n/* %s = ", nome);
+    for (p = expr; *p; ++p) {
+        fputc(*p, saida);
+        if ((p[0] == '*' && p[1] == '/') || (p[0] == '/' && p[1] == '*')) fputc(' ', saida);
+    }
+    if (prog->nVariaveis > 0) {
+        fprintf(saida, "\n   valores:");
+        for (i = 0; i < prog->nVariaveis; ++i) fprintf(saida, " [%d] %s", i, prog->variaveis[i]);
+    }
+    fprintf(saida, " */\n");
+}
+
+int gerarCabecalhoC(const char *caminho, FILE *saida) {
+    FILE *arq = (!caminho || strcmp(caminho, "-") == 0) ? stdin : fopen(caminho, "rb");
+    char *texto, *linha;
+    int numero = 0, r = 0;
+    if (!arq) return -1;
+    texto = lerTudo(arq);
+    if (arq != stdin) fclose(arq);
+    if (!texto) return -1;
+
+    fprintf(saida,
+            "/* Gerado por \"expressao --gerar-c\": uma função por fórmula, com o mesmo resultado de\n"
+            "   avaliarPrograma. Compile e ligue junto com o projeto. */\n"
+            "#ifndef FORMULAS_GERADAS_H\n"
+            "#define FORMULAS_GERADAS_H\n");
+    gerarPreambuloC(saida);
+    for (linha = texto; *linha && r == 0; ) {
+        char *fimLinha = strchr(linha, '\n'), *prox, *igual, *ini, *fim;
+        if (!fimLinha) fimLinha = linha + strlen(linha);
+        prox = *fimLinha ? fimLinha + 1 : fimLinha;
+        ++numero;
+        ini = linha;
+        fim = fimLinha;
+        aparar(&ini, &fim);
+        if (ini < fim && *ini != '#') {
+            Programa *prog = NULL;
+            char *nome = ini, *fimNome;
+            igual = (char*)memchr(ini, '=', (size_t)(fim - ini));
+            if (igual) {
+                fimNome = igual;
+                aparar(&nome, &fimNome);
+                ini = igual + 1;
+                aparar(&ini, &fim);
+                *fimNome = '\0';
+                *fim = '\0';
+                if (ehIdentificadorC(nome, strlen(nome))) prog = compilarExpressao(ini, NULL, 0);
+            }
+            if (!prog) {
+                fprintf(stderr, "linha %d: esperado \"nome = expressão\" com nome de identificador C e expressão válida\n", numero);
+                r = -1;
+            } else {
+                escreverComentario(saida, nome, ini, prog);
+                r = gerarFuncaoC(prog, nome, saida);
+                liberarPrograma(prog);
+            }
+        }
+        linha = prox;
+    }
+    fprintf(saida, "\n#endif\n");
+    free(texto);
+    return r;
+}
@@ -0,0 +1,41 @@
+#ifndef GERACAO_H
+#define GERACAO_H
+#include <stdio.h>
+#include "programa.h"
+
+/*
+ * Código C para fórmulas fixas, gerado na compilação do projeto em vez de
+ * analisar e interpretar a expressão a cada execução. Cada fórmula vira
+ * "static inline float nome(const float *valores)" em linha reta, sem
+ * pilha: subexpressões repetidas são variáveis locais e o que é constante
+ * já vem calculado pelo otimizador (uma fórmula sem variáveis vira só o
+ * valor, escrito em hexadecimal, exato). +, -, * e / são escritos direto;
+ * % e ^ chamam aplicarOperadorBinario e as funções são chamadas como em
+ * avaliarPrograma (na precisão do programa), então o resultado é idêntico
+ * ao do interpretador. Funções do usuário são procuradas pelo nome uma vez,
+ * na primeira chamada de cada fórmula, e precisam estar registradas até lá
+ * (se não estiverem, o programa aborta com uma mensagem). O código usa expressao.h,
+ * funcoes.h e matematica.h e deve ser ligado com o resto do projeto.
+ * Fora de PRECISAO_LIBM, as constantes calculadas na geração só coincidem
+ * se o gerador foi compilado com as mesmas opções de vetorização.
+ */
+
+/*
+ * Includes, a barreira GERADO_SEM_FMA e as funções que procuram as funções
+ * do usuário pelo nome (abortam se ela não estiver registrada). Vem uma vez
+ * antes das funções de gerarFuncaoC; gerarCabecalhoC já o escreve.
+ */
+void gerarPreambuloC(FILE *saida);
+
+/* Escreve a função de prog com o nome dado. Retorna 0, ou -1 se nome não for um identificador C. */
+int gerarFuncaoC(const Programa *prog, const char *nome, FILE *saida);
+
+/*
+ * Lê linhas "nome = expressão" de caminho (NULL ou "-": entrada padrão;
+ * linhas vazias e começadas por '#' são ignoradas) e escreve um cabeçalho
+ * com uma função por linha. As variáveis de cada fórmula ficam na ordem
+ * em que aparecem, anotadas num comentário. Retorna 0, ou -1 em erro de
+ * leitura ou linha inválida (indicada na saída de erro).
+ */
+int gerarCabecalhoC(const char *caminho, FILE *saida);
+#endif
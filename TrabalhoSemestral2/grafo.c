@@ -0,0 +1,606 @@
+/* grafo.c - grafo de fórmulas com recálculo incremental */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "expressao.h"
+#include "programa.h"
+#include "funcoes.h"
+#include "grafo.h"
+
+/* nó de uma fórmula: uma instrução do programa, com os filhos por índice.
+   OP_GUARDAR/OP_CARREGAR não viram nós: a subexpressão repetida é um nó com vários pais. */
+typedef struct {
+    unsigned char op;     // CodigoOp
+    unsigned char funcao; // OP_FUNC
+    int esq, dir;         // filhos (só esq em função unária), ou -1
+    union {
+        float valor;      // OP_CONST
+        int indice;       // OP_VAR: variável do programa
+    } arg;
+} NoFormula;
+
+typedef struct {
+    int celula;                 // célula que recebe o resultado
+    Programa *prog;
+    NoFormula *nos;             // em ordem pós-fixa: filhos antes dos pais
+    int nNos;
+    int raiz;
+    float *valores;             // valor de cada nó na última avaliação
+    unsigned char *sujo;
+    int menorSujo;              // primeiro nó sujo, ou nNos
+    int *inicioPais, *pais;     // pais do nó i: pais[inicioPais[i] .. inicioPais[i+1])
+    int *inicioFolhas, *folhas; // nós OP_VAR da variável v: folhas[inicioFolhas[v] .. inicioFolhas[v+1])
+    int *celulaDaVariavel;      // célula lida por cada variável do programa
+    int pendente;               // está na fila de recálculo
+} Formula;
+
+typedef struct {
+    int formula;
+    int variavel;               // variável da fórmula que lê a célula
+} Uso;
+
+typedef struct {
+    long long ordem;
+    int celula;
+} ParOrdem;
+
+typedef struct {
+    char *nome;
+    float valor;
+    int formula;                // índice em formulas, ou -1 (entrada)
+    long long ordem;            // ordem topológica: menor que a de toda fórmula que lê esta célula
+    unsigned visita;            // marca das buscas (geracao)
+    Uso *usos;                  // quem lê esta célula
+    int nUsos, capUsos;
+} Celula;
+
+struct GrafoFormulas {
+    Celula *celulas;
+    int nCelulas, capCelulas;
+    int *baldes;                // nome -> célula, endereçamento aberto, -1 = vazio
+    size_t mascara;
+    Formula *formulas;
+    int nFormulas, capFormulas;
+    int *fila;                  // fórmulas pendentes, heap pela ordem da célula
+    int nFila, capFila;
+    int *pilha;                 // trabalho das buscas; cabe max(células, nós de uma fórmula)
+    int capPilha;
+    ParOrdem *pares;            // reordenação: células afetadas e as ordens delas (cabem todas as células)
+    long long *ordens;
+    int capPares, capOrdens;
+    long long menorOrdem, maiorOrdem;
+    unsigned geracao;
+    size_t nos;
+    unsigned long long recalculos, nosRecalculados;
+};
+
+/* p com espaço para n itens de tam bytes (a capacidade dobra); NULL sem memória, p intacto */
+static void *crescer(void *p, int *cap, int n, size_t tam) {
+    int novaCap;
+    void *novo;
+    if (n <= *cap) return p;
+    novaCap = *cap ? *cap : 8;
+    while (novaCap < n) novaCap *= 2;
+    novo = realloc(p, tam * (size_t)novaCap);
+    if (!novo) return NULL;
+    *cap = novaCap;
+    return novo;
+}
+
+static size_t hashNome(const char *s) {
+    size_t h = 2166136261u;
+    for (; *s; ++s) h = (h ^ (unsigned char)*s) * 16777619u;
+    return h;
+}
+
+/* identificador que não é nome de função, como os de variáveis em compilarExpressao */
+static int nomeValido(const char *nome) {
+    const char *p;
+    if (!nome || !(isalpha((unsigned char)nome[0]) || nome[0] == '_')) return 0;
+    for (p = nome; *p; ++p) {
+        if (!isalnum((unsigned char)*p) && *p != '_') return 0;
+    }
+    return idFuncao(nome, (int)(p - nome)) < 0;
+}
+
+static int buscarCelula(const GrafoFormulas *g, const char *nome) {
+    size_t i;
+    for (i = hashNome(nome) & g->mascara; g->baldes[i] >= 0; i = (i + 1) & g->mascara) {
+        if (strcmp(g->celulas[g->baldes[i]].nome, nome) == 0) return g->baldes[i];
+    }
+    return -1;
+}
+
+static void inserirBalde(GrafoFormulas *g, int c) {
+    size_t i = hashNome(g->celulas[c].nome) & g->mascara;
+    while (g->baldes[i] >= 0) i = (i + 1) & g->mascara;
+    g->baldes[i] = c;
+}
+
+/* célula do nome, criada como entrada de valor 0 se ainda não existir; -1 sem memória.
+   Uma célula nova que já nasce lida vai para o começo da ordem; uma que nasce fórmula, para o fim. */
+static int celulaDoNome(GrafoFormulas *g, const char *nome, int lida) {
+    Celula *cel;
+    int c = buscarCelula(g, nome);
+    size_t tam;
+    if (c >= 0) return c;
+    cel = (Celula*)crescer(g->celulas, &g->capCelulas, g->nCelulas + 1, sizeof(Celula));
+    if (!cel) return -1;
+    g->celulas = cel;
+    if ((size_t)(g->nCelulas + 1) * 2 > g->mascara + 1) {
+        size_t novoTam = (g->mascara + 1) * 2;
+        int *novo = (int*)malloc(sizeof(int) * novoTam);
+        int i;
+        if (!novo) return -1;
+        free(g->baldes);
+        g->baldes = novo;
+        g->mascara = novoTam - 1;
+        memset(g->baldes, 0xff, sizeof(int) * novoTam);
+        for (i = 0; i < g->nCelulas; ++i) inserirBalde(g, i);
+    }
+    c = g->nCelulas;
+    cel = &g->celulas[c];
+    memset(cel, 0, sizeof(*cel));
+    tam = strlen(nome) + 1;
+    if (!(cel->nome = (char*)malloc(tam))) return -1;
+    memcpy(cel->nome, nome, tam);
+    cel->formula = -1;
+    cel->ordem = lida ? --g->menorOrdem : ++g->maiorOrdem;
+    g->nCelulas++;
+    inserirBalde(g, c);
+    return c;
+}
+
+GrafoFormulas *criarGrafo(void) {
+    GrafoFormulas *g = (GrafoFormulas*)calloc(1, sizeof(GrafoFormulas));
+    if (!g) return NULL;
+    g->mascara = 63;
+    g->baldes = (int*)malloc(sizeof(int) * (g->mascara + 1));
+    if (!g->baldes) { free(g); return NULL; }
+    memset(g->baldes, 0xff, sizeof(int) * (g->mascara + 1));
+    return g;
+}
+
+static void liberarFormula(Formula *f) {
+    liberarPrograma(f->prog);
+    free(f->nos);
+    free(f->valores);
+    free(f->sujo);
+    free(f->inicioPais);
+    free(f->pais);
+    free(f->inicioFolhas);
+    free(f->folhas);
+    free(f->celulaDaVariavel);
+    memset(f, 0, sizeof(*f));
+}
+
+void destruirGrafo(GrafoFormulas *g) {
+    int i;
+    if (!g) return;
+    for (i = 0; i < g->nFormulas; ++i) liberarFormula(&g->formulas[i]);
+    for (i = 0; i < g->nCelulas; ++i) {
+        free(g->celulas[i].nome);
+        free(g->celulas[i].usos);
+    }
+    free(g->celulas);
+    free(g->baldes);
+    free(g->formulas);
+    free(g->fila);
+    free(g->pilha);
+    free(g->pares);
+    free(g->ordens);
+    free(g);
+}
+
+/* ---- fila de recálculo: heap mínimo pela ordem da célula de cada fórmula ---- */
+
+static long long ordemNaFila(const GrafoFormulas *g, int k) {
+    return g->celulas[g->formulas[g->fila[k]].celula].ordem;
+}
+
+static void descerNaFila(GrafoFormulas *g, int k) {
+    for (;;) {
+        int menor = k, e = 2 * k + 1, d = 2 * k + 2, t;
+        if (e < g->nFila && ordemNaFila(g, e) < ordemNaFila(g, menor)) menor = e;
+        if (d < g->nFila && ordemNaFila(g, d) < ordemNaFila(g, menor)) menor = d;
+        if (menor == k) return;
+        t = g->fila[k]; g->fila[k] = g->fila[menor]; g->fila[menor] = t;
+        k = menor;
+    }
+}
+
+static void entrarNaFila(GrafoFormulas *g, int f) {
+    int k = g->nFila++;
+    g->fila[k] = f;
+    while (k > 0 && ordemNaFila(g, (k - 1) / 2) > ordemNaFila(g, k)) {
+        int pai = (k - 1) / 2, t = g->fila[k];
+        g->fila[k] = g->fila[pai];
+        g->fila[pai] = t;
+        k = pai;
+    }
+}
+
+static int sairDaFila(GrafoFormulas *g) {
+    int f = g->fila[0];
+    g->fila[0] = g->fila[--g->nFila];
+    descerNaFila(g, 0);
+    return f;
+}
+
+/* ---- marcação: só os nós no caminho de uma folha alterada até a raiz ficam sujos ---- */
+
+static void marcarNo(GrafoFormulas *g, Formula *f, int no) {
+    int topo = 0;
+    if (f->sujo[no]) return;
+    f->sujo[no] = 1;
+    g->pilha[topo++] = no;
+    while (topo > 0) {
+        int x = g->pilha[--topo], k;
+        if (x < f->menorSujo) f->menorSujo = x;
+        for (k = f->inicioPais[x]; k < f->inicioPais[x + 1]; ++k) {
+            int p = f->pais[k];
+            if (!f->sujo[p]) {
+                f->sujo[p] = 1;
+                g->pilha[topo++] = p;
+            }
+        }
+    }
+}
+
+/* o valor da célula c mudou: suja as folhas que a leem e enfileira suas fórmulas */
+static void marcarUsos(GrafoFormulas *g, int c) {
+    int i, k;
+    for (i = 0; i < g->celulas[c].nUsos; ++i) {
+        Uso u = g->celulas[c].usos[i];
+        Formula *f = &g->formulas[u.formula];
+        for (k = f->inicioFolhas[u.variavel]; k < f->inicioFolhas[u.variavel + 1]; ++k) marcarNo(g, f, f->folhas[k]);
+        if (!f->pendente) {
+            f->pendente = 1;
+            entrarNaFila(g, u.formula);
+        }
+    }
+}
+
+/* refaz os nós sujos, de menorSujo em diante (os filhos vêm antes dos pais), e devolve a raiz */
+static float avaliarFormula(GrafoFormulas *g, Formula *f) {
+    float *val = f->valores;
+    int i;
+    for (i = f->menorSujo; i < f->nNos; ++i) {
+        const NoFormula *no = &f->nos[i];
+        if (!f->sujo[i]) continue;
+        f->sujo[i] = 0;
+        g->nosRecalculados++;
+        switch (no->op) {
+            case OP_CONST: val[i] = no->arg.valor; break;
+            case OP_VAR: val[i] = g->celulas[f->celulaDaVariavel[no->arg.indice]].valor; break;
+            case OP_FUNC: {
+                const DescritorFuncao *d = descritorFuncao(no->funcao);
+                val[i] = (d->aridade == 2) ? d->binaria(val[no->esq], val[no->dir]) : d->unaria(val[no->esq]);
+            } break;
+            default: val[i] = aplicarOperadorBinario(operadorDoCodigo(no->op), val[no->esq], val[no->dir]); break;
+        }
+    }
+    f->menorSujo = f->nNos;
+    g->recalculos++;
+    return val[f->raiz];
+}
+
+int recalcularGrafo(GrafoFormulas *g) {
+    int n = 0;
+    if (!g) return 0;
+    while (g->nFila > 0) {
+        Formula *f = &g->formulas[sairDaFila(g)];
+        float v;
+        f->pendente = 0;
+        v = avaliarFormula(g, f);
+        ++n;
+        /* compara os bits: sem mudança (inclusive NaN igual), quem lê a célula não é tocado */
+        if (memcmp(&v, &g->celulas[f->celula].valor, sizeof(v)) != 0) {
+            g->celulas[f->celula].valor = v;
+            marcarUsos(g, f->celula);
+        }
+    }
+    return n;
+}
+
+/* ---- definição de fórmulas ---- */
+
+/* monta os nós, pais e folhas de prog em f (todos sujos); 0 ou -1 */
+static int montarFormula(Formula *f, Programa *prog) {
+    int *pilha, *temp, *cont;
+    int topo = -1, i, n = 0, ok;
+    memset(f, 0, sizeof(*f));
+    f->prog = prog;
+    pilha = (int*)malloc(sizeof(int) * (size_t)(prog->profundidadeMax + prog->nTemporarios + 1));
+    f->nos = (NoFormula*)malloc(sizeof(NoFormula) * (size_t)prog->tamanho);
+    if (!pilha || !f->nos) { free(pilha); free(f->nos); return -1; }
+    temp = pilha + prog->profundidadeMax;
+    for (i = 0; i < prog->tamanho; ++i) {
+        const Instrucao *ins = &prog->codigo[i];
+        NoFormula *no = &f->nos[n];
+        if (ins->op == OP_GUARDAR) { temp[ins->arg.indice] = pilha[topo]; continue; }
+        if (ins->op == OP_CARREGAR) { pilha[++topo] = temp[ins->arg.indice]; continue; }
+        no->op = ins->op;
+        no->funcao = ins->funcao;
+        no->esq = no->dir = -1;
+        no->arg.indice = 0;
+        if (ins->op == OP_CONST) {
+            no->arg.valor = ins->arg.valor;
+        } else if (ins->op == OP_VAR) {
+            no->arg.indice = ins->arg.indice;
+        } else {
+            if (ins->op != OP_FUNC || aridadeFuncao(ins->funcao) == 2) no->dir = pilha[topo--];
+            no->esq = pilha[topo--];
+        }
+        pilha[++topo] = n++;
+    }
+    f->nNos = n;
+    f->raiz = pilha[topo];
+    free(pilha);
+
+    f->valores = (float*)calloc((size_t)n, sizeof(float));
+    f->sujo = (unsigned char*)malloc((size_t)n);
+    f->inicioPais = (int*)calloc((size_t)n + 1, sizeof(int));
+    f->pais = (int*)malloc(sizeof(int) * (size_t)(2 * n));
+    f->inicioFolhas = (int*)calloc((size_t)prog->nVariaveis + 1, sizeof(int));
+    f->folhas = (int*)malloc(sizeof(int) * (size_t)n);
+    f->celulaDaVariavel = (int*)malloc(sizeof(int) * (size_t)(prog->nVariaveis + 1));
+    cont = (int*)calloc((size_t)n + (size_t)prog->nVariaveis + 1, sizeof(int));
+    ok = f->valores && f->sujo && f->inicioPais && f->pais && f->inicioFolhas && f->folhas && f->celulaDaVariavel && cont;
+    if (ok) {
+        /* listas compactas: conta, acumula os inícios e preenche */
+        for (i = 0; i < n; ++i) {
+            if (f->nos[i].esq >= 0) f->inicioPais[f->nos[i].esq + 1]++;
+            if (f->nos[i].dir >= 0) f->inicioPais[f->nos[i].dir + 1]++;
+            if (f->nos[i].op == OP_VAR) f->inicioFolhas[f->nos[i].arg.indice + 1]++;
+        }
+        for (i = 0; i < n; ++i) f->inicioPais[i + 1] += f->inicioPais[i];
+        for (i = 0; i < prog->nVariaveis; ++i) f->inicioFolhas[i + 1] += f->inicioFolhas[i];
+        for (i = 0; i < n; ++i) {
+            const NoFormula *no = &f->nos[i];
+            if (no->esq >= 0) f->pais[f->inicioPais[no->esq] + cont[no->esq]++] = i;
+            if (no->dir >= 0) f->pais[f->inicioPais[no->dir] + cont[no->dir]++] = i;
+            if (no->op == OP_VAR) {
+                int v = no->arg.indice;
+                f->folhas[f->inicioFolhas[v] + cont[n + v]++] = i;
+            }
+        }
+        memset(f->sujo, 1, (size_t)n);
+    }
+    free(cont);
+    f->menorSujo = 0;
+    if (!ok) {
+        f->prog = NULL; // fica com o chamador
+        liberarFormula(f);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Ordem topológica incremental (Pearce e Kelly): a nova fórmula c lê células
+ * que podem vir depois dela. Só a faixa entre a ordem de c e a maior ordem
+ * lida (limite) é afetada: os dependentes de c nessa faixa (F) e as células
+ * de que as lidas dependem, acima de c (B). B passa para antes de F reusando
+ * as mesmas ordens, e o resto do grafo não muda.
+ */
+
+static int compararOrdem(const void *a, const void *b) {
+    long long x = ((const ParOrdem*)a)->ordem, y = ((const ParOrdem*)b)->ordem;
+    return (x > y) - (x < y);
+}
+
+static int compararLongLong(const void *a, const void *b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+/* F em pares[0..): células que dependem de c com ordem < limite; -1 se chegar a uma lida (ciclo) */
+static int seguirDependentes(GrafoFormulas *g, int c, long long limite, unsigned lida) {
+    unsigned visto = ++g->geracao;
+    int topo = 0, n = 0, i;
+    g->celulas[c].visita = visto;
+    g->pilha[topo++] = c;
+    while (topo > 0) {
+        const Celula *x = &g->celulas[g->pilha[--topo]];
+        g->pares[n].ordem = x->ordem;
+        g->pares[n++].celula = (int)(x - g->celulas);
+        for (i = 0; i < x->nUsos; ++i) {
+            Celula *d = &g->celulas[g->formulas[x->usos[i].formula].celula];
+            if (d->visita == lida) return -1;
+            if (d->visita != visto && d->ordem < limite) {
+                d->visita = visto;
+                g->pilha[topo++] = (int)(d - g->celulas);
+            }
+        }
+    }
+    return n;
+}
+
+/* acrescenta B em pares[n..) a partir das células lidas por f com ordem > piso; retorna o novo n */
+static int seguirLidas(GrafoFormulas *g, const Formula *f, long long piso, int n) {
+    unsigned visto = ++g->geracao;
+    int topo = 0, v;
+    for (v = 0; v < f->prog->nVariaveis; ++v) {
+        Celula *r = &g->celulas[f->celulaDaVariavel[v]];
+        if (r->ordem > piso && r->visita != visto) {
+            r->visita = visto;
+            g->pilha[topo++] = f->celulaDaVariavel[v];
+        }
+    }
+    while (topo > 0) {
+        const Celula *x = &g->celulas[g->pilha[--topo]];
+        g->pares[n].ordem = x->ordem;
+        g->pares[n++].celula = (int)(x - g->celulas);
+        if (x->formula < 0) continue;
+        {
+            const Formula *fx = &g->formulas[x->formula];
+            for (v = 0; v < fx->prog->nVariaveis; ++v) {
+                Celula *y = &g->celulas[fx->celulaDaVariavel[v]];
+                if (y->ordem > piso && y->visita != visto) {
+                    y->visita = visto;
+                    g->pilha[topo++] = fx->celulaDaVariavel[v];
+                }
+            }
+        }
+    }
+    return n;
+}
+
+/* B (pares[nF..n)) recebe as menores ordens da faixa, na ordem em que já estava, e F as maiores */
+static void reordenar(GrafoFormulas *g, int nF, int n) {
+    int i;
+    for (i = 0; i < n; ++i) g->ordens[i] = g->pares[i].ordem;
+    qsort(g->ordens, (size_t)n, sizeof(long long), compararLongLong);
+    qsort(g->pares, (size_t)nF, sizeof(ParOrdem), compararOrdem);
+    qsort(g->pares + nF, (size_t)(n - nF), sizeof(ParOrdem), compararOrdem);
+    for (i = nF; i < n; ++i) g->celulas[g->pares[i].celula].ordem = g->ordens[i - nF];
+    for (i = 0; i < nF; ++i) g->celulas[g->pares[i].celula].ordem = g->ordens[n - nF + i];
+}
+
+static void removerUsos(Celula *cel, int formula) {
+    int i = 0;
+    while (i < cel->nUsos) {
+        if (cel->usos[i].formula == formula) cel->usos[i] = cel->usos[--cel->nUsos];
+        else ++i;
+    }
+}
+
+int definirFormula(GrafoFormulas *g, const char *nome, const char *expr) {
+    Formula nova, *f;
+    Programa *prog;
+    int c, fi, v, maior, nF = 0, *p;
+    long long limite, piso;
+    if (!g || !nomeValido(nome) || !expr) return -1;
+    c = celulaDoNome(g, nome, 0);
+    if (c < 0 || !(prog = compilarExpressao(expr, NULL, 0))) return -1;
+    if (montarFormula(&nova, prog) != 0) { liberarPrograma(prog); return -1; }
+
+    /* células lidas (criadas se preciso) e todo o espaço que o resto vai usar */
+    for (v = 0; v < prog->nVariaveis; ++v) {
+        int r = nomeValido(prog->variaveis[v]) ? celulaDoNome(g, prog->variaveis[v], 1) : -1;
+        Uso *u;
+        if (r < 0) goto falha;
+        nova.celulaDaVariavel[v] = r;
+        u = (Uso*)crescer(g->celulas[r].usos, &g->celulas[r].capUsos, g->celulas[r].nUsos + 1, sizeof(Uso));
+        if (!u) goto falha;
+        g->celulas[r].usos = u;
+    }
+    fi = g->celulas[c].formula;
+    if (fi < 0) {
+        Formula *fs = (Formula*)crescer(g->formulas, &g->capFormulas, g->nFormulas + 1, sizeof(Formula));
+        if (!fs) goto falha;
+        g->formulas = fs;
+        p = (int*)crescer(g->fila, &g->capFila, g->nFormulas + 1, sizeof(int));
+        if (!p) goto falha;
+        g->fila = p;
+    }
+    maior = (g->nCelulas > nova.nNos) ? g->nCelulas : nova.nNos;
+    p = (int*)crescer(g->pilha, &g->capPilha, maior, sizeof(int));
+    if (!p) goto falha;
+    g->pilha = p;
+    {
+        ParOrdem *pares = (ParOrdem*)crescer(g->pares, &g->capPares, g->nCelulas, sizeof(ParOrdem));
+        long long *ordens;
+        if (!pares) goto falha;
+        g->pares = pares;
+        ordens = (long long*)crescer(g->ordens, &g->capOrdens, g->nCelulas, sizeof(long long));
+        if (!ordens) goto falha;
+        g->ordens = ordens;
+    }
+
+    /* ciclo: c é lida por ela mesma ou alcança, pelos dependentes, uma célula lida.
+       Se todas as lidas vêm antes de c na ordem, nenhuma pode depender dela. */
+    piso = limite = g->celulas[c].ordem;
+    for (v = 0; v < prog->nVariaveis; ++v) {
+        const Celula *r = &g->celulas[nova.celulaDaVariavel[v]];
+        if (nova.celulaDaVariavel[v] == c) goto falha;
+        if (r->ordem > limite) limite = r->ordem;
+    }
+    if (limite > piso) {
+        unsigned lida = ++g->geracao;
+        for (v = 0; v < prog->nVariaveis; ++v) g->celulas[nova.celulaDaVariavel[v]].visita = lida;
+        nF = seguirDependentes(g, c, limite, lida);
+        if (nF < 0) goto falha;
+    }
+
+    /* daqui em diante nada falha */
+    if (fi < 0) {
+        fi = g->nFormulas++;
+        g->formulas[fi].pendente = 0;
+        g->celulas[c].formula = fi;
+    } else {
+        f = &g->formulas[fi];
+        for (v = 0; v < f->prog->nVariaveis; ++v) removerUsos(&g->celulas[f->celulaDaVariavel[v]], fi);
+        g->nos -= (size_t)f->nNos;
+        nova.pendente = f->pendente;
+        liberarFormula(f);
+    }
+    f = &g->formulas[fi];
+    nova.celula = c;
+    *f = nova;
+    g->nos += (size_t)f->nNos;
+    for (v = 0; v < prog->nVariaveis; ++v) {
+        Celula *r = &g->celulas[f->celulaDaVariavel[v]];
+        r->usos[r->nUsos].formula = fi;
+        r->usos[r->nUsos].variavel = v;
+        r->nUsos++;
+    }
+    if (limite > piso) {
+        /* as ordens mudaram: refaz o heap */
+        reordenar(g, nF, seguirLidas(g, f, piso, nF));
+        for (v = g->nFila / 2 - 1; v >= 0; --v) descerNaFila(g, v);
+    }
+    if (!f->pendente) {
+        f->pendente = 1;
+        entrarNaFila(g, fi);
+    }
+    return 0;
+
+falha:
+    liberarFormula(&nova);
+    return -1;
+}
+
+int definirEntrada(GrafoFormulas *g, const char *nome, float valor) {
+    int c;
+    if (!g || !nomeValido(nome)) return -1;
+    c = celulaDoNome(g, nome, 1);
+    if (c < 0 || g->celulas[c].formula >= 0) return -1;
+    if (memcmp(&valor, &g->celulas[c].valor, sizeof(valor)) == 0) return 0;
+    g->celulas[c].valor = valor;
+    marcarUsos(g, c);
+    return 0;
+}
+
+int definirEntradas(GrafoFormulas *g, const char *const *nomes, const float *valores, int n) {
+    int i;
+    if (!nomes || !valores) return -1;
+    for (i = 0; i < n; ++i) {
+        if (definirEntrada(g, nomes[i], valores[i]) != 0) return -1;
+    }
+    return 0;
+}
+
+int valorCelula(GrafoFormulas *g, const char *nome, float *valor) {
+    int c;
+    if (!g || !nome || !valor) return -1;
+    c = buscarCelula(g, nome);
+    if (c < 0) return -1;
+    recalcularGrafo(g);
+    *valor = g->celulas[c].valor;
+    return 0;
+}
+
+void estatisticasGrafo(const GrafoFormulas *g, EstatisticasGrafo *est) {
+    if (!est) return;
+    memset(est, 0, sizeof(*est));
+    if (!g) return;
+    est->celulas = g->nCelulas;
+    est->formulas = g->nFormulas;
+    est->nos = g->nos;
+    est->recalculos = g->recalculos;
+    est->nosRecalculados = g->nosRecalculados;
+}
@@ -0,0 +1,48 @@
+#ifndef GRAFO_H
+#define GRAFO_H
+#include <stddef.h>
+
+/*
+ * Grafo de fórmulas no estilo planilha: cada célula tem um nome e é uma
+ * entrada (valor dado) ou uma fórmula (expressão infixa ou pós-fixa que lê
+ * outras células pelo nome). Cada fórmula é compilada (compilarExpressao) e
+ * guardada como árvore de nós com os valores da última avaliação. Mudar uma
+ * entrada marca só os nós que dependem dela; o recálculo refaz esses nós,
+ * fórmula por fórmula em ordem topológica, e só segue adiante quando o
+ * valor de uma fórmula de fato muda. Várias entradas podem mudar antes de
+ * um único recálculo. Os valores são os de avaliarPrograma. Não é seguro
+ * usar o mesmo grafo em várias threads ao mesmo tempo.
+ */
+typedef struct GrafoFormulas GrafoFormulas;
+
+typedef struct {
+    int celulas;                         // entradas + fórmulas
+    int formulas;
+    size_t nos;                          // nós de todas as fórmulas (custo de recalcular tudo)
+    unsigned long long recalculos;       // fórmulas recalculadas desde a criação
+    unsigned long long nosRecalculados;
+} EstatisticasGrafo;
+
+GrafoFormulas *criarGrafo(void);
+void destruirGrafo(GrafoFormulas *g);
+
+/*
+ * Define (ou redefine) a fórmula da célula nome. Nomes ainda desconhecidos
+ * viram entradas com valor 0. Retorna 0, ou -1 se a expressão for inválida,
+ * se criar um ciclo ou se faltar memória (a definição anterior continua).
+ */
+int definirFormula(GrafoFormulas *g, const char *nome, const char *expr);
+
+/* Muda o valor da entrada nome (criando-a se preciso); o recálculo fica pendente.
+   Retorna 0, ou -1 se nome for uma fórmula ou não for um identificador. */
+int definirEntrada(GrafoFormulas *g, const char *nome, float valor);
+int definirEntradas(GrafoFormulas *g, const char *const *nomes, const float *valores, int n);
+
+/* Recalcula o que ficou pendente e retorna quantas fórmulas foram recalculadas (não aloca memória) */
+int recalcularGrafo(GrafoFormulas *g);
+
+/* Valor atual da célula, recalculando antes o que estiver pendente. Retorna 0 ou -1 (não existe). */
+int valorCelula(GrafoFormulas *g, const char *nome, float *valor);
+
+void estatisticasGrafo(const GrafoFormulas *g, EstatisticasGrafo *est);
+#endif
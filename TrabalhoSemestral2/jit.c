@@ -0,0 +1,221 @@
+/* jit.c - geração de código x86-64 para programas compilados */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "expressao.h"
+#include "programa.h"
+#include "funcoes.h"
+#include "matematica.h"
+#include "jit.h"
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#define JIT_DISPONIVEL 1
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#ifdef JIT_DISPONIVEL
+
+/* maior sequência gerada por uma instrução do programa (OP_DIV) */
+#define MAX_POR_INSTRUCAO 64
+#define TAM_MOLDURA 32 // prólogo + epílogo
+/* pilha + temporários ficam na pilha nativa, num só "sub rsp" sem sondagem: até uma página,
+   para a primeira escrita não pular a página de guarda; acima disso fica o interpretador */
+#define MAX_MOLDURA 4096
+
+typedef struct {
+    unsigned char *p;
+} Emissor;
+
+static void byte1(Emissor *e, unsigned b) { *e->p++ = (unsigned char)b; }
+
+static void bytes(Emissor *e, const char *b, int n) {
+    memcpy(e->p, b, (size_t)n);
+    e->p += n;
+}
+
+static void imm32(Emissor *e, uint32_t v) {
+    memcpy(e->p, &v, 4);
+    e->p += 4;
+}
+
+static void imm64(Emissor *e, uint64_t v) {
+    memcpy(e->p, &v, 8);
+    e->p += 8;
+}
+
+/*
+ * Operações SSE sobre a pilha, que fica na pilha nativa: a posição i
+ * está em [rsp + 4*i]. modrm escolhe o registrador (0x84 = xmm0, 0x8C = xmm1).
+ */
+static void sseRsp(Emissor *e, unsigned opcode, unsigned modrm, int pos) {
+    byte1(e, 0xF3); byte1(e, 0x0F); byte1(e, opcode);
+    byte1(e, modrm); byte1(e, 0x24);
+    imm32(e, (uint32_t)(pos * 4));
+}
+
+#define CARREGAR_XMM0(e, pos) sseRsp((e), 0x10, 0x84, (pos)) // movss xmm0, [rsp+d]
+#define CARREGAR_XMM1(e, pos) sseRsp((e), 0x10, 0x8C, (pos)) // movss xmm1, [rsp+d]
+#define GUARDAR_XMM0(e, pos)  sseRsp((e), 0x11, 0x84, (pos)) // movss [rsp+d], xmm0
+
+/* mov rax, alvo; call rax (rsp está alinhado a 16 no corpo) */
+static void chamar(Emissor *e, uintptr_t alvo) {
+    byte1(e, 0x48); byte1(e, 0xB8);
+    imm64(e, (uint64_t)alvo);
+    byte1(e, 0xFF); byte1(e, 0xD0);
+}
+
+/* mov edi, v */
+static void argumentoInteiro(Emissor *e, int v) {
+    byte1(e, 0xBF);
+    imm32(e, (uint32_t)v);
+}
+
+/* gera o corpo; retorna o número de bytes escritos */
+static size_t gerarJit(const Programa *prog, unsigned char *codigo) {
+    Emissor e;
+    int moldura = ((prog->profundidadeMax + prog->nTemporarios) * 4 + 15) & ~15;
+    int temp = prog->profundidadeMax; // temporários vêm depois da pilha
+    int topo = -1, i;
+    e.p = codigo;
+
+    bytes(&e, "\x53", 1);              // push rbx (alinha rsp a 16)
+    bytes(&e, "\x48\x89\xFB", 3);      // mov rbx, rdi (valores)
+    bytes(&e, "\x48\x81\xEC", 3);      // sub rsp, moldura
+    imm32(&e, (uint32_t)moldura);
+
+    for (i = 0; i < prog->tamanho; ++i) {
+        const Instrucao *ins = &prog->codigo[i];
+        switch (ins->op) {
+            case OP_CONST: {
+                uint32_t bits;
+                memcpy(&bits, &ins->arg.valor, 4);
+                ++topo;
+                bytes(&e, "\xC7\x84\x24", 3); // mov dword [rsp+d], bits
+                imm32(&e, (uint32_t)(topo * 4));
+                imm32(&e, bits);
+            } break;
+            case OP_VAR:
+                ++topo;
+                bytes(&e, "\xF3\x0F\x10\x83", 4); // movss xmm0, [rbx+d]
+                imm32(&e, (uint32_t)(ins->arg.indice * 4));
+                GUARDAR_XMM0(&e, topo);
+                break;
+            case OP_SOMA:
+            case OP_SUB:
+            case OP_MUL: {
+                static const unsigned char opcodes[] = { 0x58, 0x5C, 0x59 }; // addss, subss, mulss
+                --topo;
+                CARREGAR_XMM0(&e, topo);
+                sseRsp(&e, opcodes[ins->op - OP_SOMA], 0x84, topo + 1);
+                GUARDAR_XMM0(&e, topo);
+            } break;
+            case OP_DIV:
+                /* (b != 0) ? a / b : 0, com b NaN caindo na divisão */
+                --topo;
+                CARREGAR_XMM0(&e, topo);
+                CARREGAR_XMM1(&e, topo + 1);
+                bytes(&e, "\x0F\x57\xD2", 3); // xorps xmm2, xmm2
+                bytes(&e, "\x0F\x2E\xCA", 3); // ucomiss xmm1, xmm2
+                bytes(&e, "\x7A\x07", 2);     // jp dividir
+                bytes(&e, "\x75\x05", 2);     // jne dividir
+                bytes(&e, "\x0F\x57\xC0", 3); // xorps xmm0, xmm0
+                bytes(&e, "\xEB\x04", 2);     // jmp fim
+                bytes(&e, "\xF3\x0F\x5E\xC1", 4); // dividir: divss xmm0, xmm1
+                GUARDAR_XMM0(&e, topo);       // fim:
+                break;
+            case OP_MOD:
+            case OP_POT:
+                --topo;
+                argumentoInteiro(&e, operadorDoCodigo(ins->op));
+                CARREGAR_XMM0(&e, topo);
+                CARREGAR_XMM1(&e, topo + 1);
+                chamar(&e, (uintptr_t)aplicarOperadorBinario);
+                GUARDAR_XMM0(&e, topo);
+                break;
+            case OP_FUNC: {
+                /* chama a função registrada direto, sem passar pelo id */
+                const DescritorFuncao *d = descritorFuncao(ins->funcao);
+                if (d->aridade == 2) {
+                    --topo;
+                    CARREGAR_XMM0(&e, topo);
+                    CARREGAR_XMM1(&e, topo + 1);
+                    chamar(&e, (uintptr_t)d->binaria);
+                } else {
+                    CARREGAR_XMM0(&e, topo);
+                    chamar(&e, (uintptr_t)funcaoPrecisao(ins->funcao, prog->precisao));
+                }
+                GUARDAR_XMM0(&e, topo);
+            } break;
+            case OP_GUARDAR:
+                CARREGAR_XMM0(&e, topo);
+                GUARDAR_XMM0(&e, temp + ins->arg.indice);
+                break;
+            case OP_CARREGAR:
+                ++topo;
+                CARREGAR_XMM0(&e, temp + ins->arg.indice);
+                GUARDAR_XMM0(&e, topo);
+                break;
+        }
+    }
+
+    CARREGAR_XMM0(&e, 0);              // resultado
+    bytes(&e, "\x48\x81\xC4", 3);      // add rsp, moldura
+    imm32(&e, (uint32_t)moldura);
+    bytes(&e, "\x5B\xC3", 2);          // pop rbx; ret
+    return (size_t)(e.p - codigo);
+}
+
+ProgramaJit *compilarJit(const Programa *prog) {
+    ProgramaJit *jit;
+    size_t pagina, tam;
+    void *mem;
+    if (!prog || prog->tamanho == 0) return NULL;
+    if ((size_t)(prog->profundidadeMax + prog->nTemporarios) * 4 > MAX_MOLDURA) return NULL;
+
+    pagina = (size_t)sysconf(_SC_PAGESIZE);
+    tam = (size_t)prog->tamanho * MAX_POR_INSTRUCAO + TAM_MOLDURA;
+    tam = (tam + pagina - 1) / pagina * pagina;
+    mem = mmap(NULL, tam, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return NULL;
+
+    gerarJit(prog, (unsigned char*)mem);
+    /* nunca gravável e executável ao mesmo tempo */
+    if (mprotect(mem, tam, PROT_READ | PROT_EXEC) != 0) {
+        munmap(mem, tam);
+        return NULL;
+    }
+
+    jit = (ProgramaJit*)malloc(sizeof(ProgramaJit));
+    if (!jit) { munmap(mem, tam); return NULL; }
+    memcpy(&jit->funcao, &mem, sizeof(mem)); // ponteiro de dados -> função (POSIX)
+    jit->memoria = mem;
+    jit->tamanho = tam;
+    return jit;
+}
+
+void liberarJit(ProgramaJit *jit) {
+    if (!jit) return;
+    munmap(jit->memoria, jit->tamanho);
+    free(jit);
+}
+
+#else
+
+ProgramaJit *compilarJit(const Programa *prog) {
+    (void)prog;
+    return NULL;
+}
+
+void liberarJit(ProgramaJit *jit) {
+    free(jit);
+}
+
+#endif
+
+float avaliarJit(const ProgramaJit *jit, const Programa *prog, const float *valores) {
+    if (jit) return jit->funcao(valores);
+    return avaliarPrograma(prog, valores);
+}
@@ -0,0 +1,29 @@
+#ifndef JIT_H
+#define JIT_H
+#include <stddef.h>
+#include "programa.h"
+
+/* Função nativa gerada para um programa: valores tem prog->nVariaveis posições */
+typedef float (*FuncaoJit)(const float *valores);
+
+typedef struct {
+    FuncaoJit funcao;
+    void *memoria;  // páginas executáveis (mmap)
+    size_t tamanho;
+} ProgramaJit;
+
+/*
+ * Traduz prog para código x86-64 (SSE escalar) numa página executável.
+ * +, -, * e / viram instruções; % e ^ chamam aplicarOperadorBinario e as
+ * funções são chamadas pelo ponteiro do registro (ou o núcleo da precisão do
+ * programa, matematica.h), então o resultado é idêntico
+ * ao de avaliarPrograma. Retorna NULL se a plataforma não for x86-64
+ * (System V), se a pilha do programa não couber em 4 KiB (uma página)
+ * da pilha nativa ou se a memória não puder ser obtida.
+ */
+ProgramaJit *compilarJit(const Programa *prog);
+void liberarJit(ProgramaJit *jit);
+
+/* jit->funcao(valores) se houver código nativo, senão avaliarPrograma */
+float avaliarJit(const ProgramaJit *jit, const Programa *prog, const float *valores);
+#endif
@@ -0,0 +1,236 @@
+/* lote.c - avaliação de um programa sobre muitas linhas (colunas de entrada) */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "expressao.h"
+#include "programa.h"
+#include "lote.h"
+#include "funcoes.h"
+#include "matematica.h"
+#include "vetor.h"
+
+/* linhas processadas por vez: cada nível da pilha guarda um bloco */
+#define BLOCO 256
+
+/* ---- operações sobre um vetor de LARGURA floats (vetor.h) ---- */
+
+#if defined(__AVX512F__)
+/* (b != 0) ? a / b : 0 */
+static VetorF vDivSegura(VetorF a, VetorF b) {
+    __mmask16 m = _mm512_cmp_ps_mask(b, _mm512_setzero_ps(), _CMP_NEQ_UQ);
+    return _mm512_maskz_div_ps(m, a, b);
+}
+
+/* (x <= 0) ? 0 : sqrt(x) */
+static VetorF vRaiz(VetorF x) {
+    __mmask16 m = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_NLE_UQ);
+    return _mm512_maskz_sqrt_ps(m, x);
+}
+
+/* quadrados sucessivos de aplicarOperadorBinario('^'), na mesma ordem, por linha;
+   bit k de *escalar = linha com expoente fracionário ou |b| >= 2^31 (fica com o escalar) */
+static VetorF vPotencia(VetorF a, VetorF b, int *escalar) {
+    __mmask16 inteiro = _mm512_cmp_ps_mask(b, _mm512_roundscale_ps(b, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), _CMP_EQ_OQ) &
+                        _mm512_cmp_ps_mask(_mm512_abs_ps(b), _mm512_set1_ps(2147483648.0f), _CMP_LT_OQ);
+    __m512i n = _mm512_maskz_abs_epi32(inteiro, _mm512_cvttps_epi32(b));
+    int maxN = _mm512_reduce_max_epi32(n);
+    VetorF acc = _mm512_set1_ps(1.0f), base = a;
+    int k;
+    __mmask16 neg, naoZero;
+    for (k = 0; maxN >> k; ++k) {
+        __mmask16 m = _mm512_test_epi32_mask(n, _mm512_set1_epi32(1 << k));
+        acc = _mm512_mask_mul_ps(acc, m, acc, base);
+        base = _mm512_mul_ps(base, base);
+    }
+    neg = inteiro & _mm512_cmp_ps_mask(b, _mm512_setzero_ps(), _CMP_LT_OQ);
+    naoZero = _mm512_cmp_ps_mask(acc, _mm512_setzero_ps(), _CMP_NEQ_UQ);
+    *escalar = (int)(unsigned short)~inteiro;
+    return _mm512_mask_blend_ps(neg, acc, _mm512_maskz_div_ps(naoZero, _mm512_set1_ps(1.0f), acc));
+}
+#elif defined(__AVX2__)
+static VetorF vDivSegura(VetorF a, VetorF b) {
+    __m256 m = _mm256_cmp_ps(b, _mm256_setzero_ps(), _CMP_NEQ_UQ);
+    return _mm256_and_ps(_mm256_div_ps(a, b), m);
+}
+
+static VetorF vRaiz(VetorF x) {
+    __m256 m = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_NLE_UQ);
+    return _mm256_and_ps(_mm256_sqrt_ps(x), m);
+}
+
+static VetorF vPotencia(VetorF a, VetorF b, int *escalar) {
+    __m256 bt = _mm256_round_ps(b, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m256 absB = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), b);
+    __m256 inteiro = _mm256_and_ps(_mm256_cmp_ps(b, bt, _CMP_EQ_OQ),
+                                   _mm256_cmp_ps(absB, _mm256_set1_ps(2147483648.0f), _CMP_LT_OQ));
+    __m256i n = _mm256_and_si256(_mm256_abs_epi32(_mm256_cvttps_epi32(b)), _mm256_castps_si256(inteiro));
+    __m128i m4 = _mm_max_epi32(_mm256_castsi256_si128(n), _mm256_extracti128_si256(n, 1));
+    int maxN, k;
+    VetorF acc = _mm256_set1_ps(1.0f), base = a;
+    __m256 neg, inv;
+    m4 = _mm_max_epi32(m4, _mm_shuffle_epi32(m4, _MM_SHUFFLE(1, 0, 3, 2)));
+    m4 = _mm_max_epi32(m4, _mm_shuffle_epi32(m4, _MM_SHUFFLE(2, 3, 0, 1)));
+    maxN = _mm_cvtsi128_si32(m4);
+    for (k = 0; maxN >> k; ++k) {
+        __m256i bit = _mm256_set1_epi32(1 << k);
+        __m256 m = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(n, bit), bit));
+        acc = _mm256_blendv_ps(acc, _mm256_mul_ps(acc, base), m);
+        base = _mm256_mul_ps(base, base);
+    }
+    neg = _mm256_and_ps(_mm256_cmp_ps(b, _mm256_setzero_ps(), _CMP_LT_OQ), inteiro);
+    inv = vDivSegura(_mm256_set1_ps(1.0f), acc);
+    *escalar = ~_mm256_movemask_ps(inteiro) & 0xFF;
+    return _mm256_blendv_ps(acc, inv, neg);
+}
+#endif
+
+/* ---- núcleos sobre m linhas (r pode coincidir com a) ---- */
+
+#if LARGURA > 1
+#define LACO_VETORIAL(expr_vetor) \
+    for (; i + LARGURA <= m; i += LARGURA) { expr_vetor; }
+#else
+#define LACO_VETORIAL(expr_vetor)
+#endif
+
+#if LARGURA > 1
+/* r[0..LARGURA) = a ^ b; as linhas que vPotencia deixa para o escalar são refeitas (r pode ser a) */
+static void potenciaVetor(float *r, const float *a, const float *b) {
+    VetorF va = V_CARREGAR(a), vb = V_CARREGAR(b);
+    int escalar, k;
+    VetorF vr = vPotencia(va, vb, &escalar);
+    if (escalar) {
+        float xa[LARGURA], xb[LARGURA], xr[LARGURA];
+        V_GUARDAR(xa, va);
+        V_GUARDAR(xb, vb);
+        V_GUARDAR(xr, vr);
+        for (k = 0; k < LARGURA; ++k) {
+            if (escalar & (1 << k)) xr[k] = aplicarOperadorBinario('^', xa[k], xb[k]);
+        }
+        vr = V_CARREGAR(xr);
+    }
+    V_GUARDAR(r, vr);
+}
+#endif
+
+static void nucleoBinario(int op, float *r, const float *a, const float *b, int m) {
+    int i = 0;
+    switch (op) {
+        case OP_SOMA:
+            LACO_VETORIAL(V_GUARDAR(r + i, V_SOMA(V_CARREGAR(a + i), V_CARREGAR(b + i))))
+            for (; i < m; ++i) r[i] = a[i] + b[i];
+            break;
+        case OP_SUB:
+            LACO_VETORIAL(V_GUARDAR(r + i, V_SUB(V_CARREGAR(a + i), V_CARREGAR(b + i))))
+            for (; i < m; ++i) r[i] = a[i] - b[i];
+            break;
+        case OP_MUL:
+            LACO_VETORIAL(V_GUARDAR(r + i, V_MUL(V_CARREGAR(a + i), V_CARREGAR(b + i))))
+            for (; i < m; ++i) r[i] = a[i] * b[i];
+            break;
+        case OP_DIV:
+            LACO_VETORIAL(V_GUARDAR(r + i, vDivSegura(V_CARREGAR(a + i), V_CARREGAR(b + i))))
+            for (; i < m; ++i) r[i] = (b[i] != 0.0f) ? a[i] / b[i] : 0.0f;
+            break;
+        case OP_POT:
+            LACO_VETORIAL(potenciaVetor(r + i, a + i, b + i))
+            for (; i < m; ++i) r[i] = aplicarOperadorBinario('^', a[i], b[i]);
+            break;
+        default:
+            for (; i < m; ++i) r[i] = aplicarOperadorBinario(operadorDoCodigo(op), a[i], b[i]);
+            break;
+    }
+}
+
+static void nucleoFuncao(int id, Precisao p, float *r, const float *x, int m) {
+    const DescritorFuncao *d = descritorFuncao(id);
+    FuncaoLote lote = nucleoPrecisao(id, p);
+    int i = 0;
+    if (lote) {
+        lote(r, x, NULL, m);
+        return;
+    }
+    switch (id) {
+        case FUNC_RAIZ:
+        case FUNC_SQRT:
+            LACO_VETORIAL(V_GUARDAR(r + i, vRaiz(V_CARREGAR(x + i))))
+            for (; i < m; ++i) r[i] = raizAprox(x[i]);
+            break;
+        default: for (; i < m; ++i) r[i] = d->unaria(x[i]); break;
+    }
+}
+
+static void nucleoFuncao2(int id, float *r, const float *a, const float *b, int m) {
+    const DescritorFuncao *d = descritorFuncao(id);
+    int i;
+    if (d->lote) {
+        d->lote(r, a, b, m);
+        return;
+    }
+    for (i = 0; i < m; ++i) r[i] = d->binaria(a[i], b[i]);
+}
+
+int avaliarProgramaLote(const Programa *prog, const float *const *colunas, size_t n, float *saida) {
+    const float **ent;   /* dados de cada nível da pilha: coluna de entrada, buf ou temporário */
+    float *buf;          /* um bloco de BLOCO floats por nível, seguido de um por temporário */
+    float *temp;
+    size_t base;
+    int prof;
+    if (!prog || !saida || prog->tamanho == 0) return -1;
+    if (prog->nVariaveis > 0 && !colunas) return -1;
+    if (n == 0) return 0;
+
+    prof = prog->profundidadeMax;
+    ent = (const float**)malloc(sizeof(float*) * (size_t)prof);
+    buf = (float*)malloc(sizeof(float) * BLOCO * (size_t)(prof + prog->nTemporarios));
+    if (!ent || !buf) { free(ent); free(buf); return -1; }
+    temp = buf + (size_t)prof * BLOCO;
+
+    for (base = 0; base < n; base += BLOCO) {
+        int m = (n - base < BLOCO) ? (int)(n - base) : BLOCO;
+        int topo = -1;
+        int pc, i;
+        for (pc = 0; pc < prog->tamanho; ++pc) {
+            const Instrucao *ins = &prog->codigo[pc];
+            switch (ins->op) {
+                case OP_CONST: {
+                    float *dest = buf + (size_t)(++topo) * BLOCO;
+                    for (i = 0; i < m; ++i) dest[i] = ins->arg.valor;
+                    ent[topo] = dest;
+                } break;
+                case OP_VAR:
+                    ent[++topo] = colunas[ins->arg.indice] + base;
+                    break;
+                case OP_FUNC:
+                    if (aridadeFuncao(ins->funcao) == 2) {
+                        float *dest = buf + (size_t)(topo - 1) * BLOCO;
+                        nucleoFuncao2(ins->funcao, dest, ent[topo-1], ent[topo], m);
+                        ent[--topo] = dest;
+                    } else {
+                        float *dest = buf + (size_t)topo * BLOCO;
+                        nucleoFuncao(ins->funcao, prog->precisao, dest, ent[topo], m);
+                        ent[topo] = dest;
+                    }
+                    break;
+                case OP_GUARDAR:
+                    memcpy(temp + (size_t)ins->arg.indice * BLOCO, ent[topo], sizeof(float) * (size_t)m);
+                    break;
+                case OP_CARREGAR:
+                    ent[++topo] = temp + (size_t)ins->arg.indice * BLOCO;
+                    break;
+                default: {
+                    float *dest = buf + (size_t)(topo - 1) * BLOCO;
+                    nucleoBinario(ins->op, dest, ent[topo-1], ent[topo], m);
+                    ent[--topo] = dest;
+                } break;
+            }
+        }
+        memcpy(saida + base, ent[0], sizeof(float) * (size_t)m);
+    }
+
+    free(ent);
+    free(buf);
+    return 0;
+}
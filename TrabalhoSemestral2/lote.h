@@ -0,0 +1,17 @@
+#ifndef LOTE_H
+#define LOTE_H
+#include <stddef.h>
+#include "programa.h"
+
+/*
+ * Avalia prog sobre n linhas de entrada em formato de colunas:
+ * colunas[v][i] é o valor da variável v na linha i e saida[i] recebe o
+ * resultado da linha i. Os operadores e raiz/sqrt usam vetores AVX-512
+ * (16 floats) ou AVX2 (8 floats) quando o compilador os habilita
+ * (-mavx512f / -mavx2 / -march=native), e laços escalares caso contrário;
+ * as demais funções embutidas também, se prog->precisao não for PRECISAO_LIBM.
+ * O resultado é idêntico ao de avaliarPrograma linha a linha.
+ * Retorna 0, ou -1 em erro de parâmetro ou memória.
+ */
+int avaliarProgramaLote(const Programa *prog, const float *const *colunas, size_t n, float *saida);
+#endif
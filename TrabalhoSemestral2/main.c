@@ -1,7 +1,30 @@
+/* compilar: gcc *.c -o expressao -lm -lpthread  (acrescente -O2 -mavx2 ou -march=native para o modo em lote e os núcleos de matematica.c vetorizados, -DESTATISTICAS para os contadores) */
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 #include "expressao.h"
+#include "programa.h"
+#include "lote.h"
+#include "paralelo.h"
+#include "fluxo.h"
+#include "cache.h"
+#include "jit.h"
+#include "benchmark.h"
+#include "estatisticas.h"
+#include "funcoes.h"
+#include "matematica.h"
+#include "grafo.h"
+#include "serializacao.h"
+#include "servidor.h"
+#include "carga.h"
+#include "armazem.h"
+#include "formatacao.h"
+#include "geracao.h"
 
 // Protótipo real da função implementada no expressao.c
 int processarExpressao(const char *entrada, char **saida, float *valor, int *ehPos);
@@ -10,6 +33,7 @@ void testar(const char *expr) {
     char *saida = NULL;   // agora recebe malloc do processarExpressao
     float valor = 0.0f;
     int ehPos = 0;
+    char num[TAM_TEXTO_FLOAT];
 
     printf("\n===============================\n");
     printf("Expressao de entrada: %s\n", expr);
@@ -24,7 +48,7 @@ void testar(const char *expr) {
             printf("Convertida para POS-FIXA: %s\n", saida);
         }
 
-        printf("Valor calculado: %.6f\n", valor);
+        printf("Valor calculado: %.*s\n", formatarFloat(num, valor, 6), num);
     } else {
         printf("ERRO ao processar expressao!\n");
     }
@@ -32,7 +56,472 @@ void testar(const char *expr) {
     if (saida) free(saida);  // libera o malloc feito dentro do expressao.c
 }
 
-int main() {
+static float maximo(float a, float b) { return a > b ? a : b; }
+static float dobro(float x) { return 2.0f * x; }
+
+void testarPrograma(const char *expr, const char *const *nomes, int nVars, const float *valores) {
+    Programa *prog = compilarExpressao(expr, nomes, nVars);
+    ProgramaJit *jit;
+    int i;
+
+    printf("\n===============================\n");
+    printf("Expressao compilada: %s\n", expr);
+    if (!prog) {
+        printf("ERRO ao compilar expressao!\n");
+        return;
+    }
+    for (i = 0; i < prog->nVariaveis; ++i) {
+        printf("  %s = %.6f\n", prog->variaveis[i], valores[i]);
+    }
+    printf("Valor calculado: %.6f\n", avaliarPrograma(prog, valores));
+    jit = compilarJit(prog);
+    printf("Valor pelo JIT: %.6f%s\n", avaliarJit(jit, prog, valores), jit ? "" : " (JIT indisponivel, interpretado)");
+    liberarJit(jit);
+    liberarPrograma(prog);
+}
+
+void testarLote(const char *expr) {
+    const char *nomes[] = { "x", "y" };
+    float x[10], y[10], res[10];
+    Programa *prog = compilarExpressao(expr, nomes, 2);
+    const float *colunas[2];
+    int i;
+
+    printf("\n===============================\n");
+    printf("Expressao em lote: %s\n", expr);
+    for (i = 0; i < 10; ++i) { x[i] = (float)i; y[i] = (float)(10 - i); }
+    colunas[0] = x;
+    colunas[1] = y;
+    if (!prog || avaliarProgramaLote(prog, colunas, 10, res) != 0) {
+        printf("ERRO ao avaliar em lote!\n");
+        liberarPrograma(prog);
+        return;
+    }
+    for (i = 0; i < 10; ++i) {
+        printf("  x=%.0f y=%.0f -> %.6f\n", x[i], y[i], res[i]);
+    }
+    liberarPrograma(prog);
+}
+
+void testarPrecisao(const char *expr) {
+    static const char *nomesPrecisao[] = { "libm", "ulp", "rapida" };
+    const char *nomes[] = { "x" };
+    float x[4] = { 30.0f, 90.0f, 180.0f, 1000.0f }, res[4];
+    const float *colunas[1];
+    int p, i;
+
+    printf("\n===============================\n");
+    printf("Precisao das funcoes: %s\n", expr);
+    colunas[0] = x;
+    for (p = 0; p < PRECISAO_QUANTIDADE; ++p) {
+        Programa *prog = compilarExpressaoPrecisao(expr, nomes, 1, (Precisao)p);
+        if (!prog || avaliarProgramaLote(prog, colunas, 4, res) != 0) {
+            printf("  %-7s ERRO\n", nomesPrecisao[p]);
+        } else {
+            printf("  %-7s", nomesPrecisao[p]);
+            for (i = 0; i < 4; ++i) printf(" %.9g", res[i]);
+            printf("\n");
+        }
+        liberarPrograma(prog);
+    }
+}
+
+void testarTipos(const char *expr) {
+    static const char *nomesTipo[] = { "float", "double", "inteiro", "auto" };
+    int t;
+
+    printf("\n===============================\n");
+    printf("Calculo por tipo: %s\n", expr);
+    for (t = TIPO_FLOAT; t <= TIPO_AUTOMATICO; ++t) {
+        ValorNumerico v;
+        printf("  %-8s", nomesTipo[t]);
+        if (calcularExpressaoTipada(expr, (TipoNumerico)t, &v) != 0) {
+            printf(" ERRO\n");
+        } else if (v.tipo == TIPO_INTEIRO) {
+            printf(" %lld (inteiro)\n", v.v.i);
+        } else {
+            printf(" %.17g (%s)\n", v.tipo == TIPO_FLOAT ? (double)v.v.f : v.v.d, nomesTipo[v.tipo]);
+        }
+    }
+}
+
+void testarGrafo(void) {
+    static const char *celulas[] = { "subtotal", "imposto", "frete", "total" };
+    GrafoFormulas *g = criarGrafo();
+    EstatisticasGrafo est;
+    unsigned long long nos = 0;
+    int i, rodada;
+
+    printf("\n===============================\n");
+    printf("Grafo de formulas com recalculo incremental\n");
+    definirFormula(g, "subtotal", "preco * qtd");
+    definirFormula(g, "imposto", "subtotal * 0.1");
+    definirFormula(g, "frete", "raiz(qtd) * 2 + distancia / 10");
+    definirFormula(g, "total", "subtotal + imposto + frete");
+    for (rodada = 0; rodada < 3; ++rodada) {
+        if (rodada == 0) {
+            const char *nomes[] = { "preco", "qtd", "distancia" };
+            const float valores[] = { 12.5f, 4.0f, 30.0f };
+            definirEntradas(g, nomes, valores, 3);
+            printf("  preco=12.5 qtd=4 distancia=30:");
+        } else if (rodada == 1) {
+            definirEntrada(g, "distancia", 50.0f);
+            printf("  distancia=50:");
+        } else {
+            definirEntrada(g, "preco", 20.0f);
+            printf("  preco=20:");
+        }
+        printf(" %d formulas recalculadas", recalcularGrafo(g));
+        estatisticasGrafo(g, &est);
+        printf(", %llu de %d nos\n   ", est.nosRecalculados - nos, (int)est.nos);
+        nos = est.nosRecalculados;
+        for (i = 0; i < 4; ++i) {
+            float v;
+            valorCelula(g, celulas[i], &v);
+            printf(" %s=%.2f", celulas[i], v);
+        }
+        printf("\n");
+    }
+    printf("  ciclo rejeitado: %s\n", definirFormula(g, "preco", "total / qtd") != 0 ? "sim" : "nao");
+    destruirGrafo(g);
+}
+
+/* cria um arquivo vazio e exclusivo em $TMPDIR (ou /tmp) e grava o caminho; 0, ou -1 */
+static int criarArquivoTemporario(char *caminho, size_t tam) {
+#ifndef _WIN32
+    const char *dir = getenv("TMPDIR");
+    int fd;
+    if (!dir || !*dir) dir = "/tmp";
+    if ((size_t)snprintf(caminho, tam, "%s/programasXXXXXX", dir) >= tam) return -1;
+    if ((fd = mkstemp(caminho)) < 0) return -1;
+    close(fd);
+    return 0;
+#else
+    return (tmpnam_s(caminho, tam) == 0) ? 0 : -1;
+#endif
+}
+
+void testarArquivoProgramas(void) {
+    const char *exprs[] = { "x * (y + 2)", "sen(x * 15) ^ 2 + cos(y * 15) ^ 2", "dobro(max(x, y - 2)) + max(x, 1)" };
+    const char *nomes[] = { "x", "y" };
+    const float valores[] = { 3.0f, 4.0f };
+    char caminho[4096];
+    Programa *progs[3];
+    ArquivoProgramas *arq;
+    int i;
+
+    printf("\n===============================\n");
+    printf("Programas gravados em binario e mapeados de volta\n");
+    if (criarArquivoTemporario(caminho, sizeof(caminho)) != 0) {
+        printf("  ERRO: arquivo temporario\n");
+        return;
+    }
+    for (i = 0; i < 3; ++i) progs[i] = compilarExpressao(exprs[i], nomes, 2);
+    if (salvarProgramas(caminho, (const Programa *const *)progs, 3) != 0 || !(arq = abrirArquivoProgramas(caminho))) {
+        printf("  ERRO\n");
+    } else {
+        for (i = 0; i < quantidadeProgramasArquivo(arq); ++i) {
+            Programa visao;
+            if (programaDoArquivo(arq, i, &visao) == 0) {
+                printf("  %-36s = %.6f (original %.6f)\n", exprs[i], avaliarPrograma(&visao, valores),
+                       avaliarPrograma(progs[i], valores));
+            }
+        }
+        fecharArquivoProgramas(arq);
+    }
+    for (i = 0; i < 3; ++i) liberarPrograma(progs[i]);
+    remove(caminho);
+}
+
+void testarArmazem(void) {
+    /* planilha: as mesmas quatro fórmulas em cada linha, com as variáveis da linha */
+    const char *modelos[] = {
+        "(preco * (1 + imposto) - desconto) * qtd%d",
+        "raiz(x%d ^ 2 + y%d ^ 2)",
+        "(preco * (1 + imposto) - desconto) * qtd%d + frete / raiz(x%d ^ 2 + y%d ^ 2)",
+        "max(qtd%d - estoque, 0) * (preco * (1 + imposto) - desconto)"
+    };
+    ArmazemExpressoes *arm = criarArmazem();
+    EstatisticasArmazem est;
+    char expr[160];
+    float *valores;
+    int i, n = 100000;
+
+    printf("\n===============================\n");
+    printf("Armazem com nos compartilhados (%d formulas)\n", n);
+    for (i = 0; i < n && arm; ++i) {
+        snprintf(expr, sizeof(expr), modelos[i % 4], i / 4, i / 4, i / 4);
+        if (adicionarFormulaArmazem(arm, expr) < 0) { printf("  ERRO em %s\n", expr); break; }
+    }
+    if (!arm) return;
+    estatisticasArmazem(arm, &est);
+    printf("  nos distintos=%lu (de %lu sem compartilhar, %.1fx) variaveis=%d\n",
+           (unsigned long)est.nos, (unsigned long)est.nosLogicos, est.deduplicacao, est.variaveis);
+    printf("  %.1f bytes por formula (Expressao: %d bytes, %.0fx menor)\n", est.bytesPorFormula,
+           (int)sizeof(Expressao), est.bytesPorFormula > 0 ? sizeof(Expressao) / est.bytesPorFormula : 0.0);
+    valores = (float*)calloc((size_t)est.variaveis, sizeof(float));
+    if (valores) {
+        char *texto = textoFormulaArmazem(arm, 2);
+        for (i = 0; i < est.variaveis; ++i) valores[i] = 1.0f + (float)(i % 7);
+        printf("  %s = %.6f\n", texto ? texto : "ERRO", avaliarFormulaArmazem(arm, 2, valores));
+        free(texto);
+    }
+    free(valores);
+    destruirArmazem(arm);
+}
+
+void testarGeracaoC(void) {
+    const char *nomes[] = { "x", "y" };
+    const char *exprs[] = { "x * (y + 2) - sen(x) / (y ^ 2 + 1) + (y + 2) ^ 2", "sen(30) * 2 + log(100)" };
+    const char *funcoes[] = { "formulaVariaveis", "formulaConstante" };
+    int i;
+
+    printf("\n===============================\n");
+    printf("Codigo C gerado para formulas fixas\n");
+    for (i = 0; i < 2; ++i) {
+        Programa *prog = compilarExpressao(exprs[i], nomes, 2);
+        printf("/* %s */\n", exprs[i]);
+        if (!prog || gerarFuncaoC(prog, funcoes[i], stdout) != 0) printf("ERRO ao gerar codigo!\n");
+        liberarPrograma(prog);
+    }
+}
+
+void testarLoteExpressoes(void) {
+    const char *entradas[] = {
+        "3 4 + 5 *", "(3 + 4) * 5", "8 + (5 * (2 + 4))",
+        "2 3 + log 5 /", "(45 + 60) * cos(30)", "sen(45) ^ 2 + 0.5"
+    };
+    size_t n = sizeof(entradas) / sizeof(entradas[0]);
+    ResultadoExpressao resultados[sizeof(entradas) / sizeof(entradas[0])];
+    PoolTrabalho *pool = criarPoolTrabalho(0);
+    char num[TAM_TEXTO_FLOAT];
+    size_t i;
+
+    printf("\n===============================\n");
+    printf("Lote de %d expressoes em %d threads\n", (int)n, threadsDoPool(pool));
+    processarLoteExpressoes(pool, entradas, n, resultados);
+    for (i = 0; i < n; ++i) {
+        if (resultados[i].status == 0) {
+            printf("  %-22s -> %-22s = %.*s\n", entradas[i], resultados[i].saida,
+                   formatarFloat(num, resultados[i].valor, 6), num);
+        } else {
+            printf("  %-22s -> ERRO\n", entradas[i]);
+        }
+    }
+    liberarResultados(resultados, n);
+    destruirPoolTrabalho(pool);
+}
+
+/* árvore balanceada de 2^nivel folhas sen(x * k) + y, alternando + e - por nível */
+static size_t escreverArvore(char *p, int nivel, int *folha) {
+    size_t n;
+    if (nivel == 0) return (size_t)sprintf(p, "(sen(x * %d) + y)", ++*folha);
+    n = (size_t)sprintf(p, "(");
+    n += escreverArvore(p + n, nivel - 1, folha);
+    n += (size_t)sprintf(p + n, " %c ", (nivel & 1) ? '+' : '-');
+    n += escreverArvore(p + n, nivel - 1, folha);
+    n += (size_t)sprintf(p + n, ")");
+    return n;
+}
+
+void testarArvoreParalela(void) {
+    const char *nomes[] = { "x", "y" };
+    const float valores[] = { 0.5f, 2.0f };
+    int nivel = 15, folha = 0;
+    char *expr = (char*)malloc(((size_t)1 << nivel) * 40);
+    PoolTrabalho *pool = criarPoolTrabalho(0);
+    Programa *prog = NULL;
+    PlanoParalelo *plano = NULL;
+    long long t0, tSeq, tPar;
+    float seq, par;
+
+    printf("\n===============================\n");
+    if (!expr || !pool) goto fim;
+    escreverArvore(expr, nivel, &folha);
+    prog = compilarExpressao(expr, nomes, 2);
+    plano = prog ? planejarAvaliacaoParalela(prog, 0) : NULL;
+    if (!plano) goto fim;
+    printf("Arvore de %d instrucoes em %d tarefas (%d ondas), %d threads\n",
+           prog->tamanho, tarefasDoPlano(plano), ondasDoPlano(plano), threadsDoPool(pool));
+    t0 = relogioNs();
+    seq = avaliarPrograma(prog, valores);
+    tSeq = relogioNs() - t0;
+    t0 = relogioNs();
+    par = avaliarPlanoParalelo(pool, plano, valores);
+    tPar = relogioNs() - t0;
+    printf("  sequencial = %.6f (%.2f ms)\n", seq, tSeq / 1e6);
+    printf("  paralelo   = %.6f (%.2f ms) %s\n", par, tPar / 1e6,
+           memcmp(&seq, &par, sizeof(float)) == 0 ? "identico" : "DIFERENTE");
+fim:
+    liberarPlanoParalelo(plano);
+    liberarPrograma(prog);
+    destruirPoolTrabalho(pool);
+    free(expr);
+}
+
+void testarArena(void) {
+    const char *entradas[] = { "7 2 * 4 +", "(6 / 2 + 3) * 4", "10 log 3 ^ 2 +" };
+    char memoria[4096];
+    Arena arena;
+    int i;
+
+    printf("\n===============================\n");
+    printf("Processamento com arena (sem malloc)\n");
+    inicializarArena(&arena, memoria, sizeof(memoria));
+    for (i = 0; i < 3; ++i) {
+        const char *saida;
+        float valor;
+        int ehPos;
+        reiniciarArena(&arena);
+        if (processarExpressaoArena(entradas[i], strlen(entradas[i]), &arena, &saida, &valor, &ehPos) == 0) {
+            printf("  %-18s -> %-18s = %.6f (%d bytes da arena)\n", entradas[i], saida, valor, (int)arena.usado);
+        } else {
+            printf("  %-18s -> ERRO\n", entradas[i]);
+        }
+    }
+}
+
+/* só imprime algo quando compilado com -DESTATISTICAS */
+void mostrarEstatisticas(FILE *saida) {
+    EstatisticasExpressao est;
+    if (!estatisticasDisponiveis()) return;
+    capturarEstatisticas(&est, 0);
+    imprimirEstatisticas(saida, &est);
+}
+
+void testarCache(void) {
+    const char *entradas[] = {
+        "3 4 + 5 *", "(3 + 4) * 5", "3   4 +  5 *", "(3+4)*5",
+        "sen(45) ^ 2 + 0.5", "sen( 45 )^2+0.5", "(3 + 4) * 5"
+    };
+    CacheExpressoes *cache = criarCacheExpressoes(1 << 20, 0);
+    EstatisticasCache est;
+    int i;
+
+    printf("\n===============================\n");
+    printf("Processamento com cache de resultados\n");
+    for (i = 0; i < 7; ++i) {
+        char *saida = NULL;
+        float valor;
+        int ehPos;
+        if (processarExpressaoCache(cache, entradas[i], &saida, &valor, &ehPos) == 0) {
+            printf("  %-20s -> %-20s = %.6f\n", entradas[i], saida, valor);
+        } else {
+            printf("  %-20s -> ERRO\n", entradas[i]);
+        }
+        free(saida);
+    }
+    estatisticasCache(cache, &est);
+    printf("  acertos=%llu falhas=%llu entradas=%d\n", est.acertos, est.falhas, (int)est.entradas);
+    destruirCacheExpressoes(cache);
+}
+
+/*
+ * Uso:
+ *   expressao                    executa os exemplos abaixo
+ *   expressao --fluxo [arquivo]  uma expressão por linha (sem arquivo ou "-": entrada padrão);
+ *                                imprime "convertida<TAB>valor" ou "ERRO" por linha
+ *                                (com -DESTATISTICAS, os contadores vão para a saída de erro no fim)
+ *   expressao --benchmark [--quantidade N] [--profundidade N] [--largura N] [--funcoes PCT]
+ *                         [--numeros idne] [--semente N] [--repeticoes N]
+ *                                mede cada etapa sobre um corpus aleatório; uma linha JSON por etapa
+ *   expressao --precisao [amostras]
+ *                                erro das funções embutidas em cada precisão contra a libm
+ *                                (0 amostras: todos os floats); sai com 1 se algum limite falhar
+ *   expressao --formatacao [amostras]
+ *                                confere formatarFloat/formatarDouble contra o snprintf e compara
+ *                                os tempos (0 amostras: todos os floats); sai com 1 se divergir
+ *   expressao --gerar-c [arquivo]
+ *                                linhas "nome = expressão" viram um cabeçalho C com uma função
+ *                                static inline por fórmula (geracao.h), para compilar junto
+ *   expressao --servidor [--unix caminho] [--porta N] [--threads N] [--lote N] [--max-mensagem N]
+ *                                atende pedidos (protocolo em servidor.h) até SIGINT/SIGTERM;
+ *                                no fim, uma linha JSON com as estatísticas
+ *   expressao --carga [--unix caminho] [--porta N] [--conexoes N] [--pipeline N] [--pedidos N]
+ *                     [--threads N] [--threads-servidor N] [--quantidade N] [--semente N]
+ *                                gera carga e confere as respostas; sem --unix nem --porta, contra
+ *                                um servidor no próprio processo; sai com 1 se algo divergir
+ */
+static ServidorExpressoes *servidorAtivo;
+
+static void pararNoSinal(int sinal) {
+    (void)sinal;
+    pararServidor(servidorAtivo);
+}
+
+int main(int argc, char **argv) {
+
+    if (argc >= 2 && strcmp(argv[1], "--fluxo") == 0) {
+        if (processarArquivoFluxo(argc >= 3 ? argv[2] : NULL, stdout, NULL) != 0) {
+            fprintf(stderr, "ERRO ao processar %s\n", argc >= 3 ? argv[2] : "a entrada padrao");
+            return 1;
+        }
+        mostrarEstatisticas(stderr);
+        return 0;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--benchmark") == 0) {
+        ConfigBenchmark cfg;
+        configBenchmarkPadrao(&cfg);
+        if (lerConfigBenchmark(argc - 2, argv + 2, &cfg) != 0) {
+            fprintf(stderr, "ERRO: opcoes invalidas para --benchmark\n");
+            return 1;
+        }
+        return executarBenchmark(&cfg, stdout) == 0 ? 0 : 1;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--precisao") == 0) {
+        unsigned long long amostras = (argc >= 3) ? strtoull(argv[2], NULL, 10) : (1ULL << 22);
+        return verificarPrecisao(amostras, stdout) == 0 ? 0 : 1;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--formatacao") == 0) {
+        unsigned long long amostras = (argc >= 3) ? strtoull(argv[2], NULL, 10) : (1ULL << 20);
+        return verificarFormatacao(amostras, stdout) == 0 ? 0 : 1;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--gerar-c") == 0) {
+        if (gerarCabecalhoC(argc >= 3 ? argv[2] : NULL, stdout) != 0) {
+            fprintf(stderr, "ERRO ao gerar codigo para %s\n", argc >= 3 ? argv[2] : "a entrada padrao");
+            return 1;
+        }
+        return 0;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--servidor") == 0) {
+        ConfigServidor cfg;
+        EstatisticasServidor est;
+        int r;
+        configServidorPadrao(&cfg);
+        if (lerConfigServidor(argc - 2, argv + 2, &cfg) != 0) {
+            fprintf(stderr, "ERRO: opcoes invalidas para --servidor\n");
+            return 1;
+        }
+        servidorAtivo = criarServidor(&cfg);
+        if (!servidorAtivo) {
+            fprintf(stderr, "ERRO ao escutar em %s\n", cfg.caminhoUnix ? cfg.caminhoUnix : "127.0.0.1");
+            return 1;
+        }
+        signal(SIGINT, pararNoSinal);
+        signal(SIGTERM, pararNoSinal);
+        r = executarServidor(servidorAtivo);
+        estatisticasServidor(servidorAtivo, &est);
+        printf("{\"servidor\":{\"conexoes\":%llu,\"pedidos\":%llu,\"lotes\":%llu,\"maior_lote\":%llu,"
+               "\"bytes_recebidos\":%llu,\"bytes_enviados\":%llu}}\n",
+               est.conexoes, est.pedidos, est.lotes, est.maiorLote, est.bytesRecebidos, est.bytesEnviados);
+        destruirServidor(servidorAtivo);
+        return r == 0 ? 0 : 1;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--carga") == 0) {
+        ConfigCarga cfg;
+        configCargaPadrao(&cfg);
+        if (lerConfigCarga(argc - 2, argv + 2, &cfg) != 0) {
+            fprintf(stderr, "ERRO: opcoes invalidas para --carga\n");
+            return 1;
+        }
+        return executarCarga(&cfg, stdout) == 0 ? 0 : 1;
+    }
 
     // ======= TESTES QUE VOCÊ PEDIU =======
 
@@ -63,5 +552,47 @@ int main() {
     testar("0.5 45 sen 2 ^ +");
     testar("sen(45) ^ 2 + 0.5");
 
+    // ======= EXPRESSOES COMPILADAS COM VARIAVEIS =======
+    {
+        const char *nomes[] = { "x", "y" };
+        const float valores[] = { 3.0f, 4.0f };
+        testarPrograma("x * (y + 2)", nomes, 2, valores);
+        testarPrograma("x y ^ raiz", nomes, 2, valores);
+        testarPrograma("sen(x * 15) ^ 2 + cos(y * 15) ^ 2", nomes, 2, valores);
+        testarPrograma("(x + y) * (x + y) + (log(10)) ^ 3", nomes, 2, valores);
+    }
+
+    // ======= FUNCOES REGISTRADAS PELO USUARIO =======
+    registrarFuncaoBinaria("max", maximo, NULL);
+    registrarFuncaoUnaria("dobro", dobro, NULL);
+    testar("max(3, -4) * dobro(5)");
+    testar("3 4 max 5 dobro +");
+    {
+        const char *nomes[] = { "x", "y" };
+        const float valores[] = { 3.0f, 4.0f };
+        testarPrograma("dobro(max(x, y - 2)) + max(x, 1)", nomes, 2, valores);
+    }
+    testarLote("x ^ 2 + raiz(y) / (x - 3)");
+    testarPrecisao("sen(x)");
+    testarTipos("2 ^ 62 + 1");
+    testarTipos("(-1) ^ 123456789 + 2 ^ 62");
+    testarTipos("7 / 2 + 2 ^ 0.5");
+
+    testarGrafo();
+    testarArquivoProgramas();
+    testarArmazem();
+    testarGeracaoC();
+
+    testarLoteExpressoes();
+    testarArvoreParalela();
+    testarArena();
+    testarCache();
+
+    if (estatisticasDisponiveis()) {
+        printf("\n===============================\n");
+        printf("Estatisticas acumuladas\n");
+        mostrarEstatisticas(stdout);
+    }
+
     return 0;
 }
@@ -0,0 +1,462 @@
+/* matematica.c - núcleos vetoriais de sen/cos/tg (graus), log10 e raiz em duas precisões */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "expressao.h"
+#include "funcoes.h"
+#include "matematica.h"
+#include "estatisticas.h"
+#include "vetor.h"
+
+#define LIMITE_GRAUS 8388608.0f // 2^23: até aqui x - 90q é exato em float
+#define PI_180 0.017453292519943295769
+#define LN2 0.69314718055994530942
+#define LOG10_E 0.43429448190325182765
+
+typedef VetorF (*FuncaoVetor)(VetorF x);
+
+/*
+ * r[i] = f(a[i]) para i em [0, n), um vetor por vez; o último é completado
+ * com 1. As posições fora de [lo, hi] (NaN, infinitos, |x| grande...) são
+ * refeitas por especial. r pode coincidir com a.
+ */
+static inline void percorrer(float *r, const float *a, int n, FuncaoVetor f, FuncaoUnaria especial, float lo, float hi) {
+    float tmp[LARGURA], orig[LARGURA];
+    int i, k;
+    for (i = 0; i < n; i += LARGURA) {
+        const float *x = a + i;
+        float *y = r + i;
+        int m = (n - i < LARGURA) ? n - i : LARGURA;
+        int fora;
+        VetorF v;
+        if (m < LARGURA) {
+            for (k = 0; k < LARGURA; ++k) tmp[k] = (k < m) ? x[k] : 1.0f;
+            x = y = tmp;
+        }
+        v = V_CARREGAR(x);
+        fora = V_FORA(v, lo, hi);
+        if (fora) V_GUARDAR(orig, v);
+        V_GUARDAR(y, f(v));
+        for (k = 0; fora; ++k, fora >>= 1) {
+            if (fora & 1) y[k] = especial(orig[k]);
+        }
+        if (m < LARGURA) memcpy(r + i, tmp, sizeof(float) * (size_t)m);
+    }
+}
+
+/* núcleo em bloco nome##Lote e a versão escalar nome, que passa pelo mesmo código */
+#define DEFINIR_NUCLEO(nome, vetorial, especial, lo, hi) \
+    static void nome##Lote(float *r, const float *a, const float *b, int n) { \
+        (void)b; \
+        percorrer(r, a, n, vetorial, especial, lo, hi); \
+    } \
+    static float nome(float x) { \
+        float r; \
+        nome##Lote(&r, &x, NULL, 1); \
+        return r; \
+    }
+
+/* ---- casos especiais, escalares em double (erro <= 1 ulp) ---- */
+
+/* x = 360n + 90q + r com |r| <= 45; fmod é exato para qualquer x */
+static double reduzirGrausD(float x, int *q) {
+    double r = fmod((double)x, 360.0);
+    double k;
+    *q = 0;
+    if (r != r) return r;
+    k = nearbyint(r / 90.0);
+    *q = (int)k & 3;
+    return r - 90.0 * k;
+}
+
+static float senoEspecial(float x) {
+    int q;
+    double t = reduzirGrausD(x, &q) * PI_180;
+    double v = (q & 1) ? cos(t) : sin(t);
+    return (float)((q & 2) ? -v : v);
+}
+
+static float cossenoEspecial(float x) {
+    int q;
+    double t = reduzirGrausD(x, &q) * PI_180;
+    double v = (q & 1) ? sin(t) : cos(t);
+    return (float)(((q + 1) & 2) ? -v : v);
+}
+
+static float tangenteEspecial(float x) {
+    int q;
+    double t = reduzirGrausD(x, &q) * PI_180;
+    return (float)((q & 1) ? -cos(t) / sin(t) : sin(t) / cos(t));
+}
+
+static float log10Especial(float x) {
+    return (x <= 0.0f) ? 0.0f : (float)log10((double)x);
+}
+
+/* ---- redução comum às duas precisões ---- */
+
+/* x = 90q + r com |r| <= 45 (um pouco mais por arredondamento), exato se |x| <= LIMITE_GRAUS */
+static VetorF reduzirGraus(VetorF x, VetorI *q) {
+    VetorF qf = V_ARRED(V_MUL(x, V_CONST(1.0f / 90.0f)));
+    *q = V_PARA_INT(qf);
+    return V_SUB(x, V_MUL(qf, V_CONST(90.0f)));
+}
+
+/* x = 2^e m com m em [sqrt(2)/2, sqrt(2)), para x normal e positivo */
+static VetorF decompor(VetorF x, VetorF *e) {
+    VetorI k = VI_SHR(VI_SUB(V_BITS(x), VI_CONST(0x3f3504f3)), 23);
+    *e = V_DE_INT(k);
+    return V_DE_BITS(VI_SUB(V_BITS(x), VI_SHL(k, 23)));
+}
+
+/* ---- PRECISAO_ULP: polinômios de Taylor em double, um arredondamento no fim ---- */
+
+/* |t| <= pi/4: o primeiro termo desprezado é < 1e-11 relativo */
+static VetorD senoD(VetorD t) {
+    VetorD t2 = VD_MUL(t, t);
+    VetorD p = VD_CONST(-1.0 / 39916800);
+    p = VD_SOMA(VD_MUL(p, t2), VD_CONST(1.0 / 362880));
+    p = VD_SOMA(VD_MUL(p, t2), VD_CONST(-1.0 / 5040));
+    p = VD_SOMA(VD_MUL(p, t2), VD_CONST(1.0 / 120));
+    p = VD_SOMA(VD_MUL(p, t2), VD_CONST(-1.0 / 6));
+    return VD_SOMA(t, VD_MUL(VD_MUL(t, t2), p));
+}
+
+static VetorD cossenoD(VetorD t) {
+    VetorD t2 = VD_MUL(t, t);
+    VetorD p = VD_CONST(1.0 / 479001600);
+    p = VD_SOMA(VD_MUL(p, t2), VD_CONST(-1.0 / 3628800));
+    p = VD_SOMA(VD_MUL(p, t2), VD_CONST(1.0 / 40320));
+    p = VD_SOMA(VD_MUL(p, t2), VD_CONST(-1.0 / 720));
+    p = VD_SOMA(VD_MUL(p, t2), VD_CONST(1.0 / 24));
+    p = VD_SOMA(VD_MUL(p, t2), VD_CONST(-1.0 / 2));
+    return VD_SOMA(VD_CONST(1.0), VD_MUL(t2, p));
+}
+
+/* ln(2^e m) = e ln2 + 2 atanh(s), s = (m-1)/(m+1) em [-0.172, 0.172] */
+static VetorD lnD(VetorD m, VetorD e) {
+    VetorD f = VD_SUB(m, VD_CONST(1.0));
+    VetorD s = VD_DIV(f, VD_SOMA(f, VD_CONST(2.0)));
+    VetorD s2 = VD_MUL(s, s);
+    VetorD p = VD_CONST(2.0 / 11);
+    p = VD_SOMA(VD_MUL(p, s2), VD_CONST(2.0 / 9));
+    p = VD_SOMA(VD_MUL(p, s2), VD_CONST(2.0 / 7));
+    p = VD_SOMA(VD_MUL(p, s2), VD_CONST(2.0 / 5));
+    p = VD_SOMA(VD_MUL(p, s2), VD_CONST(2.0 / 3));
+    p = VD_MUL(p, s2);
+    return VD_SOMA(VD_MUL(e, VD_CONST(LN2)), VD_SOMA(VD_SOMA(s, s), VD_MUL(s, p)));
+}
+
+static void senoCossenoUlp(VetorF r, VetorF *s, VetorF *c) {
+    VetorD tb = VD_MUL(VD_BAIXO(r), VD_CONST(PI_180));
+    VetorD ta = VD_MUL(VD_ALTO(r), VD_CONST(PI_180));
+    *s = V_DE_VD(senoD(tb), senoD(ta));
+    *c = V_DE_VD(cossenoD(tb), cossenoD(ta));
+}
+
+static VetorF senoUlpV(VetorF x) {
+    VetorI q;
+    VetorF s, c, v;
+    senoCossenoUlp(reduzirGraus(x, &q), &s, &c);
+    v = V_ESCOLHER_BIT(q, 1, s, c);
+    return V_ESCOLHER_BIT(q, 2, v, V_NEGAR(v));
+}
+
+static VetorF cossenoUlpV(VetorF x) {
+    VetorI q;
+    VetorF s, c, v;
+    senoCossenoUlp(reduzirGraus(x, &q), &s, &c);
+    v = V_ESCOLHER_BIT(q, 1, c, s);
+    return V_ESCOLHER_BIT(VI_SOMA(q, VI_CONST(1)), 2, v, V_NEGAR(v));
+}
+
+/* tg = s/c nos quadrantes pares e -c/s nos ímpares; cada quociente é arredondado uma vez */
+static VetorF tangenteUlpV(VetorF x) {
+    VetorI q;
+    VetorF r = reduzirGraus(x, &q);
+    VetorD tb = VD_MUL(VD_BAIXO(r), VD_CONST(PI_180));
+    VetorD ta = VD_MUL(VD_ALTO(r), VD_CONST(PI_180));
+    VetorD sb = senoD(tb), cb = cossenoD(tb), sa = senoD(ta), ca = cossenoD(ta);
+    VetorF tg = V_DE_VD(VD_DIV(sb, cb), VD_DIV(sa, ca));
+    VetorF cotg = V_DE_VD(VD_DIV(cb, sb), VD_DIV(ca, sa));
+    return V_ESCOLHER_BIT(q, 1, tg, V_NEGAR(cotg));
+}
+
+static VetorF log10UlpV(VetorF x) {
+    VetorF e, m = decompor(x, &e);
+    VetorD lb = lnD(VD_BAIXO(m), VD_BAIXO(e));
+    VetorD la = lnD(VD_ALTO(m), VD_ALTO(e));
+    return V_DE_VD(VD_MUL(lb, VD_CONST(LOG10_E)), VD_MUL(la, VD_CONST(LOG10_E)));
+}
+
+DEFINIR_NUCLEO(senoUlp, senoUlpV, senoEspecial, -LIMITE_GRAUS, LIMITE_GRAUS)
+DEFINIR_NUCLEO(cossenoUlp, cossenoUlpV, cossenoEspecial, -LIMITE_GRAUS, LIMITE_GRAUS)
+DEFINIR_NUCLEO(tangenteUlp, tangenteUlpV, tangenteEspecial, -LIMITE_GRAUS, LIMITE_GRAUS)
+DEFINIR_NUCLEO(log10Ulp, log10UlpV, log10Especial, FLT_MIN, FLT_MAX)
+
+/* ---- PRECISAO_RAPIDA: polinômios curtos em float, vetor inteiro por passo ---- */
+
+static void senoCossenoRapido(VetorF r, VetorF *s, VetorF *c) {
+    VetorF t = V_MUL(r, V_CONST((float)PI_180));
+    VetorF t2 = V_MUL(t, t);
+    VetorF p = V_SOMA(V_MUL(V_CONST(-1.0f / 5040), t2), V_CONST(1.0f / 120));
+    p = V_SOMA(V_MUL(p, t2), V_CONST(-1.0f / 6));
+    *s = V_SOMA(t, V_MUL(V_MUL(t, t2), p));
+    p = V_SOMA(V_MUL(V_CONST(-1.0f / 720), t2), V_CONST(1.0f / 24));
+    p = V_SOMA(V_MUL(p, t2), V_CONST(-1.0f / 2));
+    *c = V_SOMA(V_CONST(1.0f), V_MUL(t2, p));
+}
+
+static VetorF senoRapidoV(VetorF x) {
+    VetorI q;
+    VetorF s, c, v;
+    senoCossenoRapido(reduzirGraus(x, &q), &s, &c);
+    v = V_ESCOLHER_BIT(q, 1, s, c);
+    return V_ESCOLHER_BIT(q, 2, v, V_NEGAR(v));
+}
+
+static VetorF cossenoRapidoV(VetorF x) {
+    VetorI q;
+    VetorF s, c, v;
+    senoCossenoRapido(reduzirGraus(x, &q), &s, &c);
+    v = V_ESCOLHER_BIT(q, 1, c, s);
+    return V_ESCOLHER_BIT(VI_SOMA(q, VI_CONST(1)), 2, v, V_NEGAR(v));
+}
+
+static VetorF tangenteRapidaV(VetorF x) {
+    VetorI q;
+    VetorF s, c;
+    senoCossenoRapido(reduzirGraus(x, &q), &s, &c);
+    return V_ESCOLHER_BIT(q, 1, V_DIV(s, c), V_NEGAR(V_DIV(c, s)));
+}
+
+static VetorF log10RapidoV(VetorF x) {
+    VetorF e, m = decompor(x, &e);
+    VetorF f = V_SUB(m, V_CONST(1.0f));
+    VetorF s = V_DIV(f, V_SOMA(f, V_CONST(2.0f)));
+    VetorF s2 = V_MUL(s, s);
+    VetorF p = V_SOMA(V_MUL(V_CONST(2.0f / 7), s2), V_CONST(2.0f / 5));
+    VetorF ln;
+    p = V_SOMA(V_MUL(p, s2), V_CONST(2.0f / 3));
+    p = V_MUL(p, s2);
+    ln = V_SOMA(V_MUL(e, V_CONST((float)LN2)), V_SOMA(V_SOMA(s, s), V_MUL(s, p)));
+    return V_MUL(ln, V_CONST((float)LOG10_E));
+}
+
+/* estimativa de 1/sqrt(x) refinada por um passo de Newton */
+static VetorF raizRapidaV(VetorF x) {
+    VetorF y = V_INV_RAIZ(x);
+    y = V_MUL(y, V_SUB(V_CONST(1.5f), V_MUL(V_MUL(V_CONST(0.5f), x), V_MUL(y, y))));
+    return V_MUL(x, y);
+}
+
+DEFINIR_NUCLEO(senoRapido, senoRapidoV, senoEspecial, -LIMITE_GRAUS, LIMITE_GRAUS)
+DEFINIR_NUCLEO(cossenoRapido, cossenoRapidoV, cossenoEspecial, -LIMITE_GRAUS, LIMITE_GRAUS)
+DEFINIR_NUCLEO(tangenteRapida, tangenteRapidaV, tangenteEspecial, -LIMITE_GRAUS, LIMITE_GRAUS)
+DEFINIR_NUCLEO(log10Rapido, log10RapidoV, log10Especial, FLT_MIN, FLT_MAX)
+DEFINIR_NUCLEO(raizRapida, raizRapidaV, raizAprox, FLT_MIN, FLT_MAX)
+
+/* ---- tabela por precisão, na ordem do enum FUNC_* ---- */
+
+typedef struct {
+    FuncaoUnaria escalar;
+    FuncaoLote lote; // NULL: raiz, cujo laço de lote.c já é correto até o último bit
+} Nucleo;
+
+static const Nucleo nucleos[PRECISAO_QUANTIDADE - 1][FUNC_QUANTIDADE] = {
+    { /* PRECISAO_ULP */
+        { senoUlp, senoUlpLote }, { cossenoUlp, cossenoUlpLote }, { tangenteUlp, tangenteUlpLote },
+        { log10Ulp, log10UlpLote }, { log10Ulp, log10UlpLote },
+        { raizAprox, NULL }, { raizAprox, NULL }
+    },
+    { /* PRECISAO_RAPIDA */
+        { senoRapido, senoRapidoLote }, { cossenoRapido, cossenoRapidoLote }, { tangenteRapida, tangenteRapidaLote },
+        { log10Rapido, log10RapidoLote }, { log10Rapido, log10RapidoLote },
+        { raizRapida, raizRapidaLote }, { raizRapida, raizRapidaLote }
+    }
+};
+
+static const Nucleo *nucleoEmbutido(int id, Precisao p) {
+    if (p <= PRECISAO_LIBM || p >= PRECISAO_QUANTIDADE || id < 0 || id >= FUNC_QUANTIDADE) return NULL;
+    return &nucleos[p - 1][id];
+}
+
+FuncaoUnaria funcaoPrecisao(int id, Precisao p) {
+    const Nucleo *k = nucleoEmbutido(id, p);
+    const DescritorFuncao *d;
+    if (k) return k->escalar;
+    d = descritorFuncao(id);
+    return d ? d->unaria : NULL;
+}
+
+FuncaoLote nucleoPrecisao(int id, Precisao p) {
+    const Nucleo *k = nucleoEmbutido(id, p);
+    const DescritorFuncao *d;
+    if (k) return k->lote;
+    d = descritorFuncao(id);
+    return d ? d->lote : NULL;
+}
+
+/* ---- verificação contra a libm em long double ---- */
+
+#define PI_L 3.14159265358979323846264338327950288L
+#define BLOCO_VERIFICACAO 4096
+
+static long double reduzirGrausL(float x, int *q) {
+    long double r = fmodl((long double)x, 360.0L);
+    long double k;
+    *q = 0;
+    if (r != r) return r;
+    k = nearbyintl(r / 90.0L);
+    *q = (int)k & 3;
+    return (r - 90.0L * k) * (PI_L / 180.0L);
+}
+
+static long double senoRef(float x) {
+    int q;
+    long double t = reduzirGrausL(x, &q);
+    long double v = (q & 1) ? cosl(t) : sinl(t);
+    return (q & 2) ? -v : v;
+}
+
+static long double cossenoRef(float x) {
+    int q;
+    long double t = reduzirGrausL(x, &q);
+    long double v = (q & 1) ? sinl(t) : cosl(t);
+    return ((q + 1) & 2) ? -v : v;
+}
+
+static long double tangenteRef(float x) {
+    int q;
+    long double t = reduzirGrausL(x, &q);
+    return (q & 1) ? -cosl(t) / sinl(t) : sinl(t) / cosl(t);
+}
+
+static long double log10Ref(float x) { return (x <= 0.0f) ? 0.0L : log10l((long double)x); }
+static long double raizRef(float x) { return (x <= 0.0f) ? 0.0L : sqrtl((long double)x); }
+
+typedef struct {
+    const char *nome;
+    int id;
+    long double (*referencia)(float x);
+    float denso0, denso1; // faixa amostrada densamente
+} CasoVerificacao;
+
+static const CasoVerificacao casos[] = {
+    { "sen",   FUNC_SEN,   senoRef,     -720.0f, 720.0f },
+    { "cos",   FUNC_COS,   cossenoRef,  -720.0f, 720.0f },
+    { "tg",    FUNC_TG,    tangenteRef, -720.0f, 720.0f },
+    { "log10", FUNC_LOG10, log10Ref,    0.0f,    1000.0f },
+    { "raiz",  FUNC_RAIZ,  raizRef,     0.0f,    1000.0f }
+};
+
+static const char *nomesPrecisao[] = { "libm", "ulp", "rapida" };
+static const double limiteUlp[] = { -1.0, 1.0, -1.0 };    // < 0: sem limite
+static const double limiteRel[] = { -1.0, -1.0, 1e-4 };
+
+/* ulp de um float na magnitude de v (o menor subnormal abaixo de FLT_MIN) */
+static long double ulpFloat(long double v) {
+    int e;
+    if (v == 0.0L) return ldexpl(1.0L, -149);
+    frexpl(v, &e);
+    return ldexpl(1.0L, (e - 24 < -149) ? -149 : e - 24);
+}
+
+typedef struct {
+    double maxUlp, maxRel;
+    unsigned long long n;
+    long long ns;                // só na faixa densa: fora dela quase tudo é caso especial
+    unsigned long long nCronometrados;
+} Medida;
+
+/* mede as três precisões sobre x[0..n); tg nos polos (referência infinita) fica de fora */
+static void medirBloco(const CasoVerificacao *c, const float *x, int n, int cronometrar, Medida *med) {
+    float y[BLOCO_VERIFICACAO];
+    long double ref[BLOCO_VERIFICACAO];
+    int p, i;
+    for (i = 0; i < n; ++i) ref[i] = c->referencia(x[i]);
+    for (p = 0; p < PRECISAO_QUANTIDADE; ++p) {
+        FuncaoLote lote = nucleoPrecisao(c->id, (Precisao)p);
+        FuncaoUnaria escalar = funcaoPrecisao(c->id, (Precisao)p);
+        long long t0 = relogioNs();
+        if (lote) {
+            lote(y, x, NULL, n);
+        } else {
+            for (i = 0; i < n; ++i) y[i] = escalar(x[i]);
+        }
+        if (cronometrar) {
+            med[p].ns += relogioNs() - t0;
+            med[p].nCronometrados += (unsigned long long)n;
+        }
+        med[p].n += (unsigned long long)n;
+        for (i = 0; i < n; ++i) {
+            long double d;
+            double eu, er = 0.0;
+            if (isinf(ref[i])) continue;
+            if (isnan(ref[i]) || isnan(y[i])) {
+                eu = (isnan(ref[i]) && isnan(y[i])) ? 0.0 : HUGE_VAL;
+                er = eu;
+            } else {
+                d = fabsl((long double)y[i] - ref[i]);
+                eu = (double)(d / ulpFloat(ref[i]));
+                if (fabsl(ref[i]) >= FLT_MIN) er = (double)(d / fabsl(ref[i]));
+            }
+            if (eu > med[p].maxUlp) med[p].maxUlp = eu;
+            if (er > med[p].maxRel) med[p].maxRel = er;
+        }
+    }
+}
+
+/* JSON não tem infinito: NaN trocado por número (a libm em float faz isso) vira null */
+static void escreverNumero(FILE *saida, double v) {
+    if (isfinite(v)) fprintf(saida, "%.3g", v);
+    else fputs("null", saida);
+}
+
+int verificarPrecisao(unsigned long long amostras, FILE *saida) {
+    unsigned long long total = amostras ? amostras : (1ULL << 32);
+    unsigned long long passo = amostras ? ((1ULL << 32) / amostras ? (1ULL << 32) / amostras : 1) : 1;
+    unsigned long long densos = amostras / 4;
+    size_t ic;
+    int falhou = 0;
+    for (ic = 0; ic < sizeof(casos) / sizeof(casos[0]); ++ic) {
+        const CasoVerificacao *c = &casos[ic];
+        Medida med[PRECISAO_QUANTIDADE];
+        float x[BLOCO_VERIFICACAO];
+        unsigned long long k = 0;
+        int p;
+        memset(med, 0, sizeof(med));
+        /* bits espaçados por todo o intervalo, depois a faixa densa */
+        while (k < total + densos) {
+            int denso = (k >= total), n = 0;
+            unsigned long long fim = denso ? total + densos : total;
+            for (; n < BLOCO_VERIFICACAO && k < fim; ++n, ++k) {
+                if (k < total) {
+                    unsigned int bits = (unsigned int)(k * passo);
+                    memcpy(&x[n], &bits, sizeof(float));
+                } else {
+                    double f = (double)(k - total) / (double)densos;
+                    x[n] = (float)(c->denso0 + (c->denso1 - c->denso0) * f);
+                }
+            }
+            medirBloco(c, x, n, denso, med);
+        }
+        for (p = 0; p < PRECISAO_QUANTIDADE; ++p) {
+            int ok = (limiteUlp[p] < 0 || med[p].maxUlp <= limiteUlp[p]) &&
+                     (limiteRel[p] < 0 || med[p].maxRel <= limiteRel[p]);
+            if (!ok) falhou = 1;
+            fprintf(saida, "{\"funcao\":\"%s\",\"precisao\":\"%s\",\"amostras\":%llu,\"erro_max_ulp\":",
+                    c->nome, nomesPrecisao[p], med[p].n);
+            escreverNumero(saida, med[p].maxUlp);
+            fprintf(saida, ",\"erro_max_rel\":");
+            escreverNumero(saida, med[p].maxRel);
+            fprintf(saida, ",\"ns_por_valor\":%.2f,\"ok\":%s}\n",
+                    med[p].nCronometrados ? (double)med[p].ns / (double)med[p].nCronometrados : 0.0,
+                    ok ? "true" : "false");
+        }
+    }
+    return falhou ? -1 : 0;
+}
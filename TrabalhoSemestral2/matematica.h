@@ -0,0 +1,39 @@
+#ifndef MATEMATICA_H
+#define MATEMATICA_H
+#include <stdio.h>
+#include "funcoes.h"
+
+/*
+ * Núcleos vetoriais das funções embutidas (sen, cos, tg em graus, log10 e
+ * raiz), que processam um vetor inteiro (vetor.h) por passo. A precisão é
+ * escolhida por programa (compilarExpressaoPrecisao) e vale para
+ * avaliarPrograma, avaliarProgramaLote e o JIT, que chamam o mesmo núcleo
+ * e por isso dão o mesmo resultado.
+ */
+typedef enum {
+    PRECISAO_LIBM,   // libm escalar com a conversão de graus em float, como o original (padrão)
+    PRECISAO_ULP,    // erro <= 1 ulp do valor exato; cálculo interno em double
+    PRECISAO_RAPIDA, // erro relativo <= 1e-4; polinômios curtos em float
+    PRECISAO_QUANTIDADE
+} Precisao;
+
+/*
+ * Função escalar (FuncaoUnaria) ou núcleo em bloco (FuncaoLote) da função
+ * id na precisão dada. Para funções do usuário e em PRECISAO_LIBM devolvem
+ * as do registro (o núcleo pode ser NULL, e aí cabe ao chamador o laço).
+ * Nas precisões vetoriais, tg(90 + 180k) dá infinito e o argumento das
+ * trigonométricas é reduzido exatamente, mesmo para |x| grande.
+ */
+FuncaoUnaria funcaoPrecisao(int id, Precisao p);
+FuncaoLote nucleoPrecisao(int id, Precisao p);
+
+/*
+ * Compara cada núcleo com a libm em long double e escreve uma linha JSON
+ * por função e precisão (erro máximo em ulp e relativo, ns por valor).
+ * amostras > 0 percorre esse número de floats espalhados por todo o
+ * intervalo de bits, mais uma faixa densa em volta dos argumentos comuns;
+ * amostras == 0 percorre todos os 2^32 floats. Retorna 0 se todos os
+ * limites documentados forem respeitados, -1 caso contrário.
+ */
+int verificarPrecisao(unsigned long long amostras, FILE *saida);
+#endif
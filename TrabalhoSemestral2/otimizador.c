@@ -0,0 +1,220 @@
+/* otimizador.c - dobra de constantes e subexpressões comuns sobre o código pós-fixo */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "expressao.h"
+#include "programa.h"
+#include "funcoes.h"
+
+/* nó do grafo (DAG): filhos sempre têm índice menor que o pai */
+typedef struct {
+    Instrucao ins;  // op, funcao e arg (CONST/VAR); nos operadores arg fica zerado
+    int a, b;       // filhos, -1 se não houver
+    int usos;       // quantos pais alcançáveis usam o nó
+    int temp;       // temporário que guarda o valor, -1 se não for compartilhado
+    int emitido;
+} NoDag;
+
+typedef struct {
+    NoDag *nos;
+    int nNos;
+    int *tabela;    // índices dos nós por hash, -1 = vazio
+    size_t mascara;
+} Grafo;
+
+static unsigned long hashNo(const Instrucao *ins, int a, int b) {
+    unsigned int bits;
+    unsigned long h;
+    memcpy(&bits, &ins->arg, sizeof(bits));
+    h = (unsigned long)ins->op * 31u + ins->funcao;
+    h = h * 1000003u ^ bits;
+    h = h * 1000003u ^ (unsigned int)a;
+    h = h * 1000003u ^ (unsigned int)b;
+    return h ^ (h >> 15);
+}
+
+/* devolve o nó igual já existente ou cria um novo (hash-consing) */
+static int internar(Grafo *g, const Instrucao *ins, int a, int b) {
+    size_t i = hashNo(ins, a, b) & g->mascara;
+    while (g->tabela[i] >= 0) {
+        const NoDag *n = &g->nos[g->tabela[i]];
+        if (n->ins.op == ins->op && n->ins.funcao == ins->funcao &&
+            memcmp(&n->ins.arg, &ins->arg, sizeof(ins->arg)) == 0 && n->a == a && n->b == b) {
+            return g->tabela[i];
+        }
+        i = (i + 1) & g->mascara;
+    }
+    g->nos[g->nNos].ins = *ins;
+    g->nos[g->nNos].a = a;
+    g->nos[g->nNos].b = b;
+    g->nos[g->nNos].usos = 0;
+    g->nos[g->nNos].temp = -1;
+    g->nos[g->nNos].emitido = 0;
+    g->tabela[i] = g->nNos;
+    return g->nNos++;
+}
+
+static int internarConstante(Grafo *g, float v) {
+    Instrucao ins;
+    memset(&ins, 0, sizeof(ins));
+    ins.op = OP_CONST;
+    ins.arg.valor = v;
+    return internar(g, &ins, -1, -1);
+}
+
+/* mesmas operações de avaliarPrograma, para que o valor dobrado seja idêntico */
+static float calcularBinario(int op, float a, float b) {
+    switch (op) {
+        case OP_SOMA: return a + b;
+        case OP_SUB: return a - b;
+        case OP_MUL: return a * b;
+        case OP_DIV: return (b != 0.0f) ? a / b : 0.0f;
+    }
+    return aplicarOperadorBinario(operadorDoCodigo(op), a, b);
+}
+
+static int montarGrafo(Grafo *g, const Programa *prog) {
+    int *pilha = (int*)malloc(sizeof(int) * (size_t)(prog->profundidadeMax + 1));
+    int topo = -1, pc;
+    if (!pilha) return -1;
+    for (pc = 0; pc < prog->tamanho; ++pc) {
+        Instrucao ins = prog->codigo[pc];
+        switch (ins.op) {
+            case OP_CONST:
+            case OP_VAR:
+                pilha[++topo] = internar(g, &ins, -1, -1);
+                break;
+            case OP_FUNC:
+                if (aridadeFuncao(ins.funcao) == 2) {
+                    int b = pilha[topo--];
+                    int a = pilha[topo];
+                    if (g->nos[a].ins.op == OP_CONST && g->nos[b].ins.op == OP_CONST) {
+                        pilha[topo] = internarConstante(g, aplicarFuncaoId2(ins.funcao, g->nos[a].ins.arg.valor, g->nos[b].ins.arg.valor));
+                    } else {
+                        ins.arg.indice = 0;
+                        pilha[topo] = internar(g, &ins, a, b);
+                    }
+                } else {
+                    const NoDag *x = &g->nos[pilha[topo]];
+                    if (x->ins.op == OP_CONST) {
+                        pilha[topo] = internarConstante(g, funcaoPrecisao(ins.funcao, prog->precisao)(x->ins.arg.valor));
+                    } else {
+                        ins.arg.indice = 0;
+                        pilha[topo] = internar(g, &ins, pilha[topo], -1);
+                    }
+                }
+                break;
+            case OP_GUARDAR:
+            case OP_CARREGAR:
+                free(pilha);
+                return -1; /* já otimizado */
+            default: {
+                int b = pilha[topo--];
+                int a = pilha[topo];
+                if (g->nos[a].ins.op == OP_CONST && g->nos[b].ins.op == OP_CONST) {
+                    pilha[topo] = internarConstante(g, calcularBinario(ins.op, g->nos[a].ins.arg.valor, g->nos[b].ins.arg.valor));
+                } else {
+                    ins.arg.indice = 0;
+                    pilha[topo] = internar(g, &ins, a, b);
+                }
+            } break;
+        }
+    }
+    pc = pilha[0];
+    free(pilha);
+    return pc;
+}
+
+static void emitir(Instrucao *codigo, int *n, const Instrucao *ins) {
+    codigo[(*n)++] = *ins;
+}
+
+/* percorre o grafo a partir da raiz em pós-ordem; nós compartilhados são calculados
+   uma vez, guardados num temporário e depois só carregados */
+static int gerarDoGrafo(Grafo *g, int raiz, Instrucao *codigo) {
+    int *pilha = (int*)malloc(sizeof(int) * (size_t)(2 * g->nNos + 1));
+    int topo = 0, n = 0;
+    if (!pilha) return -1;
+    pilha[topo++] = raiz * 2;
+    while (topo > 0) {
+        int id = pilha[--topo];
+        int fase = id & 1;
+        NoDag *no = &g->nos[id >> 1];
+        Instrucao ins;
+        if (fase == 1) {
+            emitir(codigo, &n, &no->ins);
+            if (no->temp >= 0) {
+                memset(&ins, 0, sizeof(ins));
+                ins.op = OP_GUARDAR;
+                ins.arg.indice = no->temp;
+                emitir(codigo, &n, &ins);
+                no->emitido = 1;
+            }
+        } else if (no->emitido) {
+            memset(&ins, 0, sizeof(ins));
+            ins.op = OP_CARREGAR;
+            ins.arg.indice = no->temp;
+            emitir(codigo, &n, &ins);
+        } else if (no->a < 0) {
+            emitir(codigo, &n, &no->ins);
+        } else {
+            pilha[topo++] = id | 1;
+            if (no->b >= 0) pilha[topo++] = no->b * 2;
+            pilha[topo++] = no->a * 2;
+        }
+    }
+    free(pilha);
+    return n;
+}
+
+int otimizarPrograma(Programa *prog) {
+    Grafo g;
+    Instrucao *codigo;
+    size_t cap = 16;
+    int raiz, i, n, altura = 0, prof = 0, nTemp = 0;
+    if (!prog || prog->tamanho == 0) return -1;
+
+    while (cap < (size_t)prog->tamanho * 2) cap *= 2;
+    g.nNos = 0;
+    g.mascara = cap - 1;
+    g.nos = (NoDag*)malloc(sizeof(NoDag) * (size_t)prog->tamanho);
+    g.tabela = (int*)malloc(sizeof(int) * cap);
+    codigo = (Instrucao*)malloc(sizeof(Instrucao) * (size_t)(2 * prog->tamanho + 1));
+    if (!g.nos || !g.tabela || !codigo) { free(g.nos); free(g.tabela); free(codigo); return -1; }
+    memset(g.tabela, 0xff, sizeof(int) * cap);
+
+    raiz = montarGrafo(&g, prog);
+    if (raiz < 0) { free(g.nos); free(g.tabela); free(codigo); return -1; }
+
+    /* conta usos só a partir da raiz: operandos de constantes dobradas ficam de fora */
+    g.nos[raiz].usos = 1;
+    for (i = raiz; i >= 0; --i) {
+        NoDag *no = &g.nos[i];
+        if (no->usos == 0) continue;
+        if (no->a >= 0) g.nos[no->a].usos++;
+        if (no->b >= 0) g.nos[no->b].usos++;
+        if (no->usos > 1 && no->a >= 0) no->temp = nTemp++;
+    }
+
+    n = gerarDoGrafo(&g, raiz, codigo);
+    free(g.nos);
+    free(g.tabela);
+    if (n < 0) { free(codigo); return -1; }
+
+    for (i = 0; i < n; ++i) {
+        switch (codigo[i].op) {
+            case OP_CONST: case OP_VAR: case OP_CARREGAR: altura++; break;
+            case OP_FUNC: altura -= aridadeFuncao(codigo[i].funcao) - 1; break;
+            case OP_GUARDAR: break;
+            default: altura--; break;
+        }
+        if (altura > prof) prof = altura;
+    }
+    free(prog->codigo);
+    prog->codigo = codigo;
+    prog->tamanho = n;
+    prog->profundidadeMax = prof;
+    prog->nTemporarios = nTemp;
+    return 0;
+}
@@ -0,0 +1,509 @@
+/* paralelo.c - pool de threads com roubo de trabalho e processamento de lotes */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "expressao.h"
+#include "programa.h"
+#include "funcoes.h"
+#include "paralelo.h"
+
+/* intervalo de índices ainda não processados de uma thread */
+typedef struct {
+    pthread_mutex_t mtx;
+    size_t inicio;
+    size_t fim;
+} FilaTrabalho;
+
+typedef struct {
+    PoolTrabalho *pool;
+    int id;
+} ArgThread;
+
+struct PoolTrabalho {
+    int nThreads;            // inclui a thread que chama executarParalelo (id 0)
+    pthread_t *threads;      // nThreads - 1 threads auxiliares
+    ArgThread *args;
+    FilaTrabalho *filas;     // uma por thread
+    pthread_mutex_t mtx;     // protege geracao, ativos e encerrar
+    pthread_cond_t condInicio;
+    pthread_cond_t condFim;
+    pthread_mutex_t mtxExecucao; // uma execução por vez
+    unsigned long geracao;
+    int ativos;
+    int encerrar;
+    FuncaoIntervalo f;
+    void *ctx;
+    size_t grao;
+};
+
+int nucleosDisponiveis(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+#endif
+}
+
+static int pegarDaPropria(FilaTrabalho *q, size_t grao, size_t *ini, size_t *fim) {
+    int ok = 0;
+    pthread_mutex_lock(&q->mtx);
+    if (q->inicio < q->fim) {
+        *ini = q->inicio;
+        *fim = (q->fim - q->inicio > grao) ? q->inicio + grao : q->fim;
+        q->inicio = *fim;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&q->mtx);
+    return ok;
+}
+
+/* rouba a metade final da fila de outra thread e a coloca na própria */
+static int roubar(PoolTrabalho *pool, int id) {
+    int k;
+    for (k = 1; k < pool->nThreads; ++k) {
+        FilaTrabalho *vitima = &pool->filas[(id + k) % pool->nThreads];
+        size_t a = 0, b = 0;
+        pthread_mutex_lock(&vitima->mtx);
+        if (vitima->inicio < vitima->fim) {
+            size_t resto = vitima->fim - vitima->inicio;
+            b = vitima->fim;
+            a = b - (resto + 1) / 2;
+            vitima->fim = a;
+        }
+        pthread_mutex_unlock(&vitima->mtx);
+        if (a < b) {
+            FilaTrabalho *propria = &pool->filas[id];
+            pthread_mutex_lock(&propria->mtx);
+            propria->inicio = a;
+            propria->fim = b;
+            pthread_mutex_unlock(&propria->mtx);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void trabalhar(PoolTrabalho *pool, int id) {
+    size_t ini, fim;
+    for (;;) {
+        if (pegarDaPropria(&pool->filas[id], pool->grao, &ini, &fim)) {
+            pool->f(pool->ctx, ini, fim);
+            continue;
+        }
+        if (!roubar(pool, id)) break;
+    }
+}
+
+static void *lacoThread(void *arg) {
+    ArgThread *a = (ArgThread*)arg;
+    PoolTrabalho *pool = a->pool;
+    unsigned long vista = 0;
+    pthread_mutex_lock(&pool->mtx);
+    for (;;) {
+        while (!pool->encerrar && pool->geracao == vista) pthread_cond_wait(&pool->condInicio, &pool->mtx);
+        if (pool->encerrar) break;
+        vista = pool->geracao;
+        pthread_mutex_unlock(&pool->mtx);
+
+        trabalhar(pool, a->id);
+
+        pthread_mutex_lock(&pool->mtx);
+        if (--pool->ativos == 0) pthread_cond_signal(&pool->condFim);
+    }
+    pthread_mutex_unlock(&pool->mtx);
+    return NULL;
+}
+
+PoolTrabalho *criarPoolTrabalho(int nThreads) {
+    PoolTrabalho *pool;
+    int i;
+    if (nThreads <= 0) nThreads = nucleosDisponiveis();
+    pool = (PoolTrabalho*)calloc(1, sizeof(PoolTrabalho));
+    if (!pool) return NULL;
+    pool->nThreads = nThreads;
+    pool->filas = (FilaTrabalho*)calloc((size_t)nThreads, sizeof(FilaTrabalho));
+    pool->threads = (pthread_t*)calloc((size_t)nThreads, sizeof(pthread_t));
+    pool->args = (ArgThread*)calloc((size_t)nThreads, sizeof(ArgThread));
+    if (!pool->filas || !pool->threads || !pool->args) {
+        free(pool->filas); free(pool->threads); free(pool->args); free(pool);
+        return NULL;
+    }
+    for (i = 0; i < nThreads; ++i) pthread_mutex_init(&pool->filas[i].mtx, NULL);
+    pthread_mutex_init(&pool->mtx, NULL);
+    pthread_mutex_init(&pool->mtxExecucao, NULL);
+    pthread_cond_init(&pool->condInicio, NULL);
+    pthread_cond_init(&pool->condFim, NULL);
+
+    for (i = 1; i < nThreads; ++i) {
+        pool->args[i].pool = pool;
+        pool->args[i].id = i;
+        if (pthread_create(&pool->threads[i], NULL, lacoThread, &pool->args[i]) != 0) {
+            /* segue com as threads que subiram; as filas de i em diante não serão mais usadas */
+            int k;
+            for (k = i; k < nThreads; ++k) pthread_mutex_destroy(&pool->filas[k].mtx);
+            pool->nThreads = i;
+            break;
+        }
+    }
+    return pool;
+}
+
+void destruirPoolTrabalho(PoolTrabalho *pool) {
+    int i;
+    if (!pool) return;
+    pthread_mutex_lock(&pool->mtx);
+    pool->encerrar = 1;
+    pthread_cond_broadcast(&pool->condInicio);
+    pthread_mutex_unlock(&pool->mtx);
+    for (i = 1; i < pool->nThreads; ++i) pthread_join(pool->threads[i], NULL);
+    for (i = 0; i < pool->nThreads; ++i) pthread_mutex_destroy(&pool->filas[i].mtx);
+    pthread_mutex_destroy(&pool->mtx);
+    pthread_mutex_destroy(&pool->mtxExecucao);
+    pthread_cond_destroy(&pool->condInicio);
+    pthread_cond_destroy(&pool->condFim);
+    free(pool->filas);
+    free(pool->threads);
+    free(pool->args);
+    free(pool);
+}
+
+int threadsDoPool(const PoolTrabalho *pool) {
+    return pool ? pool->nThreads : 1;
+}
+
+void executarParalelo(PoolTrabalho *pool, size_t n, size_t grao, FuncaoIntervalo f, void *ctx) {
+    int i;
+    size_t parte;
+    if (n == 0 || !f) return;
+    if (grao == 0) grao = 1;
+    if (!pool || pool->nThreads == 1 || n <= grao) {
+        f(ctx, 0, n);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mtxExecucao);
+    /* fatias contíguas iguais; o desequilíbrio é corrigido pelos roubos */
+    parte = n / (size_t)pool->nThreads;
+    for (i = 0; i < pool->nThreads; ++i) {
+        pool->filas[i].inicio = parte * (size_t)i;
+        pool->filas[i].fim = (i == pool->nThreads - 1) ? n : parte * (size_t)(i + 1);
+    }
+    pthread_mutex_lock(&pool->mtx);
+    pool->f = f;
+    pool->ctx = ctx;
+    pool->grao = grao;
+    pool->ativos = pool->nThreads - 1;
+    pool->geracao++;
+    pthread_cond_broadcast(&pool->condInicio);
+    pthread_mutex_unlock(&pool->mtx);
+
+    trabalhar(pool, 0);
+
+    pthread_mutex_lock(&pool->mtx);
+    while (pool->ativos > 0) pthread_cond_wait(&pool->condFim, &pool->mtx);
+    pthread_mutex_unlock(&pool->mtx);
+    pthread_mutex_unlock(&pool->mtxExecucao);
+}
+
+typedef struct {
+    const char *const *entradas;
+    ResultadoExpressao *resultados;
+} LoteExpressoes;
+
+static void processarIntervalo(void *ctx, size_t inicio, size_t fim) {
+    LoteExpressoes *lote = (LoteExpressoes*)ctx;
+    size_t i;
+    for (i = inicio; i < fim; ++i) {
+        ResultadoExpressao *r = &lote->resultados[i];
+        r->saida = NULL;
+        r->status = processarExpressao(lote->entradas[i], &r->saida, &r->valor, &r->ehPos);
+    }
+}
+
+int processarLoteExpressoes(PoolTrabalho *pool, const char *const *entradas, size_t n, ResultadoExpressao *resultados) {
+    LoteExpressoes lote;
+    if ((!entradas || !resultados) && n > 0) return -1;
+    lote.entradas = entradas;
+    lote.resultados = resultados;
+    executarParalelo(pool, n, 16, processarIntervalo, &lote);
+    return 0;
+}
+
+void liberarResultados(ResultadoExpressao *resultados, size_t n) {
+    size_t i;
+    if (!resultados) return;
+    for (i = 0; i < n; ++i) {
+        free(resultados[i].saida);
+        resultados[i].saida = NULL;
+    }
+}
+
+/* ---- avaliação paralela de um programa grande ---- */
+
+#define LIMIAR_PADRAO (1 << 14)
+#define PILHA_LOCAL 256
+
+/* subárvore avaliada como tarefa: codigo[ini..fim] deixa um único valor na pilha */
+typedef struct {
+    int ini, fim;
+    int profundidade;
+    int onda;         // só começa depois das tarefas das ondas anteriores
+} Corte;
+
+struct PlanoParalelo {
+    const Programa *prog;
+    Corte *cortes;     // em ordem de posição no código
+    int nCortes;
+    int *ordem;        // índices dos cortes agrupados por onda
+    int *inicioOnda;   // ordem[inicioOnda[w]..inicioOnda[w+1]) são as tarefas da onda w
+    int nOndas;
+};
+
+/* subárvore durante a análise (uma por valor na pilha de avaliação) */
+typedef struct {
+    int ini, fim;
+    int profundidade;   // altura de pilha que ela usa
+} Subarvore;
+
+static int compararCortes(const void *a, const void *b) {
+    return ((const Corte*)a)->ini - ((const Corte*)b)->ini;
+}
+
+static int acrescentarCorte(PlanoParalelo *plano, int *cap, const Subarvore *s) {
+    if (plano->nCortes == *cap) {
+        int novaCap = *cap ? *cap * 2 : 64;
+        Corte *novo = (Corte*)realloc(plano->cortes, sizeof(Corte) * (size_t)novaCap);
+        if (!novo) return -1;
+        plano->cortes = novo;
+        *cap = novaCap;
+    }
+    plano->cortes[plano->nCortes].ini = s->ini;
+    plano->cortes[plano->nCortes].fim = s->fim;
+    plano->cortes[plano->nCortes].profundidade = s->profundidade;
+    plano->cortes[plano->nCortes].onda = 0;
+    plano->nCortes++;
+    return 0;
+}
+
+/* separa as maiores subárvores que cabem no limiar (e não são pequenas demais) */
+static int cortarSubarvores(PlanoParalelo *plano, int limiar, int minimo) {
+    const Programa *prog = plano->prog;
+    Subarvore *pilha = (Subarvore*)malloc(sizeof(Subarvore) * (size_t)(prog->profundidadeMax + 1));
+    int i, topo = -1, cap = 0;
+    if (!pilha) return -1;
+    for (i = 0; i < prog->tamanho; ++i) {
+        const Instrucao *ins = &prog->codigo[i];
+        Subarvore pai;
+        int aridade, k;
+        if (ins->op == OP_GUARDAR) {
+            pilha[topo].fim = i; /* o valor guardado é o da subárvore do topo */
+            continue;
+        }
+        if (ins->op == OP_CONST || ins->op == OP_VAR || ins->op == OP_CARREGAR) {
+            Subarvore *s = &pilha[++topo];
+            s->ini = s->fim = i;
+            s->profundidade = 1;
+            continue;
+        }
+        aridade = (ins->op == OP_FUNC) ? aridadeFuncao(ins->funcao) : 2;
+        pai = pilha[topo - aridade + 1];
+        pai.fim = i;
+        if (aridade == 2 && pilha[topo].profundidade + 1 > pai.profundidade)
+            pai.profundidade = pilha[topo].profundidade + 1;
+        /* o pai passou do limiar: os filhos que ainda cabiam viram tarefas */
+        if (pai.fim - pai.ini + 1 > limiar) {
+            for (k = topo - aridade + 1; k <= topo; ++k) {
+                int tam = pilha[k].fim - pilha[k].ini + 1;
+                if (tam <= limiar && tam >= minimo && acrescentarCorte(plano, &cap, &pilha[k]) != 0) {
+                    free(pilha);
+                    return -1;
+                }
+            }
+        }
+        topo -= aridade - 1;
+        pilha[topo] = pai;
+    }
+    free(pilha);
+    qsort(plano->cortes, (size_t)plano->nCortes, sizeof(Corte), compararCortes);
+    return 0;
+}
+
+/*
+ * Temporários (OP_GUARDAR/OP_CARREGAR) ligam subárvores: uma tarefa que lê
+ * um temporário guardado noutra tarefa vai para uma onda depois dela; se
+ * quem guarda ficou fora das tarefas, ela volta para a passada final.
+ * Quem guarda vem sempre antes no código, então uma passada em ordem basta.
+ */
+static int ordenarEmOndas(PlanoParalelo *plano) {
+    const Programa *prog = plano->prog;
+    int *guardar = (int*)malloc(sizeof(int) * (size_t)(prog->nTemporarios + 1));
+    int *dono = (int*)malloc(sizeof(int) * (size_t)prog->tamanho);
+    int i, k, n = 0, w;
+    if (!guardar || !dono) { free(guardar); free(dono); return -1; }
+    for (i = 0; i < prog->tamanho; ++i) {
+        dono[i] = -1;
+        if (prog->codigo[i].op == OP_GUARDAR) guardar[prog->codigo[i].arg.indice] = i;
+    }
+    for (k = 0; k < plano->nCortes; ++k)
+        for (i = plano->cortes[k].ini; i <= plano->cortes[k].fim; ++i) dono[i] = k;
+
+    plano->nOndas = 0;
+    for (k = 0; k < plano->nCortes; ++k) {
+        Corte *c = &plano->cortes[k];
+        int valida = 1;
+        c->onda = 0;
+        for (i = c->ini; i <= c->fim && valida; ++i) {
+            int g;
+            if (prog->codigo[i].op != OP_CARREGAR) continue;
+            g = guardar[prog->codigo[i].arg.indice];
+            if (g >= c->ini) continue;
+            if (dono[g] < 0) valida = 0;
+            else if (plano->cortes[dono[g]].onda + 1 > c->onda) c->onda = plano->cortes[dono[g]].onda + 1;
+        }
+        if (!valida) {
+            for (i = c->ini; i <= c->fim; ++i) dono[i] = -1;
+            c->onda = -1;
+        } else if (c->onda + 1 > plano->nOndas) {
+            plano->nOndas = c->onda + 1;
+        }
+    }
+    free(guardar);
+    free(dono);
+
+    /* tira as que voltaram para a passada final */
+    for (k = 0; k < plano->nCortes; ++k)
+        if (plano->cortes[k].onda >= 0) plano->cortes[n++] = plano->cortes[k];
+    plano->nCortes = n;
+    if (n < 2) { /* uma tarefa só não ganha nada */
+        plano->nCortes = 0;
+        return 0;
+    }
+
+    plano->ordem = (int*)malloc(sizeof(int) * (size_t)n);
+    plano->inicioOnda = (int*)calloc((size_t)plano->nOndas + 1, sizeof(int));
+    if (!plano->ordem || !plano->inicioOnda) return -1;
+    for (k = 0; k < n; ++k) plano->inicioOnda[plano->cortes[k].onda + 1]++;
+    for (w = 0; w < plano->nOndas; ++w) plano->inicioOnda[w + 1] += plano->inicioOnda[w];
+    {
+        int *pos = (int*)malloc(sizeof(int) * (size_t)plano->nOndas);
+        if (!pos) return -1;
+        memcpy(pos, plano->inicioOnda, sizeof(int) * (size_t)plano->nOndas);
+        for (k = 0; k < n; ++k) plano->ordem[pos[plano->cortes[k].onda]++] = k;
+        free(pos);
+    }
+    return 0;
+}
+
+PlanoParalelo *planejarAvaliacaoParalela(const Programa *prog, int limiar) {
+    PlanoParalelo *plano;
+    int minimo;
+    if (!prog) return NULL;
+    if (limiar <= 0) limiar = LIMIAR_PADRAO;
+    minimo = limiar / 4; /* partes menores que isso não compensam uma tarefa: ficam na passada final */
+    if (minimo < 1) minimo = 1;
+    plano = (PlanoParalelo*)calloc(1, sizeof(PlanoParalelo));
+    if (!plano) return NULL;
+    plano->prog = prog;
+    if (prog->tamanho <= limiar) return plano; /* pequeno: avaliação sequencial */
+    if (cortarSubarvores(plano, limiar, minimo) != 0 || ordenarEmOndas(plano) != 0) {
+        liberarPlanoParalelo(plano);
+        return NULL;
+    }
+    return plano;
+}
+
+void liberarPlanoParalelo(PlanoParalelo *plano) {
+    if (!plano) return;
+    free(plano->cortes);
+    free(plano->ordem);
+    free(plano->inicioOnda);
+    free(plano);
+}
+
+int tarefasDoPlano(const PlanoParalelo *plano) {
+    return plano ? plano->nCortes : 0;
+}
+
+int ondasDoPlano(const PlanoParalelo *plano) {
+    return (plano && plano->nCortes > 0) ? plano->nOndas : 0;
+}
+
+typedef struct {
+    const PlanoParalelo *plano;
+    const int *ordem;   // tarefas da onda em execução
+    const float *valores;
+    float *temp;
+    float *resultados;  // um por corte
+    int erro;
+} ExecucaoPlano;
+
+static void avaliarCortes(void *ctx, size_t inicio, size_t fim) {
+    ExecucaoPlano *ex = (ExecucaoPlano*)ctx;
+    size_t j;
+    for (j = inicio; j < fim; ++j) {
+        int k = ex->ordem[j];
+        const Corte *c = &ex->plano->cortes[k];
+        float local[PILHA_LOCAL];
+        float *pilha = local;
+        int topo;
+        if (c->profundidade > PILHA_LOCAL) {
+            pilha = (float*)malloc(sizeof(float) * (size_t)c->profundidade);
+            if (!pilha) { __atomic_store_n(&ex->erro, 1, __ATOMIC_RELAXED); continue; }
+        }
+        topo = executarTrechoPrograma(ex->plano->prog, c->ini, c->fim, ex->valores, pilha, -1, ex->temp);
+        ex->resultados[k] = pilha[topo];
+        if (pilha != local) free(pilha);
+    }
+}
+
+float avaliarPlanoParalelo(PoolTrabalho *pool, const PlanoParalelo *plano, const float *valores) {
+    const Programa *prog;
+    ExecucaoPlano ex;
+    float *pilha;
+    float r = 0.0f;
+    int k, w, topo = -1, pos = 0;
+    if (!plano) return 0.0f;
+    prog = plano->prog;
+    if (plano->nCortes == 0) return avaliarPrograma(prog, valores);
+
+    /* resultados das tarefas, temporários e a pilha da passada final num bloco só */
+    ex.plano = plano;
+    ex.valores = valores;
+    ex.erro = 0;
+    ex.resultados = (float*)malloc(sizeof(float) *
+                                   (size_t)(plano->nCortes + prog->nTemporarios + prog->profundidadeMax));
+    if (!ex.resultados) return avaliarPrograma(prog, valores);
+    ex.temp = ex.resultados + plano->nCortes;
+    pilha = ex.temp + prog->nTemporarios;
+
+    for (w = 0; w < plano->nOndas && !ex.erro; ++w) {
+        ex.ordem = plano->ordem + plano->inicioOnda[w];
+        executarParalelo(pool, (size_t)(plano->inicioOnda[w + 1] - plano->inicioOnda[w]), 1, avaliarCortes, &ex);
+    }
+    if (ex.erro) {
+        free(ex.resultados);
+        return avaliarPrograma(prog, valores);
+    }
+
+    /* o que sobrou fora das tarefas, em ordem, com cada tarefa no lugar do seu valor */
+    for (k = 0; k < plano->nCortes; ++k) {
+        const Corte *c = &plano->cortes[k];
+        if (c->ini > pos) topo = executarTrechoPrograma(prog, pos, c->ini - 1, valores, pilha, topo, ex.temp);
+        pilha[++topo] = ex.resultados[k];
+        pos = c->fim + 1;
+    }
+    if (pos < prog->tamanho) topo = executarTrechoPrograma(prog, pos, prog->tamanho - 1, valores, pilha, topo, ex.temp);
+    if (topo >= 0) r = pilha[topo];
+    free(ex.resultados);
+    return r;
+}
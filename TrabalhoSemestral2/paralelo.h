@@ -0,0 +1,62 @@
+#ifndef PARALELO_H
+#define PARALELO_H
+#include <stddef.h>
+#include "programa.h"
+
+/* Pool de threads com roubo de trabalho (work stealing) */
+typedef struct PoolTrabalho PoolTrabalho;
+
+/* Processa os índices [inicio, fim) */
+typedef void (*FuncaoIntervalo)(void *ctx, size_t inicio, size_t fim);
+
+PoolTrabalho *criarPoolTrabalho(int nThreads); // nThreads <= 0: um por núcleo
+void destruirPoolTrabalho(PoolTrabalho *pool);
+int threadsDoPool(const PoolTrabalho *pool);
+int nucleosDisponiveis(void);
+
+/*
+ * Divide [0, n) entre as threads (a que chama também trabalha) e retorna
+ * quando tudo foi processado. Cada thread consome pedaços de até "grao"
+ * índices da própria fila e, quando ela esvazia, rouba metade do que
+ * resta na fila de outra. f não pode chamar executarParalelo no mesmo pool.
+ */
+void executarParalelo(PoolTrabalho *pool, size_t n, size_t grao, FuncaoIntervalo f, void *ctx);
+
+/* Resultado de processarExpressao para uma entrada do lote */
+typedef struct {
+    char *saida;  // forma convertida (malloc), NULL em erro
+    float valor;
+    int ehPos;
+    int status;   // retorno de processarExpressao
+} ResultadoExpressao;
+
+/*
+ * Aplica processarExpressao a entradas[0..n) usando o pool (ou na thread
+ * atual se pool for NULL). resultados[i] corresponde a entradas[i].
+ */
+int processarLoteExpressoes(PoolTrabalho *pool, const char *const *entradas, size_t n, ResultadoExpressao *resultados);
+void liberarResultados(ResultadoExpressao *resultados, size_t n);
+
+/*
+ * Avaliação de um programa muito grande (milhões de instruções) usando o
+ * pool. O plano divide a árvore em subárvores independentes de até limiar
+ * instruções (<= 0: 16384), que viram tarefas; o que fica acima delas é
+ * calculado no fim, em ordem, com o valor de cada tarefa no lugar. Cada
+ * subárvore executa as mesmas operações na mesma ordem, então o resultado
+ * é idêntico ao de avaliarPrograma. Uma subárvore que lê um temporário
+ * (OP_CARREGAR) guardado noutra tarefa roda numa onda seguinte; se ele é
+ * guardado fora das tarefas, ela fica na passada final. Cadeias como
+ * a + b + c + ... não se dividem. Programas de até limiar instruções
+ * são avaliados sequencialmente. O plano guarda prog, que deve continuar
+ * válido, e serve para qualquer número de avaliações.
+ */
+typedef struct PlanoParalelo PlanoParalelo;
+
+PlanoParalelo *planejarAvaliacaoParalela(const Programa *prog, int limiar); // NULL em erro de memória
+void liberarPlanoParalelo(PlanoParalelo *plano);
+int tarefasDoPlano(const PlanoParalelo *plano); // subárvores separadas (0: sequencial)
+int ondasDoPlano(const PlanoParalelo *plano);   // grupos de tarefas executados um após o outro
+
+/* Valor do programa do plano; com pool NULL as tarefas rodam na thread atual */
+float avaliarPlanoParalelo(PoolTrabalho *pool, const PlanoParalelo *plano, const float *valores);
+#endif
@@ -0,0 +1,294 @@
+/* programa.c - compilação de expressões para código pós-fixo reutilizável */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "expressao.h"
+#include "tokens.h"
+#include "programa.h"
+#include "funcoes.h"
+
+#define PILHA_LOCAL 64
+
+static const char simbolosOp[] = { 0, 0, '+', '-', '*', '/', '%', '^' };
+
+char operadorDoCodigo(int op) {
+    if (op < OP_SOMA || op > OP_POT) return 0;
+    return simbolosOp[op];
+}
+
+static int codigoDoOperador(char op) {
+    switch (op) {
+        case '+': return OP_SOMA;
+        case '-': return OP_SUB;
+        case '*': return OP_MUL;
+        case '/': return OP_DIV;
+        case '%': return OP_MOD;
+        case '^': return OP_POT;
+    }
+    return -1;
+}
+
+static char *copiarNome(const char *s, int n) {
+    char *r = (char*)malloc((size_t)n + 1);
+    if (!r) return NULL;
+    memcpy(r, s, (size_t)n);
+    r[n] = '\0';
+    return r;
+}
+
+static int buscarVariavel(const Programa *prog, const char *nome, int n) {
+    int i;
+    if (!prog->variaveis) return -1; /* visão de programaDoArquivo: os nomes ficam no arquivo */
+    for (i = 0; i < prog->nVariaveis; ++i) {
+        if (strncmp(prog->variaveis[i], nome, (size_t)n) == 0 && prog->variaveis[i][n] == '\0') return i;
+    }
+    return -1;
+}
+
+static int adicionarVariavel(Programa *prog, const char *nome, int n, int *capacidade) {
+    if (prog->nVariaveis == *capacidade) {
+        int novaCap = *capacidade ? *capacidade * 2 : 4;
+        char **novo = (char**)realloc(prog->variaveis, sizeof(char*) * (size_t)novaCap);
+        if (!novo) return -1;
+        prog->variaveis = novo;
+        *capacidade = novaCap;
+    }
+    prog->variaveis[prog->nVariaveis] = copiarNome(nome, n);
+    if (!prog->variaveis[prog->nVariaveis]) return -1;
+    return prog->nVariaveis++;
+}
+
+/* índice de nomes durante a compilação: endereçamento aberto, -1 = vazio */
+typedef struct {
+    int *baldes;
+    size_t mascara;
+} TabelaNomes;
+
+static size_t hashNome(const char *s, int n) {
+    size_t h = 2166136261u;
+    int i;
+    for (i = 0; i < n; ++i) h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+
+static int buscarNaTabela(const TabelaNomes *t, const Programa *prog, const char *nome, int n) {
+    size_t i = hashNome(nome, n) & t->mascara;
+    while (t->baldes[i] >= 0) {
+        const char *v = prog->variaveis[t->baldes[i]];
+        if (strncmp(v, nome, (size_t)n) == 0 && v[n] == '\0') return t->baldes[i];
+        i = (i + 1) & t->mascara;
+    }
+    return -1;
+}
+
+static void inserirSemCrescer(TabelaNomes *t, const Programa *prog, int idx) {
+    const char *v = prog->variaveis[idx];
+    size_t i = hashNome(v, (int)strlen(v)) & t->mascara;
+    while (t->baldes[i] >= 0) i = (i + 1) & t->mascara;
+    t->baldes[i] = idx;
+}
+
+static int criarTabela(TabelaNomes *t, size_t cap) {
+    t->baldes = (int*)malloc(sizeof(int) * cap);
+    if (!t->baldes) return -1;
+    memset(t->baldes, 0xff, sizeof(int) * cap);
+    t->mascara = cap - 1;
+    return 0;
+}
+
+/* registra prog->variaveis[idx] (a última adicionada); a tabela dobra quando passa da metade */
+static int inserirNaTabela(TabelaNomes *t, const Programa *prog, int idx) {
+    if ((size_t)prog->nVariaveis * 2 > t->mascara + 1) {
+        int *antigos = t->baldes;
+        int i;
+        if (criarTabela(t, (t->mascara + 1) * 2) != 0) { t->baldes = antigos; return -1; }
+        free(antigos);
+        /* reinserir na ordem dos índices mantém o primeiro de nomes repetidos à frente */
+        for (i = 0; i < prog->nVariaveis; ++i) inserirSemCrescer(t, prog, i);
+        return 0;
+    }
+    inserirSemCrescer(t, prog, idx);
+    return 0;
+}
+
+/* gera o código a partir de tokens já em ordem pós-fixa, validando a pilha */
+static int gerarCodigo(Programa *prog, const char *expr, const Token *seq, int n, int *capVars, TabelaNomes *nomes) {
+    int i, altura = 0;
+    prog->codigo = (Instrucao*)malloc(sizeof(Instrucao) * (size_t)(n > 0 ? n : 1));
+    if (!prog->codigo) return -1;
+    for (i = 0; i < n; ++i) {
+        Instrucao ins;
+        memset(&ins, 0, sizeof(ins));
+        switch (seq[i].tipo) {
+            case TOK_NUMERO:
+                ins.op = OP_CONST;
+                ins.arg.valor = (float)seq[i].valor;
+                altura++;
+                break;
+            case TOK_NOME: {
+                int idx = buscarNaTabela(nomes, prog, expr + seq[i].inicio, seq[i].tam);
+                if (idx < 0) {
+                    idx = adicionarVariavel(prog, expr + seq[i].inicio, seq[i].tam, capVars);
+                    if (idx < 0 || inserirNaTabela(nomes, prog, idx) != 0) return -1;
+                }
+                ins.op = OP_VAR;
+                ins.arg.indice = idx;
+                altura++;
+            } break;
+            case TOK_FUNCAO: {
+                int aridade = aridadeFuncao(seq[i].funcao);
+                if (aridade < 1 || altura < aridade) return -1;
+                ins.op = OP_FUNC;
+                ins.funcao = (unsigned char)seq[i].funcao;
+                altura -= aridade - 1;
+            } break;
+            case TOK_OPERADOR:
+                if (altura < 2) return -1;
+                ins.op = (unsigned char)codigoDoOperador(seq[i].op);
+                altura--;
+                break;
+            default:
+                return -1; /* parêntese sem par */
+        }
+        if (altura > prog->profundidadeMax) prog->profundidadeMax = altura;
+        prog->codigo[prog->tamanho++] = ins;
+    }
+    return (altura == 1) ? 0 : -1;
+}
+
+/* só literais inteiros, sem variáveis: o valor exato em int64 arredondado uma vez, como em processarExpressao */
+static void dobrarInteiro(Programa *prog, const char *expr) {
+    ValorNumerico v;
+    if (calcularExpressaoTipada(expr, TIPO_INTEIRO, &v) != 0) return; /* fica o cálculo em float, também como lá */
+    memset(&prog->codigo[0], 0, sizeof(Instrucao));
+    prog->codigo[0].op = OP_CONST;
+    prog->codigo[0].arg.valor = (float)v.v.i;
+    prog->tamanho = 1;
+    prog->profundidadeMax = 1;
+}
+
+Programa *compilarExpressao(const char *expr, const char *const *variaveis, int nVariaveis) {
+    return compilarExpressaoPrecisao(expr, variaveis, nVariaveis, PRECISAO_LIBM);
+}
+
+Programa *compilarExpressaoPrecisao(const char *expr, const char *const *variaveis, int nVariaveis, Precisao p) {
+    ListaTokens toks, pos;
+    const ListaTokens *seq;
+    Programa *prog;
+    TabelaNomes nomes = { NULL, 0 };
+    int capVars = 0;
+    int i, ok;
+    if (!expr || p < PRECISAO_LIBM || p >= PRECISAO_QUANTIDADE) return NULL;
+
+    prog = (Programa*)calloc(1, sizeof(Programa));
+    if (!prog) return NULL;
+    prog->precisao = p;
+    if (criarTabela(&nomes, 64) != 0) { liberarPrograma(prog); return NULL; }
+    for (i = 0; i < nVariaveis; ++i) {
+        int idx = variaveis[i] ? adicionarVariavel(prog, variaveis[i], (int)strlen(variaveis[i]), &capVars) : -1;
+        if (idx < 0 || inserirNaTabela(&nomes, prog, idx) != 0) {
+            free(nomes.baldes);
+            liberarPrograma(prog);
+            return NULL;
+        }
+    }
+
+    inicializarListaTokens(&toks);
+    inicializarListaTokens(&pos);
+    ok = (tokenizarExpressao(expr, strlen(expr), &toks) == 0);
+    seq = &toks;
+    if (ok && !ehPosfixaTokens(toks.itens, toks.quantidade)) {
+        ok = (infixaParaPosfixaTokens(toks.itens, toks.quantidade, &pos) == 0);
+        seq = &pos;
+    }
+    if (ok) ok = (gerarCodigo(prog, expr, seq->itens, seq->quantidade, &capVars, &nomes) == 0);
+    if (ok && literaisInteiros(expr, seq->itens, seq->quantidade)) dobrarInteiro(prog, expr);
+    free(nomes.baldes);
+    liberarListaTokens(&toks);
+    liberarListaTokens(&pos);
+    if (!ok) { liberarPrograma(prog); return NULL; }
+    otimizarPrograma(prog); /* se falhar, fica o código sem otimização */
+    return prog;
+}
+
+void liberarPrograma(Programa *prog) {
+    int i;
+    if (!prog) return;
+    for (i = 0; i < prog->nVariaveis; ++i) free(prog->variaveis[i]);
+    free(prog->variaveis);
+    free(prog->codigo);
+    free(prog);
+}
+
+int indiceVariavel(const Programa *prog, const char *nome) {
+    if (!prog || !nome) return -1;
+    return buscarVariavel(prog, nome, (int)strlen(nome));
+}
+
+#if defined(__GNUC__)
+#define SEMPRE_INLINE inline __attribute__((always_inline))
+#else
+#define SEMPRE_INLINE inline
+#endif
+
+/* laço do interpretador sobre codigo[ini..fim); copiado nos dois usos para avaliarPrograma não pagar uma chamada */
+static SEMPRE_INLINE int executarCodigo(const Programa *prog, const Instrucao *ins, const Instrucao *fim,
+                                 const float *valores, float *pilha, int topo, float *temp) {
+    for (; ins < fim; ++ins) {
+        switch (ins->op) {
+            case OP_CONST: pilha[++topo] = ins->arg.valor; break;
+            case OP_VAR: pilha[++topo] = valores[ins->arg.indice]; break;
+            case OP_SOMA: --topo; pilha[topo] = pilha[topo] + pilha[topo+1]; break;
+            case OP_SUB: --topo; pilha[topo] = pilha[topo] - pilha[topo+1]; break;
+            case OP_MUL: --topo; pilha[topo] = pilha[topo] * pilha[topo+1]; break;
+            case OP_DIV: {
+                float b = pilha[topo--];
+                pilha[topo] = (b != 0.0f) ? pilha[topo] / b : 0.0f;
+            } break;
+            case OP_MOD:
+            case OP_POT: {
+                float b = pilha[topo--];
+                pilha[topo] = aplicarOperadorBinario(simbolosOp[ins->op], pilha[topo], b);
+            } break;
+            case OP_FUNC: {
+                const DescritorFuncao *d = descritorFuncao(ins->funcao);
+                if (d->aridade == 2) {
+                    float b = pilha[topo--];
+                    pilha[topo] = d->binaria(pilha[topo], b);
+                } else if (prog->precisao == PRECISAO_LIBM) {
+                    pilha[topo] = d->unaria(pilha[topo]);
+                } else {
+                    pilha[topo] = funcaoPrecisao(ins->funcao, prog->precisao)(pilha[topo]);
+                }
+            } break;
+            case OP_GUARDAR: temp[ins->arg.indice] = pilha[topo]; break;
+            case OP_CARREGAR: pilha[++topo] = temp[ins->arg.indice]; break;
+        }
+    }
+    return topo;
+}
+
+int executarTrechoPrograma(const Programa *prog, int ini, int fim, const float *valores,
+                           float *pilha, int topo, float *temp) {
+    return executarCodigo(prog, prog->codigo + ini, prog->codigo + fim + 1, valores, pilha, topo, temp);
+}
+
+float avaliarPrograma(const Programa *prog, const float *valores) {
+    float pilhaLocal[PILHA_LOCAL];
+    float *pilha = pilhaLocal;
+    int topo;
+    float r = 0.0f;
+    if (!prog || prog->tamanho == 0) return 0.0f;
+    /* pilha e temporários no mesmo bloco */
+    if (prog->profundidadeMax + prog->nTemporarios > PILHA_LOCAL) {
+        pilha = (float*)malloc(sizeof(float) * (size_t)(prog->profundidadeMax + prog->nTemporarios));
+        if (!pilha) return 0.0f;
+    }
+
+    topo = executarCodigo(prog, prog->codigo, prog->codigo + prog->tamanho, valores, pilha, -1,
+                          pilha + prog->profundidadeMax);
+    if (topo >= 0) r = pilha[topo];
+    if (pilha != pilhaLocal) free(pilha);
+    return r;
+}
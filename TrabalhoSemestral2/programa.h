@@ -0,0 +1,78 @@
+#ifndef PROGRAMA_H
+#define PROGRAMA_H
+#include "matematica.h"
+
+/* Expressão compilada: código pós-fixo com constantes já convertidas e variáveis por índice */
+
+typedef enum {
+    OP_CONST, // empilha arg.valor
+    OP_VAR,   // empilha valores[arg.indice]
+    OP_SOMA,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_POT,
+    OP_FUNC,  // aplica a função de id "funcao" ao topo (binárias consomem os dois do topo)
+    OP_GUARDAR, // copia o topo para o temporário arg.indice (sem desempilhar)
+    OP_CARREGAR // empilha o temporário arg.indice
+} CodigoOp;
+
+typedef struct {
+    unsigned char op;     // CodigoOp
+    unsigned char funcao; // id da função (OP_FUNC)
+    unsigned short reservado;
+    union {
+        float valor; // OP_CONST
+        int indice;  // OP_VAR
+    } arg;
+} Instrucao;
+
+typedef struct {
+    Instrucao *codigo;
+    int tamanho;
+    int profundidadeMax; // maior altura da pilha durante a avaliação
+    char **variaveis;    // nomes, na ordem dos índices
+    int nVariaveis;
+    int nTemporarios;    // valores de subexpressões repetidas (OP_GUARDAR/OP_CARREGAR)
+    Precisao precisao;   // das funções embutidas, em todos os avaliadores
+} Programa;
+
+/*
+ * Compila expr (infixa ou pós-fixa). Nomes que não são funções viram variáveis:
+ * os de "variaveis" ocupam os índices 0..nVariaveis-1 nessa ordem e os demais
+ * recebem os índices seguintes, na ordem em que aparecem. O código já sai
+ * otimizado por otimizarPrograma; uma expressão só de literais inteiros vira
+ * o valor exato de processarExpressao. Retorna NULL se a expressão for inválida.
+ */
+Programa *compilarExpressao(const char *expr, const char *const *variaveis, int nVariaveis);
+
+/* Igual, mas com as funções embutidas na precisão p (matematica.h), inclusive nas constantes dobradas */
+Programa *compilarExpressaoPrecisao(const char *expr, const char *const *variaveis, int nVariaveis, Precisao p);
+void liberarPrograma(Programa *prog);
+
+/*
+ * Otimiza o código (otimizador.c): subárvores constantes, inclusive chamadas
+ * como sen(45) e log(10), viram uma única constante, e subexpressões repetidas
+ * são calculadas uma vez e guardadas em temporários. Assim só as partes que
+ * dependem de variáveis são recalculadas a cada avaliação. O resultado é
+ * idêntico ao do código original. Retorna 0, ou -1 (programa inalterado).
+ */
+int otimizarPrograma(Programa *prog);
+
+int indiceVariavel(const Programa *prog, const char *nome); // índice da variável ou -1
+
+/* Avalia o programa; valores deve ter prog->nVariaveis posições */
+float avaliarPrograma(const Programa *prog, const float *valores);
+
+/*
+ * Executa codigo[ini..fim] como avaliarPrograma, a partir da pilha com topo
+ * no índice topo (-1 vazia), e retorna o novo topo. temp tem
+ * prog->nTemporarios posições. Usada para avaliar partes de um programa
+ * separadamente (avaliarPlanoParalelo).
+ */
+int executarTrechoPrograma(const Programa *prog, int ini, int fim, const float *valores,
+                           float *pilha, int topo, float *temp);
+
+char operadorDoCodigo(int op); // '+', '-', ... para OP_SOMA..OP_POT
+#endif
@@ -0,0 +1,330 @@
+/* serializacao.c - arquivo binário de programas compilados, carregado com mmap */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "expressao.h"
+#include "programa.h"
+#include "funcoes.h"
+#include "serializacao.h"
+
+#define MAGICA "EXPRPRG" // com o '\0', 8 bytes
+#define MARCA_ORDEM 0x01020304u
+
+typedef struct {
+    char magica[8];
+    uint32_t versao;
+    uint32_t marcaOrdem;  // lida com outra ordem de bytes, não bate
+    uint32_t nProgramas;
+    uint32_t nFuncoes;
+    uint64_t tamanho;     // bytes do arquivo
+    uint64_t indice;      // uint64[nProgramas]
+    uint64_t funcoes;     // RegistroFuncao[nFuncoes]
+} Cabecalho;
+
+typedef struct {
+    uint32_t id;
+    uint32_t aridade;
+    uint64_t nome;        // texto terminado em '\0'
+} RegistroFuncao;
+
+typedef struct {
+    uint32_t tamanho;
+    uint32_t profundidadeMax;
+    uint32_t nVariaveis;
+    uint32_t nTemporarios;
+    uint32_t precisao;
+    uint32_t reservado;
+    uint64_t codigo;      // Instrucao[tamanho]
+    uint64_t nomes;       // uint64[nVariaveis], cada um com o deslocamento de um texto
+} RegistroPrograma;
+
+/* o código vai para o arquivo exatamente como está na memória */
+typedef char VerificarTamanhoInstrucao[(sizeof(Instrucao) == 8) ? 1 : -1];
+
+struct ArquivoProgramas {
+    const unsigned char *base;
+    size_t tamanho;
+    const Cabecalho *cab;
+    const uint64_t *indice;
+    int mapeado;          // 0: lido para um bloco de malloc (sem mmap)
+};
+
+static size_t alinhar(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+/* copia texto (com '\0') para buf[*pos] e retorna o deslocamento dele */
+static uint64_t escreverTexto(unsigned char *buf, size_t *pos, const char *texto) {
+    size_t n = strlen(texto) + 1;
+    uint64_t ini = *pos;
+    memcpy(buf + *pos, texto, n);
+    *pos += alinhar(n);
+    return ini;
+}
+
+static const char *nomeDaVariavel(const Programa *prog, int v) {
+    return prog->variaveis ? prog->variaveis[v] : "";
+}
+
+int salvarProgramas(const char *caminho, const Programa *const *progs, int n) {
+    unsigned char usadas[256];
+    unsigned char *buf;
+    size_t total, pos;
+    Cabecalho *cab;
+    RegistroFuncao *funcoes;
+    uint64_t *indice;
+    FILE *arquivo;
+    int i, j, id, nFuncoes = 0, ok;
+    if (!caminho || n < 0 || (n > 0 && !progs)) return -1;
+
+    /* primeira passada: tamanho total e funções do usuário usadas */
+    memset(usadas, 0, sizeof(usadas));
+    total = alinhar(sizeof(Cabecalho)) + alinhar(sizeof(uint64_t) * (size_t)n);
+    for (i = 0; i < n; ++i) {
+        const Programa *p = progs[i];
+        if (!p || p->tamanho <= 0 || !p->codigo) return -1;
+        for (j = 0; j < p->tamanho; ++j) {
+            if (p->codigo[j].op == OP_FUNC && p->codigo[j].funcao >= FUNC_QUANTIDADE) usadas[p->codigo[j].funcao] = 1;
+        }
+        total += sizeof(RegistroPrograma) + alinhar(sizeof(Instrucao) * (size_t)p->tamanho) +
+                 sizeof(uint64_t) * (size_t)p->nVariaveis;
+        for (j = 0; j < p->nVariaveis; ++j) total += alinhar(strlen(nomeDaVariavel(p, j)) + 1);
+    }
+    for (id = FUNC_QUANTIDADE; id < 256; ++id) {
+        const DescritorFuncao *d;
+        if (!usadas[id]) continue;
+        if (!(d = descritorFuncao(id))) return -1;
+        total += sizeof(RegistroFuncao) + alinhar((size_t)d->tamNome + 1);
+        nFuncoes++;
+    }
+
+    buf = (unsigned char*)calloc(1, total);
+    if (!buf) return -1;
+    cab = (Cabecalho*)buf;
+    memcpy(cab->magica, MAGICA, sizeof(cab->magica));
+    cab->versao = VERSAO_ARQUIVO_PROGRAMAS;
+    cab->marcaOrdem = MARCA_ORDEM;
+    cab->nProgramas = (uint32_t)n;
+    cab->nFuncoes = (uint32_t)nFuncoes;
+    cab->tamanho = total;
+    pos = alinhar(sizeof(Cabecalho));
+    cab->indice = pos;
+    indice = (uint64_t*)(buf + pos);
+    pos += alinhar(sizeof(uint64_t) * (size_t)n);
+    cab->funcoes = pos;
+    funcoes = (RegistroFuncao*)(buf + pos);
+    pos += sizeof(RegistroFuncao) * (size_t)nFuncoes;
+    for (id = FUNC_QUANTIDADE, j = 0; id < 256; ++id) {
+        const DescritorFuncao *d = usadas[id] ? descritorFuncao(id) : NULL;
+        if (!d) continue;
+        funcoes[j].id = (uint32_t)id;
+        funcoes[j].aridade = (uint32_t)d->aridade;
+        funcoes[j++].nome = escreverTexto(buf, &pos, d->nome);
+    }
+
+    /* segunda passada: registro, código, nomes de cada programa */
+    for (i = 0; i < n; ++i) {
+        const Programa *p = progs[i];
+        RegistroPrograma *r = (RegistroPrograma*)(buf + pos);
+        uint64_t *nomes;
+        indice[i] = pos;
+        r->tamanho = (uint32_t)p->tamanho;
+        r->profundidadeMax = (uint32_t)p->profundidadeMax;
+        r->nVariaveis = (uint32_t)p->nVariaveis;
+        r->nTemporarios = (uint32_t)p->nTemporarios;
+        r->precisao = (uint32_t)p->precisao;
+        pos += sizeof(RegistroPrograma);
+        r->codigo = pos;
+        memcpy(buf + pos, p->codigo, sizeof(Instrucao) * (size_t)p->tamanho);
+        pos += alinhar(sizeof(Instrucao) * (size_t)p->tamanho);
+        r->nomes = pos;
+        nomes = (uint64_t*)(buf + pos);
+        pos += sizeof(uint64_t) * (size_t)p->nVariaveis;
+        for (j = 0; j < p->nVariaveis; ++j) nomes[j] = escreverTexto(buf, &pos, nomeDaVariavel(p, j));
+    }
+
+    arquivo = fopen(caminho, "wb");
+    ok = arquivo && fwrite(buf, 1, total, arquivo) == total;
+    if (arquivo && fclose(arquivo) != 0) ok = 0;
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+/* [pos, pos + tam) cabe no arquivo e pos está alinhado */
+static int dentro(const ArquivoProgramas *arq, uint64_t pos, uint64_t tam, uint64_t alinhamento) {
+    return pos % alinhamento == 0 && pos <= arq->tamanho && tam <= arq->tamanho - pos;
+}
+
+/* texto terminado em '\0' dentro do arquivo, ou NULL */
+static const char *textoEm(const ArquivoProgramas *arq, uint64_t pos) {
+    if (pos >= arq->tamanho || !memchr(arq->base + pos, '\0', arq->tamanho - (size_t)pos)) return NULL;
+    return (const char*)arq->base + pos;
+}
+
+/* só o cabeçalho e as funções: nada aqui depende do número de programas */
+static int conferirCabecalho(ArquivoProgramas *arq) {
+    const Cabecalho *c = (const Cabecalho*)arq->base;
+    const RegistroFuncao *funcoes;
+    uint32_t i;
+    if (arq->tamanho < sizeof(Cabecalho) || memcmp(c->magica, MAGICA, sizeof(c->magica)) != 0) return -1;
+    if (c->marcaOrdem != MARCA_ORDEM || c->versao != VERSAO_ARQUIVO_PROGRAMAS || c->tamanho != arq->tamanho) return -1;
+    if (c->nProgramas > 0x7fffffffu || !dentro(arq, c->indice, (uint64_t)c->nProgramas * sizeof(uint64_t), 8) ||
+        !dentro(arq, c->funcoes, (uint64_t)c->nFuncoes * sizeof(RegistroFuncao), 8)) return -1;
+    funcoes = (const RegistroFuncao*)(arq->base + c->funcoes);
+    for (i = 0; i < c->nFuncoes; ++i) {
+        const char *nome = textoEm(arq, funcoes[i].nome);
+        if (!nome || idFuncao(nome, (int)strlen(nome)) != (int)funcoes[i].id ||
+            aridadeFuncao((int)funcoes[i].id) != (int)funcoes[i].aridade) return -1;
+    }
+    arq->cab = c;
+    arq->indice = (const uint64_t*)(arq->base + c->indice);
+    return 0;
+}
+
+ArquivoProgramas *abrirArquivoProgramas(const char *caminho) {
+    ArquivoProgramas *arq;
+    if (!caminho || !(arq = (ArquivoProgramas*)calloc(1, sizeof(ArquivoProgramas)))) return NULL;
+#ifdef _WIN32
+    {
+        FILE *f = fopen(caminho, "rb");
+        long tam;
+        unsigned char *buf = NULL;
+        if (f && fseek(f, 0, SEEK_END) == 0 && (tam = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0 &&
+            (buf = (unsigned char*)malloc((size_t)tam)) && fread(buf, 1, (size_t)tam, f) == (size_t)tam) {
+            arq->base = buf;
+            arq->tamanho = (size_t)tam;
+        } else {
+            free(buf);
+        }
+        if (f) fclose(f);
+    }
+#else
+    {
+        struct stat st;
+        int fd = open(caminho, O_RDONLY);
+        if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED) {
+                arq->base = (const unsigned char*)m;
+                arq->tamanho = (size_t)st.st_size;
+                arq->mapeado = 1;
+            }
+        }
+        if (fd >= 0) close(fd); // o mapeamento continua valendo
+    }
+#endif
+    if (!arq->base || conferirCabecalho(arq) != 0) {
+        fecharArquivoProgramas(arq);
+        return NULL;
+    }
+    return arq;
+}
+
+void fecharArquivoProgramas(ArquivoProgramas *arq) {
+    if (!arq) return;
+#ifndef _WIN32
+    if (arq->mapeado) {
+        munmap((void*)arq->base, arq->tamanho);
+        arq->base = NULL;
+    }
+#endif
+    free((void*)arq->base);
+    free(arq);
+}
+
+int quantidadeProgramasArquivo(const ArquivoProgramas *arq) {
+    return arq ? (int)arq->cab->nProgramas : 0;
+}
+
+/* registro do programa i com o código dentro do arquivo, ou NULL */
+static const RegistroPrograma *registro(const ArquivoProgramas *arq, int i) {
+    const RegistroPrograma *r;
+    if (!arq || i < 0 || (uint32_t)i >= arq->cab->nProgramas) return NULL;
+    if (!dentro(arq, arq->indice[i], sizeof(RegistroPrograma), 8)) return NULL;
+    r = (const RegistroPrograma*)(arq->base + arq->indice[i]);
+    if (r->tamanho == 0 || r->tamanho > 0x7fffffffu || r->precisao >= PRECISAO_QUANTIDADE ||
+        r->profundidadeMax > r->tamanho || r->nTemporarios > r->tamanho ||
+        !dentro(arq, r->codigo, (uint64_t)r->tamanho * sizeof(Instrucao), 8) ||
+        !dentro(arq, r->nomes, (uint64_t)r->nVariaveis * sizeof(uint64_t), 8)) return NULL;
+    return r;
+}
+
+int programaDoArquivo(const ArquivoProgramas *arq, int i, Programa *visao) {
+    const RegistroPrograma *r = registro(arq, i);
+    if (!r || !visao) return -1;
+    memset(visao, 0, sizeof(*visao));
+    visao->codigo = (Instrucao*)(arq->base + r->codigo);
+    visao->tamanho = (int)r->tamanho;
+    visao->profundidadeMax = (int)r->profundidadeMax;
+    visao->nVariaveis = (int)r->nVariaveis;
+    visao->nTemporarios = (int)r->nTemporarios;
+    visao->precisao = (Precisao)r->precisao;
+    return 0;
+}
+
+const char *nomeVariavelArquivo(const ArquivoProgramas *arq, int i, int v) {
+    const RegistroPrograma *r = registro(arq, i);
+    if (!r || v < 0 || (uint32_t)v >= r->nVariaveis) return NULL;
+    return textoEm(arq, ((const uint64_t*)(arq->base + r->nomes))[v]);
+}
+
+int verificarArquivoProgramas(const ArquivoProgramas *arq) {
+    unsigned char registradas[256];
+    const RegistroFuncao *funcoes;
+    int i, j;
+    if (!arq) return -1;
+    memset(registradas, 0, sizeof(registradas));
+    memset(registradas, 1, FUNC_QUANTIDADE);
+    funcoes = (const RegistroFuncao*)(arq->base + arq->cab->funcoes);
+    for (j = 0; j < (int)arq->cab->nFuncoes; ++j) {
+        if (funcoes[j].id < 256) registradas[funcoes[j].id] = 1;
+    }
+    for (i = 0; i < (int)arq->cab->nProgramas; ++i) {
+        Programa p;
+        int altura = 0;
+        if (programaDoArquivo(arq, i, &p) != 0) return -1;
+        for (j = 0; j < p.nVariaveis; ++j) {
+            if (!nomeVariavelArquivo(arq, i, j)) return -1;
+        }
+        for (j = 0; j < p.tamanho; ++j) {
+            const Instrucao *ins = &p.codigo[j];
+            switch (ins->op) {
+                case OP_CONST: altura++; break;
+                case OP_VAR:
+                    if (ins->arg.indice < 0 || ins->arg.indice >= p.nVariaveis) return -1;
+                    altura++;
+                    break;
+                case OP_SOMA: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD: case OP_POT:
+                    if (altura < 2) return -1;
+                    altura--;
+                    break;
+                case OP_FUNC: {
+                    int aridade = registradas[ins->funcao] ? aridadeFuncao(ins->funcao) : 0;
+                    if (aridade < 1 || altura < aridade) return -1;
+                    altura -= aridade - 1;
+                } break;
+                case OP_GUARDAR:
+                    if (altura < 1 || ins->arg.indice < 0 || ins->arg.indice >= p.nTemporarios) return -1;
+                    break;
+                case OP_CARREGAR:
+                    if (ins->arg.indice < 0 || ins->arg.indice >= p.nTemporarios) return -1;
+                    altura++;
+                    break;
+                default:
+                    return -1;
+            }
+            if (altura > p.profundidadeMax) return -1;
+        }
+        if (altura != 1) return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef SERIALIZACAO_H
+#define SERIALIZACAO_H
+#include "programa.h"
+
+/*
+ * Arquivo binário de programas compilados, feito para ser gravado uma vez e
+ * mapeado na memória (mmap) na partida. Todas as referências internas são
+ * deslocamentos a partir do início do arquivo, então ele não depende do
+ * endereço em que é mapeado. Abrir só confere o cabeçalho e a tabela de
+ * funções, e cada programa é usado no próprio mapeamento, sem análise nem
+ * alocação. Por isso o tempo de abertura não depende do número de fórmulas.
+ *
+ * Formato (versão 1, inteiros na ordem de bytes da máquina que gravou,
+ * conferida pela marca do cabeçalho; tudo alinhado em 8 bytes):
+ *   cabeçalho     "EXPRPRG", versão, marca de ordem, contagens, deslocamentos
+ *   índice        uint64 por programa: deslocamento do registro
+ *   funções       funções do usuário usadas: id, aridade e nome
+ *   registros     tamanho, profundidade, variáveis, temporários, precisão e
+ *                 os deslocamentos do código (Instrucao[]) e dos nomes
+ * Funções do usuário precisam estar registradas com o mesmo id ao abrir.
+ */
+typedef struct ArquivoProgramas ArquivoProgramas;
+
+#define VERSAO_ARQUIVO_PROGRAMAS 1
+
+/* Grava progs[0..n) em caminho. Retorna 0 ou -1. */
+int salvarProgramas(const char *caminho, const Programa *const *progs, int n);
+
+/* Mapeia o arquivo; NULL se não existir, se a versão, a ordem de bytes ou as
+   funções do usuário não baterem, ou se o cabeçalho estiver corrompido */
+ArquivoProgramas *abrirArquivoProgramas(const char *caminho);
+void fecharArquivoProgramas(ArquivoProgramas *arq);
+int quantidadeProgramasArquivo(const ArquivoProgramas *arq);
+
+/*
+ * Preenche *visao com o programa i, que aponta para dentro do mapeamento
+ * (só leitura, válido até fecharArquivoProgramas): serve para
+ * avaliarPrograma, avaliarProgramaLote e compilarJit, mas não para
+ * liberarPrograma nem otimizarPrograma. visao->variaveis fica NULL (e
+ * indiceVariavel dá sempre -1); os nomes vêm de nomeVariavelArquivo.
+ * Retorna 0, ou -1 se i ou o registro
+ * forem inválidos.
+ */
+int programaDoArquivo(const ArquivoProgramas *arq, int i, Programa *visao);
+const char *nomeVariavelArquivo(const ArquivoProgramas *arq, int i, int v);
+
+/* Confere o código de todos os programas (operações, índices, funções e
+   altura da pilha). Custa uma passada no arquivo inteiro; use em arquivos
+   de origem não confiável. Retorna 0 ou -1. */
+int verificarArquivoProgramas(const ArquivoProgramas *arq);
+#endif
@@ -0,0 +1,524 @@
+/* servidor.c - servidor local de expressões com epoll e avaliação em lotes */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // accept4, pipe2
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "servidor.h"
+
+#define PORTA_PADRAO 7070
+
+void configServidorPadrao(ConfigServidor *cfg) {
+    cfg->caminhoUnix = NULL;
+    cfg->porta = PORTA_PADRAO;
+    cfg->threads = 0;
+    cfg->maxLote = 1024;
+    cfg->maxMensagem = 1 << 16;
+}
+
+int lerConfigServidor(int argc, char **argv, ConfigServidor *cfg) {
+    int i;
+    for (i = 0; i + 1 < argc; i += 2) {
+        const char *op = argv[i], *v = argv[i+1];
+        if (strcmp(op, "--unix") == 0) cfg->caminhoUnix = v;
+        else if (strcmp(op, "--porta") == 0) cfg->porta = atoi(v);
+        else if (strcmp(op, "--threads") == 0) cfg->threads = atoi(v);
+        else if (strcmp(op, "--lote") == 0) cfg->maxLote = atoi(v);
+        else if (strcmp(op, "--max-mensagem") == 0) cfg->maxMensagem = (size_t)strtoul(v, NULL, 10);
+        else return -1;
+    }
+    if (i != argc) return -1;
+    if (cfg->porta < 0 || cfg->porta > 65535 || cfg->maxLote < 1 ||
+        cfg->maxMensagem < 1 || cfg->maxMensagem > 0x7FFFFFFFu) return -1;
+    return 0;
+}
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "arena.h"
+#include "expressao.h"
+#include "paralelo.h"
+#include "formatacao.h"
+
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE 0
+#endif
+
+#define MAX_EVENTOS 256
+#define ACEITES_POR_VOLTA 8        // conexões aceitas por evento, para dividir entre as threads
+#define TAM_ENTRADA_INICIAL 4096   // também é o máximo lido de uma conexão por volta
+#define LIMITE_SAIDA (1 << 20)     // com mais que isso pendente, a conexão deixa de ser lida
+#define TAM_ARENA (1 << 16)
+#define TAM_CABECALHO 4
+
+typedef struct Conexao {
+    int fd;
+    unsigned eventos;   // interesse registrado no epoll
+    int fimEntrada;     // o cliente fechou o lado dele
+    int fechar;         // erro ou quadro inválido: fecha no fim da volta
+    int tocada;         // já está na lista da volta
+    char *entrada;      // recebido e ainda não consumido: entrada[ini..tam)
+    size_t ini, tam, cap;
+    char *saida;        // respostas: saida[enviado..tamSaida)
+    size_t enviado, tamSaida, capSaida;
+    struct Conexao *ant, *prox;   // todas as conexões da thread
+    struct Conexao *proxTocada;
+} Conexao;
+
+/* pedido completo à espera do lote; guarda deslocamento porque entrada pode ser realocada */
+typedef struct {
+    Conexao *c;
+    size_t ini;
+    size_t tam;
+} Pedido;
+
+typedef struct {
+    ServidorExpressoes *s;
+    int ep;
+    Arena arena;
+    Pedido *lote;
+    int nLote;
+    Conexao *conexoes;
+    Conexao *tocadas;
+    EstatisticasServidor est;  // escrito só pela thread; lido com __atomic
+    pthread_t thread;
+} Trabalhador;
+
+struct ServidorExpressoes {
+    ConfigServidor cfg;
+    char *caminhoUnix;  // cópia, para remover o arquivo no fim
+    int escuta;
+    int porta;
+    int parada[2];      // pipe: um byte em parada[1] acorda todas as threads
+    int nThreads;
+    Trabalhador *trab;
+};
+
+long aumentarLimiteDescritores(void) {
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) != 0) return -1;
+    if (lim.rlim_cur < lim.rlim_max) {
+        lim.rlim_cur = lim.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &lim) != 0) return -1;
+    }
+    return (long)lim.rlim_cur;
+}
+
+static void somar(unsigned long long *contador, unsigned long long v) {
+    __atomic_fetch_add(contador, v, __ATOMIC_RELAXED);
+}
+
+/* ---- escuta ---- */
+
+static int escutarUnix(ServidorExpressoes *s, const char *caminho) {
+    struct sockaddr_un end;
+    struct stat st;
+    int fd;
+    if (strlen(caminho) >= sizeof(end.sun_path)) return -1;
+    memset(&end, 0, sizeof(end));
+    end.sun_family = AF_UNIX;
+    strcpy(end.sun_path, caminho);
+
+    /* socket que sobrou de um servidor que já não existe: remove; se alguém atende, está em uso */
+    if (lstat(caminho, &st) == 0) {
+        int teste;
+        if (!S_ISSOCK(st.st_mode)) return -1;
+        teste = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (teste < 0) return -1;
+        if (connect(teste, (struct sockaddr*)&end, sizeof(end)) == 0) { close(teste); return -1; }
+        close(teste);
+        unlink(caminho);
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr*)&end, sizeof(end)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    s->caminhoUnix = strdup(caminho);
+    if (!s->caminhoUnix) { close(fd); unlink(caminho); return -1; }
+    return fd;
+}
+
+static int escutarTcp(ServidorExpressoes *s, int porta) {
+    struct sockaddr_in end;
+    socklen_t tam = sizeof(end);
+    int fd, um = 1;
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+    memset(&end, 0, sizeof(end));
+    end.sin_family = AF_INET;
+    end.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    end.sin_port = htons((unsigned short)porta);
+    if (bind(fd, (struct sockaddr*)&end, sizeof(end)) != 0 || listen(fd, SOMAXCONN) != 0 ||
+        getsockname(fd, (struct sockaddr*)&end, &tam) != 0) {
+        close(fd);
+        return -1;
+    }
+    s->porta = ntohs(end.sin_port);
+    return fd;
+}
+
+ServidorExpressoes *criarServidor(const ConfigServidor *cfg) {
+    ServidorExpressoes *s = (ServidorExpressoes*)calloc(1, sizeof(ServidorExpressoes));
+    struct epoll_event ev;
+    int i;
+    if (!s) return NULL;
+    s->cfg = *cfg;
+    s->cfg.caminhoUnix = NULL;
+    s->escuta = -1;
+    s->parada[0] = s->parada[1] = -1;
+    s->nThreads = (cfg->threads > 0) ? cfg->threads : nucleosDisponiveis();
+
+    aumentarLimiteDescritores();
+    s->escuta = cfg->caminhoUnix ? escutarUnix(s, cfg->caminhoUnix) : escutarTcp(s, cfg->porta);
+    if (s->escuta < 0 || pipe2(s->parada, O_NONBLOCK | O_CLOEXEC) != 0) goto erro;
+
+    s->trab = (Trabalhador*)calloc((size_t)s->nThreads, sizeof(Trabalhador));
+    if (!s->trab) goto erro;
+    for (i = 0; i < s->nThreads; ++i) s->trab[i].ep = -1;
+    for (i = 0; i < s->nThreads; ++i) {
+        Trabalhador *w = &s->trab[i];
+        w->s = s;
+        w->ep = epoll_create1(EPOLL_CLOEXEC);
+        if (w->ep < 0 || criarArena(&w->arena, TAM_ARENA) != 0) goto erro;
+        w->lote = (Pedido*)malloc(sizeof(Pedido) * (size_t)cfg->maxLote);
+        if (!w->lote) goto erro;
+        /* a escuta é de todas as threads; EPOLLEXCLUSIVE acorda uma só por conexão nova */
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+        ev.data.ptr = &s->escuta;
+        if (epoll_ctl(w->ep, EPOLL_CTL_ADD, s->escuta, &ev) != 0) goto erro;
+        ev.events = EPOLLIN;
+        ev.data.ptr = &s->parada;
+        if (epoll_ctl(w->ep, EPOLL_CTL_ADD, s->parada[0], &ev) != 0) goto erro;
+    }
+    return s;
+
+erro:
+    destruirServidor(s);
+    return NULL;
+}
+
+int portaServidor(const ServidorExpressoes *s) {
+    return s->porta;
+}
+
+void pararServidor(ServidorExpressoes *s) {
+    ssize_t r = write(s->parada[1], "x", 1);
+    (void)r; // se o pipe estiver cheio, o pedido de parada já está lá
+}
+
+/* ---- conexões ---- */
+
+static void tocar(Trabalhador *w, Conexao *c) {
+    if (c->tocada) return;
+    c->tocada = 1;
+    c->proxTocada = w->tocadas;
+    w->tocadas = c;
+}
+
+static void aceitar(Trabalhador *w) {
+    ServidorExpressoes *s = w->s;
+    int i;
+    for (i = 0; i < ACEITES_POR_VOLTA; ++i) {
+        struct epoll_event ev;
+        Conexao *c;
+        int fd = accept4(s->escuta, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN: outra thread levou; demais erros: tenta na próxima volta
+        if (!s->caminhoUnix) {
+            int um = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+        }
+        c = (Conexao*)calloc(1, sizeof(Conexao));
+        if (!c) { close(fd); return; }
+        c->fd = fd;
+        c->eventos = EPOLLIN;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (epoll_ctl(w->ep, EPOLL_CTL_ADD, fd, &ev) != 0) { close(fd); free(c); return; }
+        c->prox = w->conexoes;
+        if (w->conexoes) w->conexoes->ant = c;
+        w->conexoes = c;
+        somar(&w->est.conexoes, 1);
+    }
+}
+
+static void fecharConexao(Trabalhador *w, Conexao *c) {
+    close(c->fd); // também tira do epoll
+    if (c->ant) c->ant->prox = c->prox; else w->conexoes = c->prox;
+    if (c->prox) c->prox->ant = c->ant;
+    free(c->entrada);
+    free(c->saida);
+    free(c);
+}
+
+static int crescer(char **buf, size_t *cap, size_t minimo) {
+    size_t novo = *cap ? *cap : TAM_ENTRADA_INICIAL;
+    char *p;
+    if (minimo <= *cap) return 0;
+    while (novo < minimo) novo *= 2;
+    p = (char*)realloc(*buf, novo);
+    if (!p) return -1;
+    *buf = p;
+    *cap = novo;
+    return 0;
+}
+
+static unsigned lerTamanho(const char *p) {
+    unsigned n;
+    memcpy(&n, p, TAM_CABECALHO);
+    return ntohl(n);
+}
+
+static void gravarTamanho(char *p, size_t n) {
+    unsigned v = htonl((unsigned)n);
+    memcpy(p, &v, TAM_CABECALHO);
+}
+
+/* acrescenta a resposta de um pedido à saída da conexão */
+static void responder(Conexao *c, int status, const char *convertida, float valor) {
+    size_t n = (status == 0) ? strlen(convertida) : 4;
+    size_t ini = c->tamSaida;
+    int r = 0;
+    if (crescer(&c->saida, &c->capSaida, ini + TAM_CABECALHO + n + 1 + TAM_TEXTO_FLOAT) != 0) { c->fechar = 1; return; }
+    if (status == 0) {
+        memcpy(c->saida + ini + TAM_CABECALHO, convertida, n);
+        c->saida[ini + TAM_CABECALHO + n] = '\t';
+        r = 1 + formatarFloat(c->saida + ini + TAM_CABECALHO + n + 1, valor, 6);
+    } else {
+        memcpy(c->saida + ini + TAM_CABECALHO, "ERRO", 4);
+    }
+    gravarTamanho(c->saida + ini, n + (size_t)r);
+    c->tamSaida = ini + TAM_CABECALHO + n + (size_t)r;
+}
+
+static int avaliar(Trabalhador *w, const char *expr, size_t tam, const char **convertida, float *valor) {
+    int ehPos, r;
+    for (;;) {
+        size_t cap;
+        reiniciarArena(&w->arena);
+        r = processarExpressaoArena(expr, tam, &w->arena, convertida, valor, &ehPos);
+        if (r != -2) return r;
+        /* arena pequena para esta expressão: dobra e tenta de novo */
+        cap = w->arena.capacidade * 2;
+        if (cap < TAM_ARENA) cap = TAM_ARENA;
+        liberarArena(&w->arena);
+        if (criarArena(&w->arena, cap) != 0) {
+            inicializarArena(&w->arena, NULL, 0);
+            return -1;
+        }
+    }
+}
+
+/* avalia os pedidos juntados até aqui, na ordem em que chegaram */
+static void avaliarLote(Trabalhador *w) {
+    int i;
+    if (w->nLote == 0) return;
+    for (i = 0; i < w->nLote; ++i) {
+        Pedido *p = &w->lote[i];
+        const char *convertida = NULL;
+        float valor = 0.0f;
+        int r = avaliar(w, p->c->entrada + p->ini, p->tam, &convertida, &valor);
+        responder(p->c, r, convertida, valor);
+    }
+    somar(&w->est.pedidos, (unsigned long long)w->nLote);
+    somar(&w->est.lotes, 1);
+    if ((unsigned long long)w->nLote > w->est.maiorLote)
+        __atomic_store_n(&w->est.maiorLote, (unsigned long long)w->nLote, __ATOMIC_RELAXED);
+    w->nLote = 0;
+}
+
+/* uma leitura por volta; os quadros completos vão para o lote */
+static void lerConexao(Trabalhador *w, Conexao *c) {
+    size_t maxMensagem = w->s->cfg.maxMensagem;
+    ssize_t r;
+    if (c->tam == c->cap && crescer(&c->entrada, &c->cap, c->tam + 1) != 0) { c->fechar = 1; return; }
+    r = recv(c->fd, c->entrada + c->tam, c->cap - c->tam, 0);
+    if (r == 0) { c->fimEntrada = 1; return; }
+    if (r < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) c->fechar = 1;
+        return;
+    }
+    c->tam += (size_t)r;
+    somar(&w->est.bytesRecebidos, (unsigned long long)r);
+
+    while (c->tam - c->ini >= TAM_CABECALHO) {
+        size_t n = lerTamanho(c->entrada + c->ini);
+        if (n > maxMensagem) { c->fechar = 1; return; }
+        if (c->tam - c->ini - TAM_CABECALHO < n) {
+            /* quadro incompleto: garante espaço para ele inteiro */
+            if (crescer(&c->entrada, &c->cap, c->ini + TAM_CABECALHO + n) != 0) c->fechar = 1;
+            return;
+        }
+        w->lote[w->nLote].c = c;
+        w->lote[w->nLote].ini = c->ini + TAM_CABECALHO;
+        w->lote[w->nLote].tam = n;
+        c->ini += TAM_CABECALHO + n;
+        if (++w->nLote == w->s->cfg.maxLote) avaliarLote(w);
+    }
+}
+
+static void enviar(Trabalhador *w, Conexao *c) {
+    while (c->enviado < c->tamSaida) {
+        ssize_t r = send(c->fd, c->saida + c->enviado, c->tamSaida - c->enviado, MSG_NOSIGNAL);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) c->fechar = 1;
+            return;
+        }
+        c->enviado += (size_t)r;
+        somar(&w->est.bytesEnviados, (unsigned long long)r);
+    }
+    c->enviado = c->tamSaida = 0;
+}
+
+static void atualizarInteresse(Trabalhador *w, Conexao *c) {
+    size_t pendente = c->tamSaida - c->enviado;
+    unsigned eventos = 0;
+    if (pendente > 0) eventos |= EPOLLOUT;
+    if (!c->fimEntrada && pendente <= LIMITE_SAIDA) eventos |= EPOLLIN;
+    if (eventos != c->eventos) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = eventos;
+        ev.data.ptr = c;
+        if (epoll_ctl(w->ep, EPOLL_CTL_MOD, c->fd, &ev) != 0) c->fechar = 1;
+        c->eventos = eventos;
+    }
+}
+
+/* fim da volta: o lote já foi avaliado; grava as respostas e arruma cada conexão tocada */
+static void concluirVolta(Trabalhador *w) {
+    Conexao *c = w->tocadas, *prox;
+    w->tocadas = NULL;
+    for (; c; c = prox) {
+        prox = c->proxTocada;
+        c->tocada = 0;
+        if (c->ini > 0) {
+            memmove(c->entrada, c->entrada + c->ini, c->tam - c->ini);
+            c->tam -= c->ini;
+            c->ini = 0;
+        }
+        if (!c->fechar) enviar(w, c);
+        if (!c->fechar) atualizarInteresse(w, c);
+        if (c->fechar || (c->fimEntrada && c->tamSaida == 0)) fecharConexao(w, c);
+    }
+}
+
+static void *laco(void *arg) {
+    Trabalhador *w = (Trabalhador*)arg;
+    ServidorExpressoes *s = w->s;
+    struct epoll_event evs[MAX_EVENTOS];
+    for (;;) {
+        int n = epoll_wait(w->ep, evs, MAX_EVENTOS, -1), i;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (i = 0; i < n; ++i) {
+            void *p = evs[i].data.ptr;
+            if (p == &s->parada) return NULL;
+            if (p == &s->escuta) {
+                aceitar(w);
+            } else {
+                Conexao *c = (Conexao*)p;
+                tocar(w, c);
+                if (evs[i].events & EPOLLERR) c->fechar = 1;
+                else if ((evs[i].events & (EPOLLIN | EPOLLHUP)) && (c->eventos & EPOLLIN)) lerConexao(w, c);
+            }
+        }
+        avaliarLote(w);
+        concluirVolta(w);
+    }
+    return NULL;
+}
+
+int executarServidor(ServidorExpressoes *s) {
+    int i, criadas, ok = 1;
+    for (criadas = 1; criadas < s->nThreads; ++criadas) {
+        if (pthread_create(&s->trab[criadas].thread, NULL, laco, &s->trab[criadas]) != 0) {
+            pararServidor(s);
+            ok = 0;
+            break;
+        }
+    }
+    laco(&s->trab[0]);
+    for (i = 1; i < criadas; ++i) pthread_join(s->trab[i].thread, NULL);
+    return ok ? 0 : -1;
+}
+
+void destruirServidor(ServidorExpressoes *s) {
+    int i;
+    if (!s) return;
+    if (s->trab) {
+        for (i = 0; i < s->nThreads; ++i) {
+            Trabalhador *w = &s->trab[i];
+            while (w->conexoes) fecharConexao(w, w->conexoes);
+            if (w->ep >= 0) close(w->ep);
+            liberarArena(&w->arena);
+            free(w->lote);
+        }
+        free(s->trab);
+    }
+    if (s->escuta >= 0) close(s->escuta);
+    if (s->caminhoUnix) {
+        unlink(s->caminhoUnix);
+        free(s->caminhoUnix);
+    }
+    if (s->parada[0] >= 0) close(s->parada[0]);
+    if (s->parada[1] >= 0) close(s->parada[1]);
+    free(s);
+}
+
+void estatisticasServidor(ServidorExpressoes *s, EstatisticasServidor *est) {
+    int i;
+    memset(est, 0, sizeof(*est));
+    for (i = 0; i < s->nThreads; ++i) {
+        EstatisticasServidor *e = &s->trab[i].est;
+        unsigned long long maior = __atomic_load_n(&e->maiorLote, __ATOMIC_RELAXED);
+        est->conexoes += __atomic_load_n(&e->conexoes, __ATOMIC_RELAXED);
+        est->pedidos += __atomic_load_n(&e->pedidos, __ATOMIC_RELAXED);
+        est->lotes += __atomic_load_n(&e->lotes, __ATOMIC_RELAXED);
+        est->bytesRecebidos += __atomic_load_n(&e->bytesRecebidos, __ATOMIC_RELAXED);
+        est->bytesEnviados += __atomic_load_n(&e->bytesEnviados, __ATOMIC_RELAXED);
+        if (maior > est->maiorLote) est->maiorLote = maior;
+    }
+}
+
+#else /* sem epoll */
+
+ServidorExpressoes *criarServidor(const ConfigServidor *cfg) {
+    (void)cfg;
+    return NULL;
+}
+int portaServidor(const ServidorExpressoes *s) { (void)s; return 0; }
+int executarServidor(ServidorExpressoes *s) { (void)s; return -1; }
+void pararServidor(ServidorExpressoes *s) { (void)s; }
+void destruirServidor(ServidorExpressoes *s) { (void)s; }
+void estatisticasServidor(ServidorExpressoes *s, EstatisticasServidor *est) {
+    (void)s;
+    memset(est, 0, sizeof(*est));
+}
+long aumentarLimiteDescritores(void) { return -1; }
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef SERVIDOR_H
+#define SERVIDOR_H
+#include <stddef.h>
+
+/*
+ * Servidor local de expressões (só Linux: usa epoll). Escuta num socket
+ * Unix ou em TCP no 127.0.0.1 e fala um protocolo de quadros:
+ *   pedido    uint32 tamanho (ordem de rede) + expressão (sem '\0')
+ *   resposta  uint32 tamanho (ordem de rede) + "convertida<TAB>valor" ou "ERRO"
+ * com o mesmo texto de uma linha de --fluxo. Um cliente pode mandar vários
+ * pedidos sem esperar as respostas; elas voltam na ordem dos pedidos.
+ * Cada thread tem seu epoll e suas conexões. A cada volta ela lê tudo o que
+ * chegou, junta os pedidos completos de todas as conexões num lote, avalia
+ * o lote com processarExpressaoArena numa arena própria e só então grava as
+ * respostas, uma escrita por conexão. Quadro maior que maxMensagem fecha a
+ * conexão; quem não lê as respostas deixa de ser lido até esvaziar a saída.
+ */
+typedef struct ServidorExpressoes ServidorExpressoes;
+
+typedef struct {
+    const char *caminhoUnix; // socket Unix; NULL usa TCP no 127.0.0.1
+    int porta;               // TCP; 0 deixa o sistema escolher (ver portaServidor)
+    int threads;             // <= 0: um por núcleo
+    int maxLote;             // pedidos avaliados de uma vez em cada thread
+    size_t maxMensagem;      // maior expressão aceita, em bytes
+} ConfigServidor;
+
+typedef struct {
+    unsigned long long conexoes;  // aceitas desde a criação
+    unsigned long long pedidos;
+    unsigned long long lotes;
+    unsigned long long maiorLote;
+    unsigned long long bytesRecebidos;
+    unsigned long long bytesEnviados;
+} EstatisticasServidor;
+
+void configServidorPadrao(ConfigServidor *cfg);
+
+/* Lê "--opcao valor" de argv[0..argc) (ver main.c). Retorna 0 ou -1 se houver opção inválida. */
+int lerConfigServidor(int argc, char **argv, ConfigServidor *cfg);
+
+/* Abre o socket e começa a escutar. NULL em erro (endereço em uso, sem epoll...). */
+ServidorExpressoes *criarServidor(const ConfigServidor *cfg);
+int portaServidor(const ServidorExpressoes *s); // porta TCP em uso; 0 no socket Unix
+
+/* Atende até pararServidor; a thread que chama é uma das threads do servidor. Retorna 0 ou -1. */
+int executarServidor(ServidorExpressoes *s);
+
+/* Pede o fim de executarServidor. Pode ser chamada de outra thread ou de um tratador de sinal. */
+void pararServidor(ServidorExpressoes *s);
+
+/* Fecha tudo (e remove o socket Unix); só depois que executarServidor retornou */
+void destruirServidor(ServidorExpressoes *s);
+
+void estatisticasServidor(ServidorExpressoes *s, EstatisticasServidor *est);
+
+/* Sobe o limite de descritores abertos até o máximo permitido; retorna o novo limite ou -1 */
+long aumentarLimiteDescritores(void);
+#endif
@@ -0,0 +1,367 @@
+/* tokens.c - analisador léxico e conversão infixa -> pós-fixa sobre tokens */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <float.h>
+#include <locale.h>
+
+#include "expressao.h"
+#include "tokens.h"
+#include "funcoes.h"
+#include "estatisticas.h"
+
+void inicializarListaTokens(ListaTokens *lista){lista->itens=NULL;lista->quantidade=0;lista->capacidade=0;lista->arena=NULL;}
+void inicializarListaTokensArena(ListaTokens *lista, Arena *arena){inicializarListaTokens(lista);lista->arena=arena;}
+void liberarListaTokens(ListaTokens *lista){Arena *a;if(!lista)return;a=lista->arena;if(!a)free(lista->itens);inicializarListaTokensArena(lista,a);}
+
+static int acrescentarToken(ListaTokens *lista, const Token *t) {
+    if (lista->quantidade == lista->capacidade) {
+        int novaCap = lista->capacidade ? lista->capacidade * 2 : 16;
+        Token *novo;
+        if (lista->arena) {
+            /* o bloco antigo fica perdido na arena até o próximo reinício */
+            novo = (Token*)alocarArena(lista->arena, sizeof(Token) * (size_t)novaCap);
+            if (novo && lista->quantidade > 0) memcpy(novo, lista->itens, sizeof(Token) * (size_t)lista->quantidade);
+        } else {
+            novo = (Token*)realloc(lista->itens, sizeof(Token) * (size_t)novaCap);
+            EST_ALOCACAO(sizeof(Token) * (size_t)novaCap);
+        }
+        if (!novo) return -1;
+        lista->itens = novo;
+        lista->capacidade = novaCap;
+    }
+    lista->itens[lista->quantidade++] = *t;
+    return 0;
+}
+
+static int ehEspaco(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int ehCharOperador(char c) {
+    return c == '+' || c == '-' || c == '*' || c == '/' || c == '%' || c == '^';
+}
+
+/* potências exatas em double: 10^22 é a maior representável sem arredondamento */
+static const double potencias10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* caminho lento: strtod sobre uma cópia com o separador decimal do locale no lugar do '.' */
+static double converterComStrtod(const char *texto, int n) {
+    char local[96];
+    const char *ponto = localeconv()->decimal_point;
+    size_t tamPonto = (ponto && ponto[0]) ? strlen(ponto) : 1;
+    size_t cap = (size_t)n + tamPonto + 1, w = 0;
+    char *buf = local;
+    double v;
+    int i;
+    if (cap > sizeof(local)) {
+        buf = (char*)malloc(cap);
+        if (!buf) return 0.0;
+        EST_ALOCACAO(cap);
+    }
+    for (i = 0; i < n; ++i) {
+        if (texto[i] == '.' && ponto && ponto[0]) {
+            memcpy(buf + w, ponto, tamPonto);
+            w += tamPonto;
+        } else {
+            buf[w++] = texto[i];
+        }
+    }
+    buf[w] = '\0';
+    v = strtod(buf, NULL);
+    if (buf != local) free(buf);
+    return v;
+}
+
+int lerNumero(const char *texto, size_t tam, double *valor) {
+    unsigned long long m = 0;
+    int significativos = 0, pontos = 0, digitos = 0, excesso = 0;
+    long exp10 = 0;
+    size_t i = 0;
+    while (i < tam && (isdigit((unsigned char)texto[i]) || texto[i] == '.')) {
+        char c = texto[i++];
+        if (c == '.') { ++pontos; continue; }
+        ++digitos;
+        if (m == 0 && c == '0') {
+            if (pontos) --exp10; /* zeros à esquerda da fração só deslocam a escala */
+            continue;
+        }
+        if (significativos < 19) {
+            m = m * 10 + (unsigned long long)(c - '0');
+            ++significativos;
+            if (pontos) --exp10;
+        } else {
+            excesso = 1; /* não cabe no caminho rápido */
+            if (!pontos) ++exp10;
+        }
+    }
+    if (digitos == 0 || pontos > 1) return 0;
+
+    /* expoente só conta se houver ao menos um dígito depois de e/E e do sinal */
+    if (i < tam && (texto[i] == 'e' || texto[i] == 'E')) {
+        size_t j = i + 1;
+        int negativo = 0;
+        long e = 0;
+        if (j < tam && (texto[j] == '+' || texto[j] == '-')) negativo = (texto[j++] == '-');
+        if (j < tam && isdigit((unsigned char)texto[j])) {
+            while (j < tam && isdigit((unsigned char)texto[j])) {
+                if (e < 100000) e = e * 10 + (texto[j] - '0');
+                ++j;
+            }
+            exp10 += negativo ? -e : e;
+            i = j;
+        }
+    }
+    if (i < tam && texto[i] == '.') return 0; /* "1e5.2" */
+    if (i > (size_t)INT_MAX) return 0;
+
+    if (valor) {
+/* 16: float e double sem precisão extra (só _Float16 é promovido), como em 0 */
+#if FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 16
+        /* Clinger: mantissa exata em double e uma única operação com potência exata
+           dão o resultado corretamente arredondado */
+        if (m == 0) *valor = 0.0;
+        else if (!excesso && m <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22)
+            *valor = exp10 < 0 ? (double)m / potencias10[-exp10] : (double)m * potencias10[exp10];
+        else
+#endif
+            *valor = converterComStrtod(texto, (int)i);
+    }
+    return (int)i;
+}
+
+int lerInteiro(const char *texto, size_t tam, long long *valor) {
+    long long v = 0;
+    size_t i = 0;
+    int negativo = 0, digitos = 0;
+    if (i < tam && texto[i] == '-') { negativo = 1; ++i; }
+    /* acumula em negativo, que alcança LLONG_MIN */
+    for (; i < tam && isdigit((unsigned char)texto[i]); ++i, ++digitos) {
+        if (__builtin_mul_overflow(v, 10LL, &v) || __builtin_sub_overflow(v, (long long)(texto[i] - '0'), &v)) return -1;
+    }
+    if (i < tam && texto[i] == '.') {
+        for (++i; i < tam && texto[i] == '0'; ++i) ++digitos;
+    }
+    if (i != tam || digitos == 0) return -1;
+    if (!negativo && __builtin_sub_overflow(0LL, v, &v)) return -1;
+    *valor = v;
+    return 0;
+}
+
+int literaisInteiros(const char *texto, const Token *toks, int n) {
+    long long v;
+    int i;
+    for (i = 0; i < n; ++i) {
+        if (toks[i].tipo == TOK_FUNCAO || toks[i].tipo == TOK_NOME) return 0;
+        if (toks[i].tipo == TOK_NUMERO && lerInteiro(texto + toks[i].inicio, (size_t)toks[i].tam, &v) != 0) return 0;
+    }
+    return 1;
+}
+
+/*
+ * Regras iguais às de normalizarInfixa: nomes são sequências alfanuméricas
+ * iniciadas por letra, '-' colado a um número é sinal quando vem no início,
+ * depois de '(' ou de outro operador. Quando vem depois de um valor mas
+ * separado por espaço ("3 -4 +"), o token fica marcado como ambiguo: na
+ * pós-fixa ele é um número negativo, na infixa vira '-' binário.
+ */
+static int tokenizar(const char *texto, size_t tam, ListaTokens *lista) {
+    size_t i = 0;
+    int depoisDeEspaco = 1;
+    while (i < tam) {
+        char c = texto[i];
+        Token t;
+        if (ehEspaco(c)) { ++i; depoisDeEspaco = 1; continue; }
+        memset(&t, 0, sizeof(t));
+        t.inicio = (int)i;
+        if (isalpha((unsigned char)c) || c == '_') {
+            size_t j = i;
+            while (j < tam && (isalnum((unsigned char)texto[j]) || texto[j] == '_')) ++j;
+            t.tam = (int)(j - i);
+            t.funcao = (short)idFuncao(texto + i, t.tam);
+            t.tipo = (t.funcao >= 0) ? TOK_FUNCAO : TOK_NOME;
+        } else if (isdigit((unsigned char)c) || c == '.') {
+            t.tam = lerNumero(texto + i, tam - i, &t.valor);
+            if (t.tam == 0) return -1;
+            t.tipo = TOK_NUMERO;
+        } else if (ehCharOperador(c)) {
+            const Token *ult = lista->quantidade ? &lista->itens[lista->quantidade - 1] : NULL;
+            int sinal = 0;
+            if (c == '-' && i + 1 < tam && (isdigit((unsigned char)texto[i+1]) || texto[i+1] == '.')) {
+                if (!ult || ult->tipo == TOK_ABRE || ult->tipo == TOK_OPERADOR || ult->tipo == TOK_VIRGULA) sinal = 1;
+                else if (depoisDeEspaco) sinal = 2;
+            }
+            if (sinal) {
+                int n = lerNumero(texto + i + 1, tam - i - 1, &t.valor);
+                if (n == 0) return -1;
+                t.tipo = TOK_NUMERO;
+                t.tam = n + 1;
+                t.ambiguo = (unsigned char)(sinal == 2);
+                t.valor = -t.valor;
+            } else {
+                t.tipo = TOK_OPERADOR;
+                t.op = c;
+                t.tam = 1;
+            }
+        } else if (c == '(' || c == ')' || c == ',') {
+            t.tipo = (c == '(') ? TOK_ABRE : (c == ')') ? TOK_FECHA : TOK_VIRGULA;
+            t.tam = 1;
+        } else {
+            return -1;
+        }
+        if (acrescentarToken(lista, &t) != 0) return -1;
+        i += (size_t)t.tam;
+        depoisDeEspaco = 0;
+    }
+    return 0;
+}
+
+int tokenizarExpressao(const char *texto, size_t tam, ListaTokens *lista) {
+    int antes, r;
+    EST_INICIO(t0);
+    if (!texto || !lista || tam > (size_t)INT_MAX) return -1; /* posições dos tokens são int */
+    antes = lista->quantidade;
+    r = tokenizar(texto, tam, lista);
+    EST_FIM(ESTAGIO_TOKENIZAR, t0);
+    EST_TOKENS(lista->quantidade - antes);
+    return r;
+}
+
+static int validarPosfixa(const Token *toks, int n) {
+    int contador = 0;
+    int i;
+    if (!toks || n <= 0) return 0;
+    for (i = 0; i < n; ++i) {
+        switch (toks[i].tipo) {
+            case TOK_NUMERO:
+            case TOK_NOME:
+                contador++;
+                break;
+            case TOK_FUNCAO: {
+                int aridade = aridadeFuncao(toks[i].funcao);
+                if (aridade < 1 || contador < aridade) return 0;
+                contador -= aridade - 1;
+            } break;
+            case TOK_OPERADOR:
+                if (contador < 2) return 0;
+                contador -= 1;
+                break;
+            default:
+                return 0;
+        }
+    }
+    return contador == 1;
+}
+
+int ehPosfixaTokens(const Token *toks, int n) {
+    int r;
+    EST_INICIO(t0);
+    r = validarPosfixa(toks, n);
+    EST_FIM(ESTAGIO_DETECTAR, t0);
+    return r;
+}
+
+int precedenciaOperador(char op) {
+    if (op == '+' || op == '-') return 1;
+    if (op == '*' || op == '/' || op == '%') return 2;
+    if (op == '^') return 3;
+    return 0;
+}
+
+static void liberarPilhaOp(const ListaTokens *saida, Token *pilhaOp) {
+    if (!saida->arena) free(pilhaOp);
+}
+
+/* Mesmo algoritmo de infixaParaPosfixaInterna: parênteses sem par são repassados à saída */
+static int converterParaPosfixa(const Token *toks, int n, ListaTokens *saida) {
+    Token *pilhaOp;
+    int topo = 0;
+    int anteriorValor = 0;
+    int i;
+    if (saida->arena) pilhaOp = (Token*)alocarArena(saida->arena, sizeof(Token) * (size_t)(n > 0 ? n : 1));
+    else {
+        pilhaOp = (Token*)malloc(sizeof(Token) * (size_t)(n > 0 ? n : 1));
+        EST_ALOCACAO(sizeof(Token) * (size_t)(n > 0 ? n : 1));
+    }
+    if (!pilhaOp) return -1;
+
+    for (i = 0; i < n; ++i) {
+        Token t = toks[i];
+        if (t.tipo == TOK_NUMERO && t.ambiguo && anteriorValor) {
+            /* "a -4" na infixa: '-' binário seguido de 4 */
+            Token menos;
+            memset(&menos, 0, sizeof(menos));
+            menos.tipo = TOK_OPERADOR;
+            menos.op = '-';
+            menos.inicio = t.inicio;
+            menos.tam = 1;
+            while (topo > 0 && pilhaOp[topo-1].tipo == TOK_OPERADOR &&
+                   precedenciaOperador(pilhaOp[topo-1].op) >= 1) {
+                if (acrescentarToken(saida, &pilhaOp[--topo]) != 0) { liberarPilhaOp(saida, pilhaOp); return -1; }
+            }
+            pilhaOp[topo++] = menos;
+            EST_PICO_OP(topo);
+            t.inicio += 1;
+            t.tam -= 1;
+            t.valor = -t.valor;
+            t.ambiguo = 0;
+        }
+        if (t.tipo == TOK_NUMERO || t.tipo == TOK_NOME) {
+            if (acrescentarToken(saida, &t) != 0) { liberarPilhaOp(saida, pilhaOp); return -1; }
+            anteriorValor = 1;
+            continue;
+        }
+        anteriorValor = 0;
+        if (t.tipo == TOK_FUNCAO || t.tipo == TOK_ABRE) {
+            pilhaOp[topo++] = t;
+            EST_PICO_OP(topo);
+        } else if (t.tipo == TOK_FECHA) {
+            while (topo > 0 && pilhaOp[topo-1].tipo != TOK_ABRE) {
+                if (acrescentarToken(saida, &pilhaOp[--topo]) != 0) { liberarPilhaOp(saida, pilhaOp); return -1; }
+            }
+            if (topo > 0) --topo; /* remove "(" */
+            if (topo > 0 && pilhaOp[topo-1].tipo == TOK_FUNCAO) {
+                if (acrescentarToken(saida, &pilhaOp[--topo]) != 0) { liberarPilhaOp(saida, pilhaOp); return -1; }
+            }
+            anteriorValor = 1;
+        } else if (t.tipo == TOK_VIRGULA) {
+            /* separa argumentos: fecha o argumento anterior até o "(" da função */
+            while (topo > 0 && pilhaOp[topo-1].tipo != TOK_ABRE) {
+                if (acrescentarToken(saida, &pilhaOp[--topo]) != 0) { liberarPilhaOp(saida, pilhaOp); return -1; }
+            }
+        } else {
+            int prec = precedenciaOperador(t.op);
+            int right_assoc = (t.op == '^');
+            while (topo > 0 && pilhaOp[topo-1].tipo == TOK_OPERADOR) {
+                int precTop = precedenciaOperador(pilhaOp[topo-1].op);
+                if (precTop > prec || (precTop == prec && !right_assoc)) {
+                    if (acrescentarToken(saida, &pilhaOp[--topo]) != 0) { liberarPilhaOp(saida, pilhaOp); return -1; }
+                    continue;
+                }
+                break;
+            }
+            pilhaOp[topo++] = t;
+            EST_PICO_OP(topo);
+        }
+    }
+
+    while (topo > 0) {
+        if (acrescentarToken(saida, &pilhaOp[--topo]) != 0) { liberarPilhaOp(saida, pilhaOp); return -1; }
+    }
+    liberarPilhaOp(saida, pilhaOp);
+    return 0;
+}
+
+int infixaParaPosfixaTokens(const Token *toks, int n, ListaTokens *saida) {
+    int r;
+    EST_INICIO(t0);
+    if (!toks || !saida) return -1;
+    r = converterParaPosfixa(toks, n, saida);
+    EST_FIM(ESTAGIO_INFIXA_POSFIXA, t0);
+    return r;
+}
@@ -0,0 +1,69 @@
+#ifndef TOKENS_H
+#define TOKENS_H
+#include <stddef.h>
+#include "arena.h"
+
+/* Tipos de token produzidos pelo analisador léxico */
+typedef enum {
+    TOK_NUMERO,   // literal numérico, valor já convertido
+    TOK_OPERADOR, // + - * / % ^
+    TOK_FUNCAO,   // função do registro (funcoes.h), id já resolvido
+    TOK_NOME,     // identificador que não é função (variável)
+    TOK_ABRE,     // (
+    TOK_FECHA,    // )
+    TOK_VIRGULA   // , entre argumentos de função
+} TipoToken;
+
+typedef struct {
+    unsigned char tipo;    // TipoToken
+    char op;               // caractere do operador (TOK_OPERADOR)
+    unsigned char ambiguo; // "-num" colado que pode ser '-' binário (ver tokenizarExpressao)
+    short funcao;          // id da função (TOK_FUNCAO)
+    int inicio;            // posição do token no texto de origem
+    int tam;               // quantidade de caracteres do token no texto
+    double valor;          // valor do literal (TOK_NUMERO)
+} Token;
+
+typedef struct {
+    Token *itens;
+    int quantidade;
+    int capacidade;
+    Arena *arena; // se não for NULL, a lista cresce dentro da arena (sem malloc)
+} ListaTokens;
+
+void inicializarListaTokens(ListaTokens *lista);
+void inicializarListaTokensArena(ListaTokens *lista, Arena *arena);
+void liberarListaTokens(ListaTokens *lista);
+
+/* Quebra texto[0..tam) em tokens (acrescentando em lista). Retorna 0 ou -1 se houver caractere inválido. */
+int tokenizarExpressao(const char *texto, size_t tam, ListaTokens *lista);
+
+/*
+ * Lê o literal numérico no início de texto[0..tam) numa só passada: dígitos
+ * com no máximo um ponto (".5" vale), seguidos de expoente opcional
+ * ("1e-3", "2E+5"). Não depende do locale e o valor sai corretamente
+ * arredondado. Grava o valor em *valor (se não for NULL) e retorna quantos
+ * caracteres foram consumidos, ou 0 se não houver literal válido.
+ */
+int lerNumero(const char *texto, size_t tam, double *valor);
+
+/*
+ * Lê texto[0..tam) inteiro como literal inteiro, direto do texto e sem
+ * passar por double: '-' opcional, dígitos e, se houver ponto, só zeros
+ * depois dele ("3.00"). Retorna 0 com o valor exato em *valor, ou -1 se
+ * houver expoente, fração ou se o valor não couber em long long.
+ */
+int lerInteiro(const char *texto, size_t tam, long long *valor);
+
+/* 1 se os literais de toks (no texto de origem) são todos inteiros por lerInteiro e não há funções nem nomes */
+int literaisInteiros(const char *texto, const Token *toks, int n);
+
+/* 1 se a sequência de tokens é uma pós-fixa válida (sem parênteses, pilha termina com 1 valor) */
+int ehPosfixaTokens(const Token *toks, int n);
+
+/* Shunting-yard sobre tokens: acrescenta em saida os tokens de entrada na ordem pós-fixa.
+   A pilha de operadores vem da arena de saida, se houver. Retorna 0 ou -1. */
+int infixaParaPosfixaTokens(const Token *toks, int n, ListaTokens *saida);
+
+int precedenciaOperador(char op);
+#endif
@@ -0,0 +1,89 @@
+/* varredura.c - máscaras de classes de caractere por bloco de 64 bytes */
+
+#include <string.h>
+
+#include "varredura.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LARGURA_BYTES 32
+typedef __m256i VetorB;
+#define VB_CARREGAR(p) _mm256_loadu_si256((const __m256i*)(p))
+#define VB_CONST(c) _mm256_set1_epi8((char)(c))
+#define VB_IGUAL(a, b) _mm256_cmpeq_epi8((a), (b))
+#define VB_MAIOR(a, b) _mm256_cmpgt_epi8((a), (b))
+#define VB_OU(a, b) _mm256_or_si256((a), (b))
+#define VB_E(a, b) _mm256_and_si256((a), (b))
+#define VB_MASCARA(a) ((unsigned long long)(unsigned)_mm256_movemask_epi8(a))
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LARGURA_BYTES 16
+typedef __m128i VetorB;
+#define VB_CARREGAR(p) _mm_loadu_si128((const __m128i*)(p))
+#define VB_CONST(c) _mm_set1_epi8((char)(c))
+#define VB_IGUAL(a, b) _mm_cmpeq_epi8((a), (b))
+#define VB_MAIOR(a, b) _mm_cmpgt_epi8((a), (b))
+#define VB_OU(a, b) _mm_or_si128((a), (b))
+#define VB_E(a, b) _mm_and_si128((a), (b))
+#define VB_MASCARA(a) ((unsigned long long)(unsigned)_mm_movemask_epi8(a))
+#endif
+
+#ifdef LARGURA_BYTES
+/* lo <= x <= hi, com lo e hi abaixo de 127; a comparação é com sinal, então bytes >= 0x80 ficam fora */
+#define VB_ENTRE(x, lo, hi) VB_E(VB_MAIOR((x), VB_CONST((lo) - 1)), VB_MAIOR(VB_CONST((hi) + 1), (x)))
+
+static void classificar(const char *p, ClassesBloco *c) {
+    unsigned long long espaco = 0, palavra = 0, digito = 0, ponto = 0, simbolo = 0;
+    int k;
+    for (k = 0; k < TAM_BLOCO_VARREDURA; k += LARGURA_BYTES) {
+        VetorB x = VB_CARREGAR(p + k);
+        VetorB vEspaco = VB_OU(VB_OU(VB_IGUAL(x, VB_CONST(' ')), VB_IGUAL(x, VB_CONST('\t'))),
+                               VB_OU(VB_IGUAL(x, VB_CONST('\n')), VB_IGUAL(x, VB_CONST('\r'))));
+        VetorB vDigito = VB_ENTRE(x, '0', '9');
+        VetorB vPalavra = VB_OU(VB_OU(VB_ENTRE(VB_OU(x, VB_CONST(0x20)), 'a', 'z'), VB_IGUAL(x, VB_CONST('_'))), vDigito);
+        /* ( ) * + , - vêm seguidos na tabela ASCII */
+        VetorB vSimbolo = VB_OU(VB_OU(VB_ENTRE(x, '(', '-'), VB_IGUAL(x, VB_CONST('%'))),
+                                VB_OU(VB_IGUAL(x, VB_CONST('/')), VB_IGUAL(x, VB_CONST('^'))));
+        espaco |= VB_MASCARA(vEspaco) << k;
+        palavra |= VB_MASCARA(vPalavra) << k;
+        digito |= VB_MASCARA(vDigito) << k;
+        ponto |= VB_MASCARA(VB_IGUAL(x, VB_CONST('.'))) << k;
+        simbolo |= VB_MASCARA(vSimbolo) << k;
+    }
+    c->espaco = espaco;
+    c->palavra = palavra;
+    c->digito = digito;
+    c->ponto = ponto;
+    c->simbolo = simbolo;
+}
+#else
+static void classificar(const char *p, ClassesBloco *c) {
+    int k;
+    memset(c, 0, sizeof(*c));
+    for (k = 0; k < TAM_BLOCO_VARREDURA; ++k) {
+        unsigned char ch = (unsigned char)p[k];
+        unsigned long long bit = 1ULL << k;
+        unsigned char m = (unsigned char)(ch | 0x20);
+        if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') c->espaco |= bit;
+        if (ch >= '0' && ch <= '9') {
+            c->digito |= bit;
+            c->palavra |= bit;
+        } else if (ch == '.') {
+            c->ponto |= bit;
+        } else if ((m >= 'a' && m <= 'z') || ch == '_') c->palavra |= bit;
+        else if ((ch >= '(' && ch <= '-') || ch == '%' || ch == '/' || ch == '^') c->simbolo |= bit;
+    }
+}
+#endif
+
+void classificarBloco(const char *texto, size_t n, ClassesBloco *c) {
+    char resto[TAM_BLOCO_VARREDURA];
+    if (n >= TAM_BLOCO_VARREDURA) {
+        classificar(texto, c);
+        return;
+    }
+    /* bloco final: copia para não ler além do texto; os zeros não entram em classe alguma */
+    memset(resto, 0, sizeof(resto));
+    memcpy(resto, texto, n);
+    classificar(resto, c);
+}
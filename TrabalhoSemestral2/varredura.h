@@ -0,0 +1,45 @@
+#ifndef VARREDURA_H
+#define VARREDURA_H
+#include <stddef.h>
+
+/*
+ * Classes de caractere de um bloco de até 64 bytes de texto, um bit por
+ * byte (bit k = texto[k]), calculadas com SSE2 (16 bytes por passo), AVX2
+ * (32) ou byte a byte, conforme o que o compilador habilita. Com as
+ * máscaras, pular espaços ou achar o fim de um nome é contar zeros em vez
+ * de testar caractere por caractere. Posições além de n têm todos os bits
+ * zerados (contam como caractere inválido).
+ */
+#define TAM_BLOCO_VARREDURA 64
+
+typedef struct {
+    unsigned long long espaco;   // ' ', '\t', '\r', '\n'
+    unsigned long long palavra;  // letra, dígito ou '_' (continuação de nome)
+    unsigned long long digito;   // '0'..'9'
+    unsigned long long ponto;    // '.'
+    unsigned long long simbolo;  // operador (+ - * / % ^), parêntese ou vírgula
+} ClassesBloco;
+
+void classificarBloco(const char *texto, size_t n, ClassesBloco *c);
+
+/* índice do bit 1 mais baixo; x != 0 */
+static inline int primeiroBit(unsigned long long x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int k = 0;
+    while (!(x & 1)) { x >>= 1; ++k; }
+    return k;
+#endif
+}
+
+static inline int contarBits(unsigned long long x) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int k = 0;
+    for (; x; x &= x - 1) ++k;
+    return k;
+#endif
+}
+#endif
@@ -0,0 +1,128 @@
+#ifndef VETOR_H
+#define VETOR_H
+
+/*
+ * Operações sobre um vetor de LARGURA floats, com AVX-512 (16), AVX2 (8)
+ * ou escalar (1), conforme o que o compilador habilita. VetorI tem os
+ * inteiros de 32 bits de cada posição e VetorD metade das posições em
+ * double (VD_BAIXO/VD_ALTO convertem cada metade; no escalar as duas são
+ * o próprio valor). Usado por lote.c e matematica.c.
+ */
+
+#include <stdint.h>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX512F__)
+#define LARGURA 16
+typedef __m512 VetorF;
+typedef __m512i VetorI;
+typedef __m512d VetorD;
+#define V_CARREGAR(p) _mm512_loadu_ps(p)
+#define V_GUARDAR(p, v) _mm512_storeu_ps((p), (v))
+#define V_CONST(c) _mm512_set1_ps(c)
+#define V_SOMA(a, b) _mm512_add_ps((a), (b))
+#define V_SUB(a, b) _mm512_sub_ps((a), (b))
+#define V_MUL(a, b) _mm512_mul_ps((a), (b))
+#define V_DIV(a, b) _mm512_div_ps((a), (b))
+#define V_ARRED(a) _mm512_roundscale_ps((a), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define V_INV_RAIZ(a) _mm512_rsqrt14_ps(a)
+#define V_BITS(a) _mm512_castps_si512(a)
+#define V_DE_BITS(v) _mm512_castsi512_ps(v)
+#define V_NEGAR(a) V_DE_BITS(_mm512_xor_si512(V_BITS(a), VI_CONST(INT32_MIN)))
+#define V_PARA_INT(a) _mm512_cvtps_epi32(a)
+#define V_DE_INT(i) _mm512_cvtepi32_ps(i)
+/* máscara (bit k = posição k) das posições fora de [lo, hi]; NaN conta como fora */
+#define V_FORA(a, lo, hi) ((int)(unsigned short)~(_mm512_cmp_ps_mask((a), V_CONST(lo), _CMP_GE_OQ) & \
+                                                   _mm512_cmp_ps_mask((a), V_CONST(hi), _CMP_LE_OQ)))
+/* b nas posições em que (i & bit) != 0, a nas demais */
+#define V_ESCOLHER_BIT(i, bit, a, b) _mm512_mask_blend_ps(_mm512_test_epi32_mask((i), VI_CONST(bit)), (a), (b))
+#define VI_CONST(c) _mm512_set1_epi32(c)
+#define VI_SOMA(a, b) _mm512_add_epi32((a), (b))
+#define VI_SUB(a, b) _mm512_sub_epi32((a), (b))
+#define VI_SHL(a, n) _mm512_slli_epi32((a), (n))
+#define VI_SHR(a, n) _mm512_srai_epi32((a), (n))
+#define VD_CONST(c) _mm512_set1_pd(c)
+#define VD_SOMA(a, b) _mm512_add_pd((a), (b))
+#define VD_SUB(a, b) _mm512_sub_pd((a), (b))
+#define VD_MUL(a, b) _mm512_mul_pd((a), (b))
+#define VD_DIV(a, b) _mm512_div_pd((a), (b))
+#define VD_BAIXO(a) _mm512_cvtps_pd(_mm512_castps512_ps256(a))
+#define VD_ALTO(a) _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1)))
+#define V_DE_VD(baixo, alto) _mm512_castpd_ps(_mm512_insertf64x4( \
+    _mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(baixo))), _mm256_castps_pd(_mm512_cvtpd_ps(alto)), 1))
+#elif defined(__AVX2__)
+#define LARGURA 8
+typedef __m256 VetorF;
+typedef __m256i VetorI;
+typedef __m256d VetorD;
+#define V_CARREGAR(p) _mm256_loadu_ps(p)
+#define V_GUARDAR(p, v) _mm256_storeu_ps((p), (v))
+#define V_CONST(c) _mm256_set1_ps(c)
+#define V_SOMA(a, b) _mm256_add_ps((a), (b))
+#define V_SUB(a, b) _mm256_sub_ps((a), (b))
+#define V_MUL(a, b) _mm256_mul_ps((a), (b))
+#define V_DIV(a, b) _mm256_div_ps((a), (b))
+#define V_ARRED(a) _mm256_round_ps((a), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+#define V_INV_RAIZ(a) _mm256_rsqrt_ps(a)
+#define V_BITS(a) _mm256_castps_si256(a)
+#define V_DE_BITS(v) _mm256_castsi256_ps(v)
+#define V_NEGAR(a) _mm256_xor_ps((a), V_CONST(-0.0f))
+#define V_PARA_INT(a) _mm256_cvtps_epi32(a)
+#define V_DE_INT(i) _mm256_cvtepi32_ps(i)
+#define V_FORA(a, lo, hi) (~_mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps((a), V_CONST(lo), _CMP_GE_OQ), \
+                                                             _mm256_cmp_ps((a), V_CONST(hi), _CMP_LE_OQ))) & 0xFF)
+#define V_ESCOLHER_BIT(i, bit, a, b) _mm256_blendv_ps((a), (b), \
+    _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256((i), VI_CONST(bit)), VI_CONST(bit))))
+#define VI_CONST(c) _mm256_set1_epi32(c)
+#define VI_SOMA(a, b) _mm256_add_epi32((a), (b))
+#define VI_SUB(a, b) _mm256_sub_epi32((a), (b))
+#define VI_SHL(a, n) _mm256_slli_epi32((a), (n))
+#define VI_SHR(a, n) _mm256_srai_epi32((a), (n))
+#define VD_CONST(c) _mm256_set1_pd(c)
+#define VD_SOMA(a, b) _mm256_add_pd((a), (b))
+#define VD_SUB(a, b) _mm256_sub_pd((a), (b))
+#define VD_MUL(a, b) _mm256_mul_pd((a), (b))
+#define VD_DIV(a, b) _mm256_div_pd((a), (b))
+#define VD_BAIXO(a) _mm256_cvtps_pd(_mm256_castps256_ps128(a))
+#define VD_ALTO(a) _mm256_cvtps_pd(_mm256_extractf128_ps((a), 1))
+#define V_DE_VD(baixo, alto) _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(baixo)), _mm256_cvtpd_ps(alto), 1)
+#else
+#include <math.h>
+#define LARGURA 1
+typedef float VetorF;
+typedef int32_t VetorI;
+typedef double VetorD;
+#define V_CARREGAR(p) (*(p))
+#define V_GUARDAR(p, v) (*(p) = (v))
+#define V_CONST(c) ((float)(c))
+#define V_SOMA(a, b) ((a) + (b))
+#define V_SUB(a, b) ((a) - (b))
+#define V_MUL(a, b) ((a) * (b))
+#define V_DIV(a, b) ((a) / (b))
+#define V_ARRED(a) rintf(a)
+#define V_INV_RAIZ(a) (1.0f / sqrtf(a))
+#define V_BITS(a) (((union { float f; int32_t i; }){ (a) }).i)
+#define V_DE_BITS(v) (((union { int32_t i; float f; }){ (v) }).f)
+#define V_NEGAR(a) (-(a))
+#define V_PARA_INT(a) ((int32_t)(a))
+#define V_DE_INT(i) ((float)(i))
+#define V_FORA(a, lo, hi) (!((a) >= (lo) && (a) <= (hi)))
+#define V_ESCOLHER_BIT(i, bit, a, b) (((i) & (bit)) ? (b) : (a))
+#define VI_CONST(c) ((int32_t)(c))
+#define VI_SOMA(a, b) ((int32_t)((uint32_t)(a) + (uint32_t)(b))) // como no SIMD, sem estouro com sinal
+#define VI_SUB(a, b) ((int32_t)((uint32_t)(a) - (uint32_t)(b)))
+#define VI_SHL(a, n) ((int32_t)((uint32_t)(a) << (n)))
+#define VI_SHR(a, n) ((a) >> (n))
+#define VD_CONST(c) ((double)(c))
+#define VD_SOMA(a, b) ((a) + (b))
+#define VD_SUB(a, b) ((a) - (b))
+#define VD_MUL(a, b) ((a) * (b))
+#define VD_DIV(a, b) ((a) / (b))
+#define VD_BAIXO(a) ((double)(a))
+#define VD_ALTO(a) ((double)(a))
+#define V_DE_VD(baixo, alto) ((void)sizeof(alto), (float)(baixo)) // sizeof não calcula a metade que não existe
+#endif
+#endif